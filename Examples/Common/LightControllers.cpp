@@ -246,14 +246,14 @@ void LightProcess::Process(const double deltaSeconds) {
     }
 }
 
-void LightProcess::EntitiesAdded(const std::unordered_set<stratus::EntityPtr>& e) {
+void LightProcess::EntitiesAdded(const stratus::EntityList& e) {
     for (auto entity : e) {
         if ( !EntityIsRelevant(entity) ) continue;
         ConvertHandlerToLightDelete(input)->entities.push_back(entity);
     }
 }
 
-void LightProcess::EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>& e) {
+void LightProcess::EntitiesRemoved(const stratus::EntityList& e) {
     for (auto entity : e) {
         if ( !EntityIsRelevant(entity) ) continue;
         auto lightDelete = ConvertHandlerToLightDelete(input);
@@ -265,11 +265,11 @@ void LightProcess::EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>&
     }
 }
 
-void LightProcess::EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent*>>& added) {
+void LightProcess::EntityComponentsAdded(const stratus::EntityComponentsAddedList& added) {
     // Do nothing
 }
 
-void LightProcess::EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>& changed) {
+void LightProcess::EntityComponentsEnabledDisabled(const stratus::EntityList& changed) {
     // Do nothing
 }
 
@@ -294,7 +294,20 @@ void RandomLightMoverProcess::Process(const double deltaSeconds) {
     }
 }
 
-void RandomLightMoverProcess::EntitiesAdded(const std::unordered_set<stratus::EntityPtr>& e) {
+stratus::EntityComponentSignature RandomLightMoverProcess::RequiredComponents() const {
+    return stratus::MakeEntityComponentSignature<RandomLightMoverComponent, LightComponent, LightCubeComponent>();
+}
+
+// Only touches the lights/cubes it owns so it can run alongside other processes
+stratus::EntityProcessAccess RandomLightMoverProcess::ComponentAccess() const {
+    return stratus::EntityProcessAccess(
+        stratus::MakeEntityComponentSignature<LightCubeComponent>(),
+        // Moves the light and its cube's local transform
+        stratus::MakeEntityComponentSignature<RandomLightMoverComponent, LightComponent, stratus::LocalTransformComponent>()
+    );
+}
+
+void RandomLightMoverProcess::EntitiesAdded(const stratus::EntityList& e) {
     for (auto ptr : e) {
         if (IsEntityRelevant_(ptr)) {
             entities_.insert(ptr);
@@ -303,17 +316,17 @@ void RandomLightMoverProcess::EntitiesAdded(const std::unordered_set<stratus::En
     }
 }
 
-void RandomLightMoverProcess::EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>& e) {
+void RandomLightMoverProcess::EntitiesRemoved(const stratus::EntityList& e) {
     for (auto ptr : e) {
         entities_.erase(ptr);
     }
 }
 
-void RandomLightMoverProcess::EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent*>>& added) {
+void RandomLightMoverProcess::EntityComponentsAdded(const stratus::EntityComponentsAddedList& added) {
 
 }
 
-void RandomLightMoverProcess::EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>& changed) {
+void RandomLightMoverProcess::EntityComponentsEnabledDisabled(const stratus::EntityList& changed) {
 
 }
 
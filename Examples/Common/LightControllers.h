@@ -38,10 +38,10 @@ struct LightProcess : public stratus::EntityProcess {
     virtual ~LightProcess();
 
     void Process(const double deltaSeconds) override;
-    void EntitiesAdded(const std::unordered_set<stratus::EntityPtr>& e) override;
-    void EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>& e) override;
-    void EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent*>>& added) override;
-    void EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>& changed) override;
+    void EntitiesAdded(const stratus::EntityList& e) override;
+    void EntitiesRemoved(const stratus::EntityList& e) override;
+    void EntityComponentsAdded(const stratus::EntityComponentsAddedList& added) override;
+    void EntityComponentsEnabledDisabled(const stratus::EntityList& changed) override;
 
     stratus::InputHandlerPtr input;
 };
@@ -49,11 +49,13 @@ struct LightProcess : public stratus::EntityProcess {
 struct RandomLightMoverProcess : public stratus::EntityProcess {
     virtual ~RandomLightMoverProcess() = default;
 
+    stratus::EntityComponentSignature RequiredComponents() const override;
+    stratus::EntityProcessAccess ComponentAccess() const override;
     void Process(const double deltaSeconds) override;
-    void EntitiesAdded(const std::unordered_set<stratus::EntityPtr>& e) override;
-    void EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>& e) override;
-    void EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent*>>& added) override;
-    void EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>& changed) override;
+    void EntitiesAdded(const stratus::EntityList& e) override;
+    void EntitiesRemoved(const stratus::EntityList& e) override;
+    void EntityComponentsAdded(const stratus::EntityComponentsAddedList& added) override;
+    void EntityComponentsEnabledDisabled(const stratus::EntityList& changed) override;
 
 private:
     static bool IsEntityRelevant_(const stratus::EntityPtr&);
@@ -92,79 +92,93 @@ public:
         environmentMaps.push_back(INSTANCE(ResourceManager)->LoadTexture("../Resources/resources/textures/Rock_Moss_001_ambientOcclusion.jpg", stratus::ColorSpace::SRGB));
 
         stratus::Async<stratus::Entity> e;
-        e = INSTANCE(ResourceManager)->LoadModel("../Resources/resources/models/Latrine.fbx", stratus::ColorSpace::NONE, true, stratus::RenderFaceCulling::CULLING_CCW);
-        e.AddCallback([this](stratus::Async<stratus::Entity> e) { 
+        const glm::vec3 outhousePosition = glm::vec3(-50.0f, -10.0f, -45.0f);
+        e = INSTANCE(ResourceManager)->LoadModel("../Resources/resources/models/Latrine.fbx", stratus::ColorSpace::NONE, true, stratus::RenderFaceCulling::CULLING_CCW,
+            INSTANCE(ResourceManager)->LoadPriorityForPosition(outhousePosition));
+        e.AddCallback([this, outhousePosition](stratus::Async<stratus::Entity> e) { 
             if (e.Failed()) return;
             outhouse = e.GetPtr(); 
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(outhouse);
             transform->SetLocalScale(glm::vec3(15.0f));
-            transform->SetLocalPosition(glm::vec3(-50.0f, -10.0f, -45.0f));
+            transform->SetLocalPosition(outhousePosition);
             INSTANCE(EntityManager)->AddEntity(outhouse);
         });
 
-        e = INSTANCE(ResourceManager)->LoadModel("../Resources/resources/models/hromada_hlina_01_30k_f.FBX", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW);
-        e.AddCallback([this](stratus::Async<stratus::Entity> e) { 
+        const glm::vec3 clayPosition = glm::vec3(100.0f, 0.0f, -50.0f);
+        e = INSTANCE(ResourceManager)->LoadModel("../Resources/resources/models/hromada_hlina_01_30k_f.FBX", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW,
+            INSTANCE(ResourceManager)->LoadPriorityForPosition(clayPosition));
+        e.AddCallback([this, clayPosition](stratus::Async<stratus::Entity> e) { 
             if (e.Failed()) return;
             clay = e.GetPtr(); 
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(clay);
-            transform->SetLocalPosition(glm::vec3(100.0f, 0.0f, -50.0f));
+            transform->SetLocalPosition(clayPosition);
             //transform->SetLocalRotation(stratus::Rotation(stratus::Degrees(-180.0f), stratus::Degrees(0.0f), stratus::Degrees(0.0f)));
             INSTANCE(EntityManager)->AddEntity(clay);
             PrintNodeHierarchy(clay, "Clay", "");
         });
 
-        e = INSTANCE(ResourceManager)->LoadModel("../Resources/resources/models/boubin_stump.FBX", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW);
-        e.AddCallback([this](stratus::Async<stratus::Entity> e) { 
+        const glm::vec3 stumpPosition = glm::vec3(0.0f, -15.0f, -20.0f);
+        e = INSTANCE(ResourceManager)->LoadModel("../Resources/resources/models/boubin_stump.FBX", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW,
+            INSTANCE(ResourceManager)->LoadPriorityForPosition(stumpPosition));
+        e.AddCallback([this, stumpPosition](stratus::Async<stratus::Entity> e) { 
             if (e.Failed()) return;
             stump = e.GetPtr(); 
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(stump);
             transform->SetLocalRotation(stratus::Rotation(stratus::Degrees(-180.0f), stratus::Degrees(0.0f), stratus::Degrees(0.0f)));
-            transform->SetLocalPosition(glm::vec3(0.0f, -15.0f, -20.0f));
+            transform->SetLocalPosition(stumpPosition);
             INSTANCE(EntityManager)->AddEntity(stump);
             PrintNodeHierarchy(stump, "Stump", "");
         });
 
-        e = INSTANCE(ResourceManager)->LoadModel("../Resources/local/hintze-hall-1m.obj", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW);
-        e.AddCallback([this](stratus::Async<stratus::Entity> e) { 
+        const glm::vec3 hallPosition = glm::vec3(-250.0f, -30.0f, 0.0f);
+        e = INSTANCE(ResourceManager)->LoadModel("../Resources/local/hintze-hall-1m.obj", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW,
+            INSTANCE(ResourceManager)->LoadPriorityForPosition(hallPosition));
+        e.AddCallback([this, hallPosition](stratus::Async<stratus::Entity> e) { 
             if (e.Failed()) return;
             hall = e.GetPtr(); 
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(hall);
             transform->SetLocalRotation(stratus::Rotation(stratus::Degrees(-90.0f), stratus::Degrees(0.0f), stratus::Degrees(0.0f)));
             transform->SetLocalScale(glm::vec3(10.0f, 10.0f, 10.0f));
-            transform->SetLocalPosition(glm::vec3(-250.0f, -30.0f, 0.0f));
+            transform->SetLocalPosition(hallPosition);
             INSTANCE(EntityManager)->AddEntity(hall);
             PrintNodeHierarchy(hall, "Hall", "");
         });
 
-        e = INSTANCE(ResourceManager)->LoadModel("../Resources/local/model.obj", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW);
-        e.AddCallback([this](stratus::Async<stratus::Entity> e) { 
+        const glm::vec3 rampartsPosition = glm::vec3(300.0f, 0.0f, -100.0f);
+        e = INSTANCE(ResourceManager)->LoadModel("../Resources/local/model.obj", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW,
+            INSTANCE(ResourceManager)->LoadPriorityForPosition(rampartsPosition));
+        e.AddCallback([this, rampartsPosition](stratus::Async<stratus::Entity> e) { 
             if (e.Failed()) return;
             ramparts = e.GetPtr(); 
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(ramparts);
-            transform->SetLocalPosition(glm::vec3(300.0f, 0.0f, -100.0f));
+            transform->SetLocalPosition(rampartsPosition);
             transform->SetLocalRotation(stratus::Rotation(stratus::Degrees(90.0f), stratus::Degrees(0.0f), stratus::Degrees(0.0f)));
             transform->SetLocalScale(glm::vec3(10.0f));
             INSTANCE(EntityManager)->AddEntity(ramparts);
         });
 
-        e = INSTANCE(ResourceManager)->LoadModel("../Resources/local/Rock_Terrain_SF.obj", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW);
-        e.AddCallback([this](stratus::Async<stratus::Entity> e) { 
+        const glm::vec3 rocksPosition = glm::vec3(700.0f, -75.0f, -100.0f);
+        e = INSTANCE(ResourceManager)->LoadModel("../Resources/local/Rock_Terrain_SF.obj", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW,
+            INSTANCE(ResourceManager)->LoadPriorityForPosition(rocksPosition));
+        e.AddCallback([this, rocksPosition](stratus::Async<stratus::Entity> e) { 
             if (e.Failed()) return;
             rocks = e.GetPtr(); 
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(rocks);
-            transform->SetLocalPosition(glm::vec3(700.0f, -75.0f, -100.0f));
+            transform->SetLocalPosition(rocksPosition);
             transform->SetLocalScale(glm::vec3(15.0f));
             INSTANCE(EntityManager)->AddEntity(rocks);
             PrintNodeHierarchy(rocks, "Rocks", "");
         });
 
         // Disable culling for this model since there are some weird parts that seem to be reversed
-        e = INSTANCE(ResourceManager)->LoadModel("../Resources/glTF-Sample-Models/2.0/Sponza/glTF/Sponza.gltf", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW);
-        e.AddCallback([this](stratus::Async<stratus::Entity> e) { 
+        const glm::vec3 sponzaPosition = glm::vec3(0.0f, -300.0f, -500.0f);
+        e = INSTANCE(ResourceManager)->LoadModel("../Resources/glTF-Sample-Models/2.0/Sponza/glTF/Sponza.gltf", stratus::ColorSpace::SRGB, true, stratus::RenderFaceCulling::CULLING_CCW,
+            INSTANCE(ResourceManager)->LoadPriorityForPosition(sponzaPosition));
+        e.AddCallback([this, sponzaPosition](stratus::Async<stratus::Entity> e) { 
             if (e.Failed()) return;
             sponza = e.GetPtr(); 
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(sponza);
-            transform->SetLocalPosition(glm::vec3(0.0f, -300.0f, -500.0f));
+            transform->SetLocalPosition(sponzaPosition);
             transform->SetLocalScale(glm::vec3(15.0f));
             INSTANCE(EntityManager)->AddEntity(sponza);
             PrintNodeHierarchy(sponza, "Sponza", "");
@@ -183,15 +197,15 @@ public:
             rc->SetMaterialAt(mat, 0);
             rc = stratus::GetComponent<stratus::RenderComponent>(quad);
             rc->SetMaterialAt(mat, 0);
-            cubeMeshes.push_back(cube);
-            quadMeshes.push_back(quad);
+            cubeMeshes.push_back(stratus::EntityPrefab::Create(cube));
+            quadMeshes.push_back(stratus::EntityPrefab::Create(quad));
         }
 
         //quadMat.texture = INSTANCE(ResourceManager)->LoadTexture("../Resources/resources/textures/volcanic_rock_texture.png");
         srand(time(nullptr));
         for (int i = 0; i < 100; ++i) {
             size_t texIndex = rand() % textures.size();
-            auto mesh = quadMeshes[texIndex]->Copy();
+            auto mesh = quadMeshes[texIndex]->Instantiate();
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(mesh);
             transform->SetLocalPosition(glm::vec3(rand() % 50, rand() % 50, rand() % 50));
             entities.push_back(mesh);
@@ -203,7 +217,7 @@ public:
         // cubeMat.texture = INSTANCE(ResourceManager)->LoadTexture("../Resources/resources/textures/wood_texture.jpg");
         for (int i = 0; i < 5000; ++i) {
             size_t texIndex = rand() % textures.size();
-            auto mesh = cubeMeshes[texIndex]->Copy();
+            auto mesh = cubeMeshes[texIndex]->Instantiate();
             auto transform = stratus::GetComponent<stratus::LocalTransformComponent>(mesh);
             entities.push_back(mesh);
             transform->SetLocalPosition(glm::vec3(rand() % 3000, rand() % 50, rand() % 3000));
@@ -424,8 +438,8 @@ private:
     stratus::EntityPtr ramparts;
     stratus::EntityPtr rocks;
     stratus::EntityPtr sponza;
-    std::vector<stratus::EntityPtr> cubeMeshes;
-    std::vector<stratus::EntityPtr> quadMeshes;
+    std::vector<stratus::EntityPrefabPtr> cubeMeshes;
+    std::vector<stratus::EntityPrefabPtr> quadMeshes;
     std::vector<stratus::EntityPtr> entities;
     std::vector<size_t> textureIndices;
     glm::mat4 persp;
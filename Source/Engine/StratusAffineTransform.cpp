@@ -0,0 +1,158 @@
+#include "StratusAffineTransform.h"
+#include "StratusCpuTopology.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+// SSE2 is part of the x86-64 baseline while AVX is selected at runtime
+#define STRATUS_AFFINE_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define STRATUS_TARGET_AVX_
+#else
+#define STRATUS_TARGET_AVX_ __attribute__((target("avx")))
+#endif
+#endif
+
+namespace stratus {
+    typedef void (*MultiplyAffineKernel_)(const size_t, const AffineTransform *, const AffineTransform *, AffineTransform *);
+    typedef void (*ComposeAffineKernel_)(const size_t, const glm::vec3 *, const glm::mat3 *, const glm::vec3 *, AffineTransform *);
+
+    // The order of operations matches glm's mat4 * mat4 so that every kernel produces the same bits. This is
+    // also why none of the kernels use FMA.
+    static void MultiplyAffineScalar_(const size_t count, const AffineTransform * parents, const AffineTransform * locals, AffineTransform * out) {
+        for (size_t i = 0; i < count; ++i) {
+            const AffineTransform a = parents[i];
+            const AffineTransform b = locals[i];
+            for (int r = 0; r < 3; ++r) {
+                out[i].rows[r] = a.rows[r].x * b.rows[0] + a.rows[r].y * b.rows[1] + a.rows[r].z * b.rows[2] +
+                    glm::vec4(0.0f, 0.0f, 0.0f, a.rows[r].w);
+            }
+        }
+    }
+
+    static void ComposeAffineScalar_(const size_t count, const glm::vec3 * scales, const glm::mat3 * rotations, const glm::vec3 * positions, AffineTransform * out) {
+        for (size_t i = 0; i < count; ++i) {
+            const glm::vec3& s = scales[i];
+            const glm::mat3& R = rotations[i];
+            const glm::vec3& p = positions[i];
+            for (int r = 0; r < 3; ++r) {
+                out[i].rows[r] = glm::vec4(R[0][r] * s.x, R[1][r] * s.y, R[2][r] * s.z, p[r]);
+            }
+        }
+    }
+
+#ifdef STRATUS_AFFINE_X64
+    // Keeps the w component of a row which is the translation
+    static inline __m128 TranslationMask_() {
+        return _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+    }
+
+    static void MultiplyAffineSse_(const size_t count, const AffineTransform * parents, const AffineTransform * locals, AffineTransform * out) {
+        const __m128 mask = TranslationMask_();
+        for (size_t i = 0; i < count; ++i) {
+            const float * a = &parents[i].rows[0].x;
+            const float * b = &locals[i].rows[0].x;
+            const __m128 b0 = _mm_load_ps(b);
+            const __m128 b1 = _mm_load_ps(b + 4);
+            const __m128 b2 = _mm_load_ps(b + 8);
+            const __m128 a0 = _mm_load_ps(a);
+            const __m128 a1 = _mm_load_ps(a + 4);
+            const __m128 a2 = _mm_load_ps(a + 8);
+
+            const __m128 rows[3] = {a0, a1, a2};
+            float * result = &out[i].rows[0].x;
+            for (int r = 0; r < 3; ++r) {
+                const __m128 row = rows[r];
+                __m128 x = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+                x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+                x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+                x = _mm_add_ps(x, _mm_and_ps(row, mask));
+                _mm_store_ps(result + 4 * r, x);
+            }
+        }
+    }
+
+    static void ComposeAffineSse_(const size_t count, const glm::vec3 * scales, const glm::mat3 * rotations, const glm::vec3 * positions, AffineTransform * out) {
+        for (size_t i = 0; i < count; ++i) {
+            const glm::mat3& R = rotations[i];
+            const glm::vec3& p = positions[i];
+            // Scaled rotation columns plus translation, transposed into rows
+            __m128 c0 = _mm_mul_ps(_mm_set_ps(0.0f, R[0][2], R[0][1], R[0][0]), _mm_set1_ps(scales[i].x));
+            __m128 c1 = _mm_mul_ps(_mm_set_ps(0.0f, R[1][2], R[1][1], R[1][0]), _mm_set1_ps(scales[i].y));
+            __m128 c2 = _mm_mul_ps(_mm_set_ps(0.0f, R[2][2], R[2][1], R[2][0]), _mm_set1_ps(scales[i].z));
+            __m128 c3 = _mm_set_ps(1.0f, p.z, p.y, p.x);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            float * result = &out[i].rows[0].x;
+            _mm_store_ps(result, c0);
+            _mm_store_ps(result + 4, c1);
+            _mm_store_ps(result + 8, c2);
+        }
+    }
+
+    // Two transforms at a time, one per 128-bit lane
+    STRATUS_TARGET_AVX_ static void MultiplyAffineAvx_(const size_t count, const AffineTransform * parents, const AffineTransform * locals, AffineTransform * out) {
+        const __m256 mask = _mm256_castsi256_ps(_mm256_set_epi32(-1, 0, 0, 0, -1, 0, 0, 0));
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2) {
+            const float * a = &parents[i].rows[0].x;
+            const float * b = &locals[i].rows[0].x;
+            // Transform i + 1 starts 12 floats after transform i
+            __m256 as[3];
+            __m256 bs[3];
+            for (int r = 0; r < 3; ++r) {
+                as[r] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(a + 4 * r)), _mm_load_ps(a + 12 + 4 * r), 1);
+                bs[r] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(b + 4 * r)), _mm_load_ps(b + 12 + 4 * r), 1);
+            }
+
+            float * result = &out[i].rows[0].x;
+            for (int r = 0; r < 3; ++r) {
+                const __m256 row = as[r];
+                __m256 x = _mm256_mul_ps(_mm256_permute_ps(row, _MM_SHUFFLE(0, 0, 0, 0)), bs[0]);
+                x = _mm256_add_ps(x, _mm256_mul_ps(_mm256_permute_ps(row, _MM_SHUFFLE(1, 1, 1, 1)), bs[1]));
+                x = _mm256_add_ps(x, _mm256_mul_ps(_mm256_permute_ps(row, _MM_SHUFFLE(2, 2, 2, 2)), bs[2]));
+                x = _mm256_add_ps(x, _mm256_and_ps(row, mask));
+                _mm_store_ps(result + 4 * r, _mm256_castps256_ps128(x));
+                _mm_store_ps(result + 12 + 4 * r, _mm256_extractf128_ps(x, 1));
+            }
+        }
+
+        if (i < count) MultiplyAffineSse_(count - i, parents + i, locals + i, out + i);
+    }
+
+#endif
+
+    struct AffineKernels_ {
+        MultiplyAffineKernel_ multiply = MultiplyAffineScalar_;
+        ComposeAffineKernel_ compose = ComposeAffineScalar_;
+        const char * name = "Scalar";
+
+        AffineKernels_() {
+#ifdef STRATUS_AFFINE_X64
+            multiply = MultiplyAffineSse_;
+            compose = ComposeAffineSse_;
+            name = "SSE";
+            if (CpuSupportsAvx()) {
+                multiply = MultiplyAffineAvx_;
+                name = "AVX";
+            }
+#endif
+        }
+    };
+
+    static const AffineKernels_& Kernels_() {
+        static const AffineKernels_ kernels;
+        return kernels;
+    }
+
+    void MultiplyAffineTransforms(const size_t count, const AffineTransform * parents, const AffineTransform * locals, AffineTransform * out) {
+        Kernels_().multiply(count, parents, locals, out);
+    }
+
+    void ComposeAffineTransforms(const size_t count, const glm::vec3 * scales, const glm::mat3 * rotations, const glm::vec3 * positions, AffineTransform * out) {
+        Kernels_().compose(count, scales, rotations, positions, out);
+    }
+
+    const char * AffineTransformKernelName() {
+        return Kernels_().name;
+    }
+}
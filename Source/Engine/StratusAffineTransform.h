@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include "glm/glm.hpp"
+
+namespace stratus {
+    // Affine transform stored as the top three rows of a 4x4 matrix since the bottom row is always
+    // (0, 0, 0, 1). Each row is (x axis, y axis, z axis, translation) for that component so a transform
+    // is 48 bytes instead of 64 for a glm::mat4, and rows load straight into SIMD registers.
+    struct alignas(16) AffineTransform {
+        glm::vec4 rows[3];
+
+        AffineTransform()
+            : rows{glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)} {}
+
+        // Drops the bottom row of m
+        explicit AffineTransform(const glm::mat4& m) {
+            for (int r = 0; r < 3; ++r) {
+                rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+            }
+        }
+
+        glm::mat4 ToMat4() const {
+            return glm::mat4(
+                rows[0].x, rows[1].x, rows[2].x, 0.0f,
+                rows[0].y, rows[1].y, rows[2].y, 0.0f,
+                rows[0].z, rows[1].z, rows[2].z, 0.0f,
+                rows[0].w, rows[1].w, rows[2].w, 1.0f
+            );
+        }
+
+        glm::vec3 GetTranslate() const {
+            return glm::vec3(rows[0].w, rows[1].w, rows[2].w);
+        }
+    };
+
+    static_assert(sizeof(AffineTransform) == 48);
+
+    // Batched kernels which use AVX or SSE when the CPU supports them and fall back to scalar code otherwise.
+    // Results are identical to doing the same math with glm::mat4 (T * R * S and parent * local) on every path.
+
+    // out[i] = parents[i] * locals[i]. out may alias either input.
+    void MultiplyAffineTransforms(const size_t count, const AffineTransform * parents, const AffineTransform * locals, AffineTransform * out);
+
+    // out[i] = T(positions[i]) * R(rotations[i]) * S(scales[i])
+    void ComposeAffineTransforms(const size_t count, const glm::vec3 * scales, const glm::mat3 * rotations, const glm::vec3 * positions, AffineTransform * out);
+
+    // Name of the kernel selected for this CPU ("AVX", "SSE" or "Scalar")
+    const char * AffineTransformKernelName();
+}
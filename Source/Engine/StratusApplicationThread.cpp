@@ -19,17 +19,7 @@ namespace stratus {
         return &Thread::Current() == thread_.get();
     }
 
-    void ApplicationThread::QueueFront_(const Thread::ThreadFunction& function) {
-        auto ul = LockWrite_();
-        queue_.push_front(function);
-    }
-
     void ApplicationThread::Dispatch_() {
-        {
-            auto ul = LockWrite_();
-            thread_->QueueMany(queue_);
-            queue_.clear();
-        }
         thread_->Dispatch();
     }
 
@@ -1,20 +1,189 @@
 #pragma once
 
 #include "StratusThread.h"
+#include <type_traits>
+#include <atomic>
+#include <cstdint>
+#include <string>
 
 namespace stratus { 
+    class TaskSystem;
+
+    template<typename E>
+    class Async;
+
+    // Implements continuations and combinators. Only templated so that it can be defined
+    // after Async while still being usable from inside of it.
+    template<typename T>
+    struct AsyncOps_;
+
+    // Maps the return type of a continuation to the Async it produces. Continuations follow the same
+    // rules as other async functions: E * and std::shared_ptr<E> produce Async<E> while void produces Async<void>.
+    template<typename T>
+    struct AsyncResult_;
+
+    template<typename T>
+    struct AsyncResult_<T *> {
+        typedef T Type;
+        typedef std::function<T * (void)> Function;
+    };
+
+    template<typename T>
+    struct AsyncResult_<std::shared_ptr<T>> {
+        typedef T Type;
+        typedef std::function<std::shared_ptr<T> (void)> Function;
+    };
+
+    template<>
+    struct AsyncResult_<void> {
+        typedef void Type;
+        typedef std::function<void (void)> Function;
+    };
+
+    // State shared by every AsyncImpl_. The current state is a single atomic word so that polling functions
+    // such as Completed() and Failed() are one load. Callbacks and continuations are pushed onto a lock-free
+    // list which is closed once the Async finishes - anything added after that runs right away.
+    class AsyncState_ {
+        enum State_ : uint32_t {
+            PENDING,
+            RUNNING,
+            COMPLETE,
+            FAILED
+        };
+
+        struct Waiter_ {
+            template<typename F>
+            Waiter_(Thread * thread, F&& function)
+                : thread(thread), function(std::forward<F>(function)) {}
+
+            // nullptr for continuations which run directly on the completing thread
+            Thread * thread;
+            UniqueFunction<void(void)> function;
+            Waiter_ * next = nullptr;
+        };
+
+        // Marks the waiter list as closed
+        static Waiter_ * Closed_() {
+            return reinterpret_cast<Waiter_ *>(uintptr_t(1));
+        }
+
+    public:
+        AsyncState_() = default;
+
+        AsyncState_(const AsyncState_&) = delete;
+        AsyncState_(AsyncState_&&) = delete;
+        AsyncState_& operator=(const AsyncState_&) = delete;
+        AsyncState_& operator=(AsyncState_&&) = delete;
+
+        ~AsyncState_() {
+            // Never completed so none of these ran
+            Waiter_ * waiter = waiters_.load(std::memory_order_acquire);
+            if (waiter == Closed_()) return;
+            while (waiter != nullptr) {
+                Waiter_ * next = waiter->next;
+                delete waiter;
+                waiter = next;
+            }
+        }
+
+        // Getters for checking internal state
+        bool Failed()                  const { return State_(state_.load(std::memory_order_acquire)) == FAILED; }
+        bool Completed()               const { return State_(state_.load(std::memory_order_acquire)) >= COMPLETE; }
+        bool CompleteAndValid()        const { return State_(state_.load(std::memory_order_acquire)) == COMPLETE; }
+        bool CompleteAndInvalid()      const { return Failed(); }
+        // Only valid after a failure (empty otherwise)
+        std::string ExceptionMessage() const { return Failed() ? exceptionMessage_ : std::string(); }
+
+        // The callback is queued onto whichever thread called AddCallback
+        void AddCallback(const Thread::ThreadFunction& callback) {
+            Thread * thread = &Thread::Current();
+            AddWaiter_(new Waiter_(thread, callback));
+        }
+
+        // Unlike AddCallback, continuations run directly on whichever thread completes the Async (or immediately
+        // on the calling thread if it has already completed). They also run if the Async failed.
+        void AddContinuation(const Thread::ThreadFunction& continuation) {
+            AddWaiter_(new Waiter_(nullptr, continuation));
+        }
+
+    protected:
+        // Used for asyncs which are complete from the start
+        void InitComplete_(const bool failed, const std::string& message = "") {
+            exceptionMessage_ = message;
+            state_.store(failed ? FAILED : COMPLETE, std::memory_order_relaxed);
+            waiters_.store(Closed_(), std::memory_order_relaxed);
+        }
+
+        void SetRunning_() {
+            state_.store(RUNNING, std::memory_order_relaxed);
+        }
+
+        // Publishes the result (written before calling this) and notifies everyone that we're done
+        void Finish_(const bool failed, const std::string& message = "") {
+            if (failed) exceptionMessage_ = message;
+            state_.store(failed ? FAILED : COMPLETE, std::memory_order_release);
+
+            // Waiters were pushed newest first so reverse them to preserve the order they were added in
+            Waiter_ * waiter = waiters_.exchange(Closed_(), std::memory_order_acq_rel);
+            Waiter_ * ordered = nullptr;
+            while (waiter != nullptr) {
+                Waiter_ * next = waiter->next;
+                waiter->next = ordered;
+                ordered = waiter;
+                waiter = next;
+            }
+
+            while (ordered != nullptr) {
+                Waiter_ * next = ordered->next;
+                Run_(ordered);
+                ordered = next;
+            }
+        }
+
+    private:
+        void AddWaiter_(Waiter_ * waiter) {
+            Waiter_ * head = waiters_.load(std::memory_order_acquire);
+            while (head != Closed_()) {
+                waiter->next = head;
+                if (waiters_.compare_exchange_weak(head, waiter, std::memory_order_release, std::memory_order_acquire)) {
+                    return;
+                }
+            }
+
+            // Already complete so run it right away
+            Run_(waiter);
+        }
+
+        static void Run_(Waiter_ * waiter) {
+            if (waiter->thread != nullptr) {
+                waiter->thread->Queue(std::move(waiter->function));
+                delete waiter;
+            }
+            else {
+                // Make sure the node is cleaned up even if the continuation throws
+                std::unique_ptr<Waiter_> owned(waiter);
+                owned->function();
+            }
+        }
+
+    private:
+        std::atomic<uint32_t> state_{PENDING};
+        std::atomic<Waiter_ *> waiters_{nullptr};
+        // Written once before state_ is set to FAILED
+        std::string exceptionMessage_;
+    };
+
     // Thread for managing Async operations (Note: only safe to use within the context of a valid stratus::Thread,
     // so a raw pthread or std::thread are not useable).
     //
     // It's important to know that whatever thread calls AddCallback will be the same thread that is executes
     // the callback to let you know it completed.
     template<typename E>
-    class AsyncImpl_ : public std::enable_shared_from_this<AsyncImpl_<E>> {
+    class AsyncImpl_ : public AsyncState_, public std::enable_shared_from_this<AsyncImpl_<E>> {
     public:        
         AsyncImpl_(const std::shared_ptr<E>& result) {
             result_ = result;
-            complete_ = true;
-            failed_ = result == nullptr;
+            InitComplete_(result == nullptr);
         }
 
         AsyncImpl_(Thread& context, std::function<E *(void)> compute) 
@@ -24,6 +193,14 @@ namespace stratus {
             : context_(&context),
               compute_(compute) {}
 
+        // No context means that Start is not supported and the owner is responsible for calling Run
+        AsyncImpl_(std::function<E *(void)> compute)
+            : AsyncImpl_([compute]() { return std::shared_ptr<E>(compute()); }) {}
+
+        AsyncImpl_(std::function<std::shared_ptr<E> (void)> compute)
+            : context_(nullptr),
+              compute_(compute) {}
+
         AsyncImpl_(const AsyncImpl_&) = delete;
         AsyncImpl_(AsyncImpl_&&) = delete;
         AsyncImpl_& operator=(const AsyncImpl_&) = delete;
@@ -35,68 +212,50 @@ namespace stratus {
             if (Completed()) return;
 
             std::shared_ptr<AsyncImpl_> shared = this->shared_from_this();
-            context_->Queue([this, shared]() {
-                bool failed = false;
-                try {
-                    std::shared_ptr<E> result = this->compute_();
-                    auto ul = this->LockWrite_();
-                    this->result_ = result;
-                    this->complete_ = true;
-                    this->failed_ = this->result_ == nullptr;
-                    failed = this->failed_;
-                    if (failed) {
-                        this->exceptionMessage_ = "Async function returned nullptr";
-                    }
-                }
-                catch (const std::exception& e) {
-                    auto ul = this->LockWrite_();
-                    this->complete_ = true;
-                    this->failed_ = true;
-                    this->exceptionMessage_ = e.what();
-                    failed = true;
-                }
-
-                // End early to prevent waiting callbacks from receiving null pointers
-                //if (failed) return;
-
-                // Notify everyone that we're done
-                this->ProcessCallbacks_();
+            context_->Queue([shared]() {
+                shared->Run();
             });
         }
 
-        // Getters for checking internal state
-        bool Failed()                  const { auto sl = LockRead_(); return failed_; }
-        bool Completed()               const { auto sl = LockRead_(); return complete_; }
-        bool CompleteAndValid()        const { auto sl = LockRead_(); return complete_ && !failed_; }
-        bool CompleteAndInvalid()      const { auto sl = LockRead_(); return complete_ && failed_; }
-        std::string ExceptionMessage() const { auto sl = LockRead_(); return exceptionMessage_; }
-
-        // Getters for retrieving result
-        const E& Get() const {
-            if (!Completed()) {
-                throw std::runtime_error("stratus::Async::Get called before completion");
+        // Performs the computation on the calling thread and notifies all callbacks. Should only be
+        // called by Start or by TaskSystem for asyncs which were created without a context.
+        void Run() {
+            SetRunning_();
+            try {
+                result_ = compute_();
+            }
+            catch (const std::exception& e) {
+                result_ = nullptr;
+                Finish_(true, e.what());
+                return;
             }
 
-            if (Failed()) {
-                throw std::runtime_error("Get() called on a failed Async operation");
+            if (result_ == nullptr) {
+                Finish_(true, "Async function returned nullptr");
             }
+            else {
+                Finish_(false);
+            }
+        }
 
+        // Getters for retrieving result
+        const E& Get() const {
+            CheckResult_();
             return *result_;
         }
 
         E& Get() {
-            if (!Completed()) {
-                throw std::runtime_error("stratus::Async::Get called before completion");
-            }
-
-            if (Failed()) {
-                throw std::runtime_error("Get() called on a failed Async operation");
-            }
-
+            CheckResult_();
             return *result_;
         }
 
         std::shared_ptr<E> GetPtr() const {
+            CheckResult_();
+            return result_;
+        }
+
+    private:
+        void CheckResult_() const {
             if (!Completed()) {
                 throw std::runtime_error("stratus::Async::Get called before completion");
             }
@@ -104,67 +263,34 @@ namespace stratus {
             if (Failed()) {
                 throw std::runtime_error("Get() called on a failed Async operation");
             }
-
-            return result_;
-        }
-
-        void AddCallback(const Thread::ThreadFunction & callback) {
-            Thread * thread = &Thread::Current();
-            // If completed then schedule it immediately
-            if (Completed() && !Failed()) {
-                thread->Queue(callback);
-            }
-            else {
-                auto ul = LockWrite_();
-                if (callbacks_.find(thread) == callbacks_.end()) {
-                    callbacks_.insert(std::make_pair(thread, std::vector<Thread::ThreadFunction>()));
-                }
-                callbacks_.find(thread)->second.push_back(callback);
-            }
-        }
-
-    private:
-        std::unique_lock<std::shared_mutex> LockWrite_() const { return std::unique_lock<std::shared_mutex>(mutex_); }
-        std::shared_lock<std::shared_mutex> LockRead_()  const { return std::shared_lock<std::shared_mutex>(mutex_); }
-
-        void ProcessCallbacks_() {
-            std::unordered_map<Thread *, std::vector<Thread::ThreadFunction>> callbacks;
-            {
-                auto ul = LockWrite_();
-                callbacks = std::move(callbacks_);
-            }
-            for (auto entry : callbacks) {
-                entry.first->QueueMany(entry.second);
-            }
         }
 
     private:
+        // Written once before completion is published
         std::shared_ptr<E> result_ = nullptr;
         Thread * context_;
         std::function<std::shared_ptr<E> (void)> compute_;
-        mutable std::shared_mutex mutex_;
-        std::string exceptionMessage_;
-        bool failed_ = false;
-        bool complete_ = false;
-        std::unordered_map<Thread *, std::vector<Thread::ThreadFunction>> callbacks_;
     };
 
     // Explicit specialization for void
     template<>
-    class AsyncImpl_<void> : public std::enable_shared_from_this<AsyncImpl_<void>> {
+    class AsyncImpl_<void> : public AsyncState_, public std::enable_shared_from_this<AsyncImpl_<void>> {
     public:
         AsyncImpl_() {
-            complete_ = true;
-            failed_ = false;
+            InitComplete_(false);
         }
 
         AsyncImpl_(Thread& context, const std::function<void(void)>& compute) {
             compute_ = compute;
-            complete_ = false;
-            failed_ = false;
             context_ = &context;
         }
 
+        // No context means that Start is not supported and the owner is responsible for calling Run
+        AsyncImpl_(const std::function<void(void)>& compute) {
+            compute_ = compute;
+            context_ = nullptr;
+        }
+
         AsyncImpl_(const AsyncImpl_&) = delete;
         AsyncImpl_(AsyncImpl_&&) = delete;
         AsyncImpl_& operator=(const AsyncImpl_&) = delete;
@@ -176,76 +302,29 @@ namespace stratus {
             if (Completed()) return;
 
             std::shared_ptr<AsyncImpl_> shared = this->shared_from_this();
-            context_->Queue([this, shared]() {
-                bool failed = false;
-                try {
-                    this->compute_();
-                    auto ul = this->LockWrite_();
-                    this->complete_ = true;
-                    this->failed_ = false;
-                    failed = this->failed_;
-                }
-                catch (const std::exception& e) {
-                    auto ul = this->LockWrite_();
-                    this->complete_ = true;
-                    this->failed_ = true;
-                    this->exceptionMessage_ = e.what();
-                    failed = true;
-                }
-
-                // End early to prevent waiting callbacks from receiving null pointers
-                //if (failed) return;
-
-                // Notify everyone that we're done
-                this->ProcessCallbacks_();
-                });
+            context_->Queue([shared]() {
+                shared->Run();
+            });
         }
 
-        // Getters for checking internal state
-        bool Failed()                  const { auto sl = LockRead_(); return failed_; }
-        bool Completed()               const { auto sl = LockRead_(); return complete_; }
-        bool CompleteAndValid()        const { auto sl = LockRead_(); return complete_ && !failed_; }
-        bool CompleteAndInvalid()      const { auto sl = LockRead_(); return complete_ && failed_; }
-        std::string ExceptionMessage() const { auto sl = LockRead_(); return exceptionMessage_; }
-
-        void AddCallback(const Thread::ThreadFunction& callback) {
-            Thread* thread = &Thread::Current();
-            // If completed then schedule it immediately
-            if (Completed() && !Failed()) {
-                thread->Queue(callback);
+        // Performs the computation on the calling thread and notifies all callbacks. Should only be
+        // called by Start or by TaskSystem for asyncs which were created without a context.
+        void Run() {
+            SetRunning_();
+            try {
+                this->compute_();
             }
-            else {
-                auto ul = LockWrite_();
-                if (callbacks_.find(thread) == callbacks_.end()) {
-                    callbacks_.insert(std::make_pair(thread, std::vector<Thread::ThreadFunction>()));
-                }
-                callbacks_.find(thread)->second.push_back(callback);
+            catch (const std::exception& e) {
+                Finish_(true, e.what());
+                return;
             }
-        }
 
-    private:
-        std::unique_lock<std::shared_mutex> LockWrite_() const { return std::unique_lock<std::shared_mutex>(mutex_); }
-        std::shared_lock<std::shared_mutex> LockRead_()  const { return std::shared_lock<std::shared_mutex>(mutex_); }
-
-        void ProcessCallbacks_() {
-            std::unordered_map<Thread*, std::vector<Thread::ThreadFunction>> callbacks;
-            {
-                auto ul = LockWrite_();
-                callbacks = std::move(callbacks_);
-            }
-            for (auto entry : callbacks) {
-                entry.first->QueueMany(entry.second);
-            }
+            Finish_(false);
         }
 
     private:
         Thread* context_ = nullptr;
         std::function<void (void)> compute_;
-        mutable std::shared_mutex mutex_;
-        std::string exceptionMessage_;
-        bool failed_ = false;
-        bool complete_ = false;
-        std::unordered_map<Thread*, std::vector<Thread::ThreadFunction>> callbacks_;
     };
 
     // To use this class, do something like the following:
@@ -256,6 +335,17 @@ namespace stratus {
     // if (!compute.Failed()) std::cout << compute.Get() << std::endl;
     template<typename E>
     class Async {
+        friend class TaskSystem;
+        template<typename T>
+        friend struct AsyncOps_;
+
+        // Used by TaskSystem which takes care of running the impl
+        static Async<E> FromImpl_(const std::shared_ptr<AsyncImpl_<E>>& impl) {
+            Async<E> as;
+            as.impl_ = impl;
+            return as;
+        }
+
     public:
         typedef std::function<void(Async<E>)> AsyncCallback;
 
@@ -297,6 +387,27 @@ namespace stratus {
             impl_->AddCallback([copy, callback]() { callback(copy); });
         }
 
+        // Continuation support - function receives the completed Async<E> (which may have failed) and
+        // follows the same rules as other async functions: it can return a pointer, a shared pointer or void.
+        // The continuation runs directly on the thread which completed this Async, so it should be short. If
+        // a context thread is given it will be queued onto that thread instead (e.g. for graphics work).
+        template<typename F>
+        Async<typename AsyncResult_<std::invoke_result_t<F, Async<E>>>::Type> Then(const F& function) const {
+            return AsyncOps_<F>::Then(*this, function, nullptr);
+        }
+
+        template<typename F>
+        Async<typename AsyncResult_<std::invoke_result_t<F, Async<E>>>::Type> Then(Thread& context, const F& function) const {
+            return AsyncOps_<F>::Then(*this, function, &context);
+        }
+
+    private:
+        // Runs directly on the completing thread
+        void OnComplete_(const Thread::ThreadFunction& function) const {
+            if (impl_ == nullptr) function();
+            else impl_->AddContinuation(function);
+        }
+
     private:
         std::shared_ptr<AsyncImpl_<E>> impl_;
     };
@@ -304,6 +415,17 @@ namespace stratus {
     // Explicit specialization for void
     template<>
     class Async<void> {
+        friend class TaskSystem;
+        template<typename T>
+        friend struct AsyncOps_;
+
+        // Used by TaskSystem which takes care of running the impl
+        static Async<void> FromImpl_(const std::shared_ptr<AsyncImpl_<void>>& impl) {
+            Async<void> as;
+            as.impl_ = impl;
+            return as;
+        }
+
     public:
         typedef std::function<void(Async<void>)> AsyncCallback;
 
@@ -333,7 +455,132 @@ namespace stratus {
             impl_->AddCallback([copy, callback]() { callback(copy); });
         }
 
+        // Continuation support - function receives the completed Async<void> (which may have failed) and
+        // follows the same rules as other async functions: it can return a pointer, a shared pointer or void.
+        // The continuation runs directly on the thread which completed this Async, so it should be short. If
+        // a context thread is given it will be queued onto that thread instead (e.g. for graphics work).
+        template<typename F>
+        Async<typename AsyncResult_<std::invoke_result_t<F, Async<void>>>::Type> Then(const F& function) const {
+            return AsyncOps_<F>::Then(*this, function, nullptr);
+        }
+
+        template<typename F>
+        Async<typename AsyncResult_<std::invoke_result_t<F, Async<void>>>::Type> Then(Thread& context, const F& function) const {
+            return AsyncOps_<F>::Then(*this, function, &context);
+        }
+
+    private:
+        // Runs directly on the completing thread
+        void OnComplete_(const Thread::ThreadFunction& function) const {
+            if (impl_ == nullptr) function();
+            else impl_->AddContinuation(function);
+        }
+
     private:
         std::shared_ptr<AsyncImpl_<void>> impl_;
     };
+
+    template<typename T>
+    struct AsyncOps_ {
+        template<typename A>
+        static void OnComplete(const A& as, const Thread::ThreadFunction& function) {
+            as.OnComplete_(function);
+        }
+
+        template<typename E>
+        static Async<E> FromImpl(const std::shared_ptr<AsyncImpl_<E>>& impl) {
+            return Async<E>::FromImpl_(impl);
+        }
+
+        template<typename A, typename F>
+        static Async<typename AsyncResult_<std::invoke_result_t<F, A>>::Type> Then(const A& antecedent, const F& function, Thread * context) {
+            typedef AsyncResult_<std::invoke_result_t<F, A>> Result;
+            typedef typename Result::Type R;
+
+            const typename Result::Function compute = [antecedent, function]() {
+                return function(antecedent);
+            };
+
+            auto impl = std::make_shared<AsyncImpl_<R>>(compute);
+            antecedent.OnComplete_([impl, context]() {
+                if (context == nullptr) {
+                    impl->Run();
+                }
+                else {
+                    context->Queue([impl]() { impl->Run(); });
+                }
+            });
+
+            return Async<R>::FromImpl_(impl);
+        }
+
+        template<typename E>
+        static Async<std::vector<Async<E>>> WhenAll(const std::vector<Async<E>>& group) {
+            typedef std::vector<Async<E>> Group;
+
+            auto impl = std::make_shared<AsyncImpl_<Group>>(std::function<std::shared_ptr<Group> (void)>([group]() {
+                return std::make_shared<Group>(group);
+            }));
+
+            if (group.size() == 0) {
+                impl->Run();
+            }
+            else {
+                auto remaining = std::make_shared<std::atomic<size_t>>(group.size());
+                for (const Async<E>& as : group) {
+                    as.OnComplete_([impl, remaining]() {
+                        // Last one to finish completes the group
+                        if (remaining->fetch_sub(1) == 1) impl->Run();
+                    });
+                }
+            }
+
+            return Async<Group>::FromImpl_(impl);
+        }
+
+        template<typename E>
+        static Async<size_t> WhenAny(const std::vector<Async<E>>& group) {
+            struct State_ {
+                std::atomic<bool> done{false};
+                size_t index = 0;
+            };
+
+            auto state = std::make_shared<State_>();
+            auto impl = std::make_shared<AsyncImpl_<size_t>>(std::function<std::shared_ptr<size_t> (void)>([state]() {
+                // Empty groups have no valid index so they fail
+                return state->done.load() ? std::make_shared<size_t>(state->index) : nullptr;
+            }));
+
+            if (group.size() == 0) {
+                impl->Run();
+            }
+            else {
+                for (size_t i = 0; i < group.size(); ++i) {
+                    group[i].OnComplete_([impl, state, i]() {
+                        // First one to finish wins - index is read by impl->Run() on this same thread
+                        if (state->done.exchange(true)) return;
+                        state->index = i;
+                        impl->Run();
+                    });
+                }
+            }
+
+            return Async<size_t>::FromImpl_(impl);
+        }
+    };
+
+    // Returns an Async which completes once every Async in the group has completed (whether or not they
+    // failed). The result is the original group. Completion happens directly on the thread which finished
+    // the last member of the group so there is no polling involved.
+    template<typename E>
+    Async<std::vector<Async<E>>> WhenAll(const std::vector<Async<E>>& group) {
+        return AsyncOps_<E>::WhenAll(group);
+    }
+
+    // Returns an Async which completes as soon as any Async in the group completes. The result is the index
+    // of the first to complete. Fails if the group is empty.
+    template<typename E>
+    Async<size_t> WhenAny(const std::vector<Async<E>>& group) {
+        return AsyncOps_<E>::WhenAny(group);
+    }
 }
\ No newline at end of file
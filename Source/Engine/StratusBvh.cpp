@@ -0,0 +1,374 @@
+#include "StratusBvh.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace stratus {
+    static glm::vec3 ToVec3_(const GpuVec& v) {
+        return glm::vec3(v.ToVec4());
+    }
+
+    // Half the surface area - only ever compared against other areas
+    static float Area_(const glm::vec3& vmin, const glm::vec3& vmax) {
+        const glm::vec3 d = vmax - vmin;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    static bool Overlaps_(const glm::vec3& amin, const glm::vec3& amax, const glm::vec3& bmin, const glm::vec3& bmax) {
+        return glm::all(glm::lessThanEqual(amin, bmax)) && glm::all(glm::lessThanEqual(bmin, amax));
+    }
+
+    static bool OverlapsSphere_(const glm::vec3& vmin, const glm::vec3& vmax, const glm::vec3& center, const float radius) {
+        const glm::vec3 d = glm::clamp(center, vmin, vmax) - center;
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+    static bool InFrustum_(const glm::vec3& vmin, const glm::vec3& vmax, const glm::vec4 * planes) {
+        for (int i = 0; i < 6; ++i) {
+            const glm::vec4& g = planes[i];
+            // Corner furthest along the plane normal - if it is outside then every corner is
+            const glm::vec3 p(
+                g.x >= 0.0f ? vmax.x : vmin.x,
+                g.y >= 0.0f ? vmax.y : vmin.y,
+                g.z >= 0.0f ? vmax.z : vmin.z
+            );
+            if (glm::dot(glm::vec3(g), p) + g.w < 0.0f) return false;
+        }
+        return true;
+    }
+
+    // Slab test, see "An Efficient and Robust Ray-Box Intersection Algorithm" (Williams et al.)
+    static bool HitByRay_(const glm::vec3& vmin, const glm::vec3& vmax, const glm::vec3& origin, const glm::vec3& invDirection, const float maxDistance) {
+        const glm::vec3 t1 = (vmin - origin) * invDirection;
+        const glm::vec3 t2 = (vmax - origin) * invDirection;
+        const glm::vec3 tnear = glm::min(t1, t2);
+        const glm::vec3 tfar = glm::max(t1, t2);
+        const float tmin = std::max<float>(std::max<float>(tnear.x, tnear.y), std::max<float>(tnear.z, 0.0f));
+        const float tmax = std::min<float>(std::min<float>(tfar.x, tfar.y), std::min<float>(tfar.z, maxDistance));
+        return tmin <= tmax;
+    }
+
+    Bvh::Bvh(const float margin)
+        : margin_(margin) {}
+
+    BvhProxy Bvh::Insert(const GpuAABB& aabb, const uint64_t userData) {
+        const uint32_t index = AllocateNode_();
+        Node_& leaf = nodes_[index];
+        leaf.leafMin = ToVec3_(aabb.vmin);
+        leaf.leafMax = ToVec3_(aabb.vmax);
+        leaf.userData = userData;
+        leaf.height = 0;
+        FattenLeaf_(leaf);
+
+        InsertLeaf_(index);
+        ++numLeaves_;
+        return index;
+    }
+
+    bool Bvh::Remove(const BvhProxy proxy) {
+        if (!Contains(proxy)) return false;
+
+        RemoveLeaf_(proxy);
+        FreeNode_(proxy);
+        --numLeaves_;
+        return true;
+    }
+
+    bool Bvh::Update(const BvhProxy proxy, const GpuAABB& aabb) {
+        if (!Contains(proxy)) throw std::runtime_error("Bvh::Update called with invalid proxy");
+
+        Node_& leaf = nodes_[proxy];
+        leaf.leafMin = ToVec3_(aabb.vmin);
+        leaf.leafMax = ToVec3_(aabb.vmax);
+
+        // Still inside the fat bounds so the tree is unaffected
+        if (glm::all(glm::lessThanEqual(leaf.vmin, leaf.leafMin)) && glm::all(glm::lessThanEqual(leaf.leafMax, leaf.vmax))) {
+            return false;
+        }
+
+        RemoveLeaf_(proxy);
+        FattenLeaf_(nodes_[proxy]);
+        InsertLeaf_(proxy);
+        return true;
+    }
+
+    void Bvh::Clear() {
+        nodes_.clear();
+        root_ = NullNode_;
+        freeList_ = NullNode_;
+        numLeaves_ = 0;
+    }
+
+    bool Bvh::Contains(const BvhProxy proxy) const {
+        return proxy < nodes_.size() && nodes_[proxy].height == 0;
+    }
+
+    GpuAABB Bvh::GetAABB(const BvhProxy proxy) const {
+        GpuAABB aabb;
+        aabb.vmin = glm::vec4(nodes_[proxy].leafMin, 1.0f);
+        aabb.vmax = glm::vec4(nodes_[proxy].leafMax, 1.0f);
+        return aabb;
+    }
+
+    uint64_t Bvh::GetUserData(const BvhProxy proxy) const {
+        return nodes_[proxy].userData;
+    }
+
+    size_t Bvh::Size() const {
+        return numLeaves_;
+    }
+
+    int32_t Bvh::Height() const {
+        return root_ == NullNode_ ? -1 : nodes_[root_].height;
+    }
+
+    void Bvh::QueryAabb(const GpuAABB& aabb, std::vector<BvhProxy>& out) const {
+        const glm::vec3 vmin = ToVec3_(aabb.vmin);
+        const glm::vec3 vmax = ToVec3_(aabb.vmax);
+        const auto test = [&vmin, &vmax](const glm::vec3& nmin, const glm::vec3& nmax) {
+            return Overlaps_(nmin, nmax, vmin, vmax);
+        };
+        Query_(test, test, out);
+    }
+
+    void Bvh::QuerySphere(const glm::vec3& center, const float radius, std::vector<BvhProxy>& out) const {
+        const auto test = [&center, radius](const glm::vec3& nmin, const glm::vec3& nmax) {
+            return OverlapsSphere_(nmin, nmax, center, radius);
+        };
+        Query_(test, test, out);
+    }
+
+    void Bvh::QueryFrustum(const glm::vec4 * planes, std::vector<BvhProxy>& out) const {
+        const auto test = [planes](const glm::vec3& nmin, const glm::vec3& nmax) {
+            return InFrustum_(nmin, nmax, planes);
+        };
+        Query_(test, test, out);
+    }
+
+    void Bvh::QueryRay(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, std::vector<BvhProxy>& out) const {
+        const glm::vec3 invDirection = 1.0f / direction;
+        const auto test = [&origin, &invDirection, maxDistance](const glm::vec3& nmin, const glm::vec3& nmax) {
+            return HitByRay_(nmin, nmax, origin, invDirection, maxDistance);
+        };
+        Query_(test, test, out);
+    }
+
+    template<typename NodeTest, typename LeafTest>
+    void Bvh::Query_(const NodeTest& nodeTest, const LeafTest& leafTest, std::vector<BvhProxy>& out) const {
+        if (root_ == NullNode_) return;
+
+        // Depth first traversal never holds more than height + 1 nodes at once
+        constexpr size_t localStackSize = 64;
+        uint32_t localStack[localStackSize];
+        std::vector<uint32_t> heapStack;
+        uint32_t * stack = localStack;
+        if (size_t(Height()) + 1 > localStackSize) {
+            heapStack.resize(size_t(Height()) + 1);
+            stack = heapStack.data();
+        }
+
+        size_t size = 0;
+        stack[size++] = root_;
+        while (size > 0) {
+            const uint32_t index = stack[--size];
+            const Node_& node = nodes_[index];
+            if (!nodeTest(node.vmin, node.vmax)) continue;
+
+            if (node.IsLeaf()) {
+                if (leafTest(node.leafMin, node.leafMax)) out.push_back(index);
+            }
+            else {
+                stack[size++] = node.left;
+                stack[size++] = node.right;
+            }
+        }
+    }
+
+    uint32_t Bvh::AllocateNode_() {
+        uint32_t index;
+        if (freeList_ == NullNode_) {
+            index = uint32_t(nodes_.size());
+            nodes_.push_back(Node_());
+        }
+        else {
+            index = freeList_;
+            freeList_ = nodes_[index].parent;
+            nodes_[index] = Node_();
+        }
+        return index;
+    }
+
+    void Bvh::FreeNode_(const uint32_t index) {
+        nodes_[index].height = -1;
+        nodes_[index].parent = freeList_;
+        freeList_ = index;
+    }
+
+    void Bvh::FattenLeaf_(Node_& leaf) const {
+        leaf.vmin = leaf.leafMin - glm::vec3(margin_);
+        leaf.vmax = leaf.leafMax + glm::vec3(margin_);
+    }
+
+    void Bvh::InsertLeaf_(const uint32_t leaf) {
+        if (root_ == NullNode_) {
+            root_ = leaf;
+            nodes_[leaf].parent = NullNode_;
+            return;
+        }
+
+        // Walk down picking whichever child grows the least by adding the leaf, stopping early
+        // if pairing with the current node is cheaper (see Box2D's b2DynamicTree::InsertLeaf)
+        const glm::vec3 leafMin = nodes_[leaf].vmin;
+        const glm::vec3 leafMax = nodes_[leaf].vmax;
+        uint32_t index = root_;
+        while (!nodes_[index].IsLeaf()) {
+            const Node_& node = nodes_[index];
+            const float area = Area_(node.vmin, node.vmax);
+            const float combinedArea = Area_(glm::min(node.vmin, leafMin), glm::max(node.vmax, leafMax));
+
+            // Cost of creating a new parent for this node and the leaf
+            const float cost = 2.0f * combinedArea;
+            // Minimum cost of pushing the leaf further down the tree
+            const float inheritanceCost = 2.0f * (combinedArea - area);
+
+            const auto descendCost = [this, &leafMin, &leafMax, inheritanceCost](const uint32_t child) {
+                const Node_& c = nodes_[child];
+                const float newArea = Area_(glm::min(c.vmin, leafMin), glm::max(c.vmax, leafMax));
+                if (c.IsLeaf()) return newArea + inheritanceCost;
+                return (newArea - Area_(c.vmin, c.vmax)) + inheritanceCost;
+            };
+
+            const float costLeft = descendCost(node.left);
+            const float costRight = descendCost(node.right);
+            if (cost < costLeft && cost < costRight) break;
+
+            index = costLeft < costRight ? node.left : node.right;
+        }
+
+        const uint32_t sibling = index;
+        const uint32_t oldParent = nodes_[sibling].parent;
+        const uint32_t newParent = AllocateNode_();
+
+        Node_& parent = nodes_[newParent];
+        parent.parent = oldParent;
+        parent.left = sibling;
+        parent.right = leaf;
+        parent.vmin = glm::min(nodes_[sibling].vmin, leafMin);
+        parent.vmax = glm::max(nodes_[sibling].vmax, leafMax);
+        parent.height = nodes_[sibling].height + 1;
+
+        if (oldParent != NullNode_) {
+            if (nodes_[oldParent].left == sibling) nodes_[oldParent].left = newParent;
+            else nodes_[oldParent].right = newParent;
+        }
+        else {
+            root_ = newParent;
+        }
+
+        nodes_[sibling].parent = newParent;
+        nodes_[leaf].parent = newParent;
+
+        RefitAncestors_(oldParent);
+    }
+
+    void Bvh::RemoveLeaf_(const uint32_t leaf) {
+        if (leaf == root_) {
+            root_ = NullNode_;
+            return;
+        }
+
+        const uint32_t parent = nodes_[leaf].parent;
+        const uint32_t grandParent = nodes_[parent].parent;
+        const uint32_t sibling = nodes_[parent].left == leaf ? nodes_[parent].right : nodes_[parent].left;
+
+        // Sibling takes the parent's place
+        if (grandParent != NullNode_) {
+            if (nodes_[grandParent].left == parent) nodes_[grandParent].left = sibling;
+            else nodes_[grandParent].right = sibling;
+        }
+        else {
+            root_ = sibling;
+        }
+        nodes_[sibling].parent = grandParent;
+        FreeNode_(parent);
+
+        RefitAncestors_(grandParent);
+    }
+
+    void Bvh::RefitAncestors_(uint32_t index) {
+        while (index != NullNode_) {
+            index = Balance_(index);
+
+            Node_& node = nodes_[index];
+            const Node_& left = nodes_[node.left];
+            const Node_& right = nodes_[node.right];
+            node.height = 1 + std::max<int32_t>(left.height, right.height);
+            node.vmin = glm::min(left.vmin, right.vmin);
+            node.vmax = glm::max(left.vmax, right.vmax);
+
+            index = node.parent;
+        }
+    }
+
+    // Performs a left or right rotation if the subtree rooted at a is imbalanced and returns the
+    // new subtree root (see Box2D's b2DynamicTree::Balance)
+    uint32_t Bvh::Balance_(const uint32_t ia) {
+        Node_& a = nodes_[ia];
+        if (a.IsLeaf() || a.height < 2) return ia;
+
+        const uint32_t ib = a.left;
+        const uint32_t ic = a.right;
+        Node_& b = nodes_[ib];
+        Node_& c = nodes_[ic];
+
+        const int32_t balance = c.height - b.height;
+
+        // Rotates child up to replace a, returning the new subtree root. other is a's child which stays
+        // with it. One of child's children goes to a to fill the slot child used to occupy.
+        const auto rotate = [this, ia, &a](const uint32_t ichild, Node_& child, Node_& other) {
+            const uint32_t ig1 = child.left;
+            const uint32_t ig2 = child.right;
+            Node_& g1 = nodes_[ig1];
+            Node_& g2 = nodes_[ig2];
+
+            child.left = ia;
+            child.parent = a.parent;
+            a.parent = ichild;
+
+            if (child.parent != NullNode_) {
+                if (nodes_[child.parent].left == ia) nodes_[child.parent].left = ichild;
+                else nodes_[child.parent].right = ichild;
+            }
+            else {
+                root_ = ichild;
+            }
+
+            // Keep the taller grandchild next to the rotated node and hand the shorter one to a
+            const bool keepFirst = g1.height > g2.height;
+            const uint32_t ikeep = keepFirst ? ig1 : ig2;
+            const uint32_t igive = keepFirst ? ig2 : ig1;
+            Node_& keep = nodes_[ikeep];
+            Node_& give = nodes_[igive];
+
+            child.right = ikeep;
+            if (a.left == ichild) a.left = igive;
+            else a.right = igive;
+            give.parent = ia;
+
+            a.vmin = glm::min(other.vmin, give.vmin);
+            a.vmax = glm::max(other.vmax, give.vmax);
+            a.height = 1 + std::max<int32_t>(other.height, give.height);
+            child.vmin = glm::min(a.vmin, keep.vmin);
+            child.vmax = glm::max(a.vmax, keep.vmax);
+            child.height = 1 + std::max<int32_t>(a.height, keep.height);
+
+            return ichild;
+        };
+
+        // Rotate c up
+        if (balance > 1) return rotate(ic, c, b);
+        // Rotate b up
+        if (balance < -1) return rotate(ib, b, c);
+
+        return ia;
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "glm/glm.hpp"
+#include "StratusGpuCommon.h"
+
+namespace stratus {
+    // Handle to a box stored in a Bvh. Proxies stay valid until they are removed and are
+    // reused afterwards, so they are small and dense enough to index into arrays.
+    typedef uint32_t BvhProxy;
+    constexpr BvhProxy NullBvhProxy = BvhProxy(-1);
+
+    // Dynamic bounding volume hierarchy over world space AABBs (see the "Dynamic AABB Tree" of
+    // Box2D and Bullet's btDbvt).
+    //
+    // Leaves store the box they were given plus a fattened copy which the tree is built from.
+    // Updating a box which still fits inside its fattened bounds only touches the leaf, otherwise
+    // the leaf is reinserted with new fat bounds and its ancestors are refit. Insertion picks the
+    // sibling which increases surface area the least and tree rotations keep the height balanced,
+    // so moving a few objects per frame never requires a full rebuild.
+    //
+    // Queries test against the fattened bounds on the way down and the exact bounds at the leaves,
+    // so results never contain false positives from the fattening.
+    //
+    // Not thread safe.
+    class Bvh final {
+    public:
+        // margin is how far (in world units) each side of a leaf is grown when it is (re)inserted
+        explicit Bvh(const float margin = 1.0f);
+
+        BvhProxy Insert(const GpuAABB&, const uint64_t userData = 0);
+        // Returns false if the proxy was not present
+        bool Remove(const BvhProxy);
+        // Returns true if the leaf had to be reinserted
+        bool Update(const BvhProxy, const GpuAABB&);
+        void Clear();
+
+        bool Contains(const BvhProxy) const;
+        // Exact bounds the proxy was last inserted/updated with
+        GpuAABB GetAABB(const BvhProxy) const;
+        uint64_t GetUserData(const BvhProxy) const;
+        size_t Size() const;
+        // Height of the root (0 for a single leaf, -1 when empty)
+        int32_t Height() const;
+
+        // Each query appends every proxy whose bounds pass the test to out
+        void QueryAabb(const GpuAABB&, std::vector<BvhProxy>& out) const;
+        void QuerySphere(const glm::vec3& center, const float radius, std::vector<BvhProxy>& out) const;
+        // planes are the 6 inward facing frustum planes, same as IsAabbInFrustum
+        void QueryFrustum(const glm::vec4 * planes, std::vector<BvhProxy>& out) const;
+        // Every proxy hit by the segment origin + t * direction for t in [0, maxDistance]. direction
+        // does not have to be normalized (maxDistance is in multiples of its length). Unordered.
+        void QueryRay(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance, std::vector<BvhProxy>& out) const;
+
+    private:
+        static constexpr uint32_t NullNode_ = uint32_t(-1);
+
+        struct Node_ {
+            // Fat bounds for leaves, union of children otherwise
+            glm::vec3 vmin;
+            glm::vec3 vmax;
+            // Exact bounds (leaves only)
+            glm::vec3 leafMin;
+            glm::vec3 leafMax;
+            uint64_t userData = 0;
+            // Doubles as the next free node when the node is not in use
+            uint32_t parent = NullNode_;
+            uint32_t left = NullNode_;
+            uint32_t right = NullNode_;
+            // 0 for leaves, -1 for free nodes
+            int32_t height = -1;
+
+            bool IsLeaf() const { return left == NullNode_; }
+        };
+
+        uint32_t AllocateNode_();
+        void FreeNode_(const uint32_t);
+        void InsertLeaf_(const uint32_t);
+        void RemoveLeaf_(const uint32_t);
+        // Recomputes bounds and heights from index up to the root, rebalancing along the way
+        void RefitAncestors_(uint32_t);
+        uint32_t Balance_(const uint32_t);
+        void FattenLeaf_(Node_&) const;
+
+        // Depth first traversal which descends into nodes passing nodeTest and appends leaves
+        // passing leafTest
+        template<typename NodeTest, typename LeafTest>
+        void Query_(const NodeTest&, const LeafTest&, std::vector<BvhProxy>&) const;
+
+    private:
+        std::vector<Node_> nodes_;
+        uint32_t root_ = NullNode_;
+        uint32_t freeList_ = NullNode_;
+        size_t numLeaves_ = 0;
+        float margin_;
+    };
+}
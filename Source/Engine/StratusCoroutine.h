@@ -0,0 +1,205 @@
+#pragma once
+
+// Coroutine support requires C++20. When building as C++17 this header is empty.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define STRATUS_COROUTINES_ENABLED 1
+
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include "StratusAsync.h"
+#include "StratusTaskSystem.h"
+#include "StratusApplicationThread.h"
+
+namespace stratus {
+    // Allows for co_await on an Async<E>. The coroutine resumes directly on whichever thread completes
+    // the Async and receives the completed Async (which may have failed).
+    template<typename E>
+    struct AsyncAwaiter_ {
+        Async<E> as;
+
+        bool await_ready() const {
+            return as.Completed();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) const {
+            AsyncOps_<E>::OnComplete(as, [handle]() { handle.resume(); });
+        }
+
+        Async<E> await_resume() const {
+            return as;
+        }
+    };
+
+    template<typename E>
+    AsyncAwaiter_<E> operator co_await(const Async<E>& as) {
+        return AsyncAwaiter_<E>{as};
+    }
+
+    // co_await ResumeOn(thread) moves the rest of the coroutine onto the given thread. It will run
+    // the next time that thread is dispatched.
+    struct ResumeOn {
+        explicit ResumeOn(Thread& thread)
+            : thread(&thread) {}
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const {
+            thread->Queue([handle]() { handle.resume(); });
+        }
+        void await_resume() const {}
+
+        Thread * thread;
+    };
+
+    // co_await ResumeOnTaskThread() moves the rest of the coroutine onto one of the TaskSystem's threads
+    struct ResumeOnTaskThread {
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const {
+            INSTANCE(TaskSystem)->ScheduleTask([handle]() { handle.resume(); });
+        }
+        void await_resume() const {}
+    };
+
+    // co_await ResumeOnApplicationThread() moves the rest of the coroutine onto the application thread
+    // which is needed for anything involving the graphics context
+    struct ResumeOnApplicationThread {
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const {
+            ApplicationThread::Instance()->Queue([handle]() { handle.resume(); });
+        }
+        void await_resume() const {}
+    };
+
+    template<typename E>
+    class Task;
+
+    // Shared by Task<E> and Task<void>. The coroutine starts running immediately on the calling thread and
+    // completes an Async once it finishes, so anything that works with Async (AddCallback, Then, WhenAll,
+    // co_await) works with a Task.
+    template<typename E, typename Derived>
+    struct TaskPromiseBase_ {
+        struct State_ {
+            std::shared_ptr<E> result;
+            std::exception_ptr exception;
+        };
+
+        // Completes the Async after the coroutine frame is gone so continuations can't observe a partially
+        // destroyed coroutine
+        struct FinalAwaiter_ {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<Derived> handle) const noexcept {
+                std::shared_ptr<AsyncImpl_<E>> impl = handle.promise().impl;
+                handle.destroy();
+                impl->Run();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        TaskPromiseBase_()
+            : state(std::make_shared<State_>()) {
+            std::shared_ptr<State_> s = state;
+            if constexpr (std::is_void<E>::value) {
+                impl = std::make_shared<AsyncImpl_<E>>(std::function<void (void)>([s]() {
+                    if (s->exception) std::rethrow_exception(s->exception);
+                }));
+            }
+            else {
+                impl = std::make_shared<AsyncImpl_<E>>(std::function<std::shared_ptr<E> (void)>([s]() {
+                    if (s->exception) std::rethrow_exception(s->exception);
+                    return s->result;
+                }));
+            }
+        }
+
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        FinalAwaiter_ final_suspend() const noexcept { return {}; }
+
+        void unhandled_exception() {
+            // AsyncImpl_ only understands std::exception
+            try {
+                throw;
+            }
+            catch (const std::exception&) {
+                state->exception = std::current_exception();
+            }
+            catch (...) {
+                state->exception = std::make_exception_ptr(std::runtime_error("Unknown exception thrown from Task"));
+            }
+        }
+
+        std::shared_ptr<State_> state;
+        std::shared_ptr<AsyncImpl_<E>> impl;
+    };
+
+    // Coroutine return type. For example:
+    //
+    //      Task<RawTextureData> LoadTexture(std::string file) {
+    //          co_await ResumeOnTaskThread();
+    //          auto data = std::make_shared<RawTextureData>(Decode(file));
+    //          co_await ResumeOnApplicationThread();
+    //          Upload(*data);
+    //          co_return data;
+    //      }
+    template<typename E>
+    class Task {
+    public:
+        struct promise_type : public TaskPromiseBase_<E, promise_type> {
+            Task get_return_object() {
+                return Task(AsyncOps_<E>::FromImpl(this->impl));
+            }
+
+            void return_value(std::shared_ptr<E> result) {
+                this->state->result = std::move(result);
+            }
+
+            void return_value(E * result) {
+                this->state->result = std::shared_ptr<E>(result);
+            }
+        };
+
+        const Async<E>& GetAsync() const { return as_; }
+        operator Async<E>() const { return as_; }
+
+        bool Completed() const { return as_.Completed(); }
+        bool Failed()    const { return as_.Failed(); }
+
+    private:
+        explicit Task(const Async<E>& as)
+            : as_(as) {}
+
+    private:
+        Async<E> as_;
+    };
+
+    template<>
+    class Task<void> {
+    public:
+        struct promise_type : public TaskPromiseBase_<void, promise_type> {
+            Task get_return_object() {
+                return Task(AsyncOps_<void>::FromImpl(this->impl));
+            }
+
+            void return_void() {}
+        };
+
+        const Async<void>& GetAsync() const { return as_; }
+        operator Async<void>() const { return as_; }
+
+        bool Completed() const { return as_.Completed(); }
+        bool Failed()    const { return as_.Failed(); }
+
+    private:
+        explicit Task(const Async<void>& as)
+            : as_(as) {}
+
+    private:
+        Async<void> as_;
+    };
+
+    template<typename E>
+    AsyncAwaiter_<E> operator co_await(const Task<E>& task) {
+        return AsyncAwaiter_<E>{task.GetAsync()};
+    }
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include "StratusCpuTopology.h"
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <exception>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace stratus {
+    size_t CpuTopology::NumCores() const {
+        size_t count = 0;
+        for (const auto& node : nodes) count += node.size();
+        return count;
+    }
+
+    std::vector<uint32_t> CpuTopology::ParseCpuList(const std::string& list) {
+        std::vector<uint32_t> result;
+        std::stringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            // Strips whitespace such as the trailing newline in sysfs files
+            range.erase(std::remove_if(range.begin(), range.end(), [](const char c) { return std::isspace((unsigned char)c); }), range.end());
+            if (range.size() == 0) continue;
+
+            try {
+                const size_t dash = range.find('-');
+                if (dash == std::string::npos) {
+                    result.push_back(uint32_t(std::stoul(range)));
+                    continue;
+                }
+
+                const uint32_t first = uint32_t(std::stoul(range.substr(0, dash)));
+                const uint32_t last = uint32_t(std::stoul(range.substr(dash + 1)));
+                for (uint32_t core = first; core <= last; ++core) result.push_back(core);
+            }
+            catch (const std::exception&) {
+                // Ignore anything malformed
+            }
+        }
+
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    static CpuTopology SingleNodeTopology_(const std::vector<uint32_t>& cores) {
+        CpuTopology topology;
+        if (cores.size() > 0) {
+            topology.nodes.push_back(cores);
+            return topology;
+        }
+
+        const uint32_t count = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+        topology.nodes.push_back({});
+        for (uint32_t core = 0; core < count; ++core) topology.nodes[0].push_back(core);
+        return topology;
+    }
+
+#if defined(_WIN32)
+    // Only processor group 0 (the first 64 logical cores) is considered
+    CpuTopology CpuTopology::Query() {
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) processMask = ~DWORD_PTR(0);
+
+        std::vector<uint32_t> allowed;
+        for (uint32_t core = 0; core < sizeof(DWORD_PTR) * 8; ++core) {
+            if (processMask & (DWORD_PTR(1) << core)) allowed.push_back(core);
+        }
+
+        CpuTopology topology;
+        ULONG highestNode = 0;
+        if (GetNumaHighestNodeNumber(&highestNode)) {
+            for (ULONG node = 0; node <= highestNode; ++node) {
+                ULONGLONG nodeMask = 0;
+                if (!GetNumaNodeProcessorMask(UCHAR(node), &nodeMask)) continue;
+
+                std::vector<uint32_t> cores;
+                for (const uint32_t core : allowed) {
+                    if (nodeMask & (ULONGLONG(1) << core)) cores.push_back(core);
+                }
+                if (cores.size() > 0) topology.nodes.push_back(std::move(cores));
+            }
+        }
+
+        if (topology.nodes.size() == 0) return SingleNodeTopology_(allowed);
+        return topology;
+    }
+
+    bool SetCurrentThreadAffinity(const std::vector<uint32_t>& cores) {
+        DWORD_PTR mask = 0;
+        for (const uint32_t core : cores) {
+            if (core < sizeof(DWORD_PTR) * 8) mask |= DWORD_PTR(1) << core;
+        }
+        if (mask == 0) return false;
+        return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    }
+
+    void SetCurrentThreadOsName(const std::string& name) {
+        const std::wstring wide(name.begin(), name.end());
+        SetThreadDescription(GetCurrentThread(), wide.c_str());
+    }
+
+#elif defined(__linux__)
+    static std::string ReadFile_(const std::string& file) {
+        std::ifstream stream(file);
+        if (!stream.is_open()) return "";
+        std::stringstream contents;
+        contents << stream.rdbuf();
+        return contents.str();
+    }
+
+    CpuTopology CpuTopology::Query() {
+        // Respects taskset/cgroup restrictions
+        std::vector<uint32_t> allowed;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (uint32_t core = 0; core < CPU_SETSIZE; ++core) {
+                if (CPU_ISSET(core, &set)) allowed.push_back(core);
+            }
+        }
+
+        CpuTopology topology;
+        const std::vector<uint32_t> nodeIds = ParseCpuList(ReadFile_("/sys/devices/system/node/online"));
+        for (const uint32_t node : nodeIds) {
+            const std::vector<uint32_t> nodeCores = ParseCpuList(ReadFile_("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+            std::vector<uint32_t> cores;
+            for (const uint32_t core : nodeCores) {
+                if (allowed.size() == 0 || std::binary_search(allowed.begin(), allowed.end(), core)) cores.push_back(core);
+            }
+            if (cores.size() > 0) topology.nodes.push_back(std::move(cores));
+        }
+
+        if (topology.nodes.size() == 0) return SingleNodeTopology_(allowed);
+        return topology;
+    }
+
+    bool SetCurrentThreadAffinity(const std::vector<uint32_t>& cores) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        bool any = false;
+        for (const uint32_t core : cores) {
+            if (core >= CPU_SETSIZE) continue;
+            CPU_SET(core, &set);
+            any = true;
+        }
+        if (!any) return false;
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    void SetCurrentThreadOsName(const std::string& name) {
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    }
+
+#else
+    CpuTopology CpuTopology::Query() {
+        return SingleNodeTopology_({});
+    }
+
+    // Thread affinity is only a hint on macOS and is not exposed by pthreads
+    bool SetCurrentThreadAffinity(const std::vector<uint32_t>&) {
+        return false;
+    }
+
+    void SetCurrentThreadOsName(const std::string& name) {
+#if defined(__APPLE__)
+        pthread_setname_np(name.c_str());
+#endif
+    }
+#endif
+
+    bool CpuSupportsAvx() {
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        // Make sure the OS saves the YMM registers
+        return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#elif defined(__x86_64__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx");
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace stratus {
+    // Logical cores which the process is allowed to run on, grouped by NUMA node. On platforms
+    // where this information is unavailable everything ends up in a single node.
+    struct CpuTopology {
+        // nodes[i] holds the logical core indices belonging to the i'th NUMA node. Nodes without any
+        // usable cores are left out.
+        std::vector<std::vector<uint32_t>> nodes;
+
+        size_t NumCores() const;
+
+        // Queries the operating system
+        static CpuTopology Query();
+        // Parses Linux style cpu lists such as "0-3,8,10-11"
+        static std::vector<uint32_t> ParseCpuList(const std::string&);
+    };
+
+    // Restricts the calling thread to the given logical cores. Returns false if this is not supported
+    // on the current platform or if the request failed.
+    bool SetCurrentThreadAffinity(const std::vector<uint32_t>& cores);
+    // Sets the name which shows up in debuggers and profilers for the calling thread. Some platforms
+    // truncate long names (e.g. Linux allows 15 characters).
+    void SetCurrentThreadOsName(const std::string&);
+    // True if both the CPU and the OS (which has to save the YMM registers) support AVX. Always false
+    // on non-x86 platforms.
+    bool CpuSupportsAvx();
+}
@@ -9,12 +9,36 @@
 #include "StratusTaskSystem.h"
 #include "StratusEntityManager.h"
 #include "StratusGraphicsDriver.h"
+#include "StratusEngineModuleInit.h"
 #include <atomic>
 #include <mutex>
+#include <string>
 
 namespace stratus {
     Engine * Engine::instance_ = nullptr;
 
+    static void ParseTaskSystemArgs(EngineInitParams& params) {
+        TaskSystemConfig& config = params.taskSystemConfig;
+        for (uint32_t i = 0; i < params.numCmdArgs; ++i) {
+            const std::string arg = params.cmdArgs[i];
+            const size_t equals = arg.find('=');
+            if (equals == std::string::npos) continue;
+
+            const std::string name = arg.substr(0, equals);
+            const std::string value = arg.substr(equals + 1);
+            try {
+                if (name == "--task-threads") config.numWorkers = uint32_t(std::stoul(value));
+                else if (name == "--reserved-cores") config.numReservedCores = uint32_t(std::stoul(value));
+                else if (name == "--pin-task-threads") config.pinWorkers = value != "0";
+                else if (name == "--pin-application-thread") config.pinApplicationThread = value != "0";
+                else if (name == "--numa-aware") config.numaAware = value != "0";
+            }
+            catch (const std::exception&) {
+                std::cerr << "Ignoring invalid argument: " << arg << std::endl;
+            }
+        }
+    }
+
     bool Engine::EngineMain(Application * app, const int numArgs, const char ** args) {
         static std::mutex preventMultipleMainCalls;
         std::unique_lock<std::mutex> ul(preventMultipleMainCalls, std::defer_lock);
@@ -26,6 +50,7 @@ namespace stratus {
         EngineInitParams params;
         params.numCmdArgs = numArgs;
         params.cmdArgs = args;
+        ParseTaskSystemArgs(params);
         Application::Instance_() = app;
 
         // Delete the instance in case it's left over from a previous run
@@ -123,26 +148,6 @@ namespace stratus {
         main_ = ApplicationThread::Instance()->thread_.get();
     }
 
-    struct EngineModuleInit {
-        template<typename E>
-        static void InitializeEngineModule(E * instance, const bool log) {
-            if (log) {
-                STRATUS_LOG << "Initializing " << instance->Name() << std::endl;
-            }
-
-            if (!instance->Initialize()) {
-                std::cerr << instance->Name() << " failed to load" << std::endl;
-                exit(-1);
-            }
-        }
-
-        template<typename E>
-        static void InitializeEngineModule(E *& ptr, E * instance, const bool log) {
-            InitializeEngineModule<E>(instance, log);
-            ptr = instance;
-        }
-    };
-
     void Engine::Initialize() {
         // We need to initialize everything on renderer thread
         CHECK_IS_APPLICATION_THREAD();
@@ -166,6 +171,8 @@ namespace stratus {
         // Initialize application last
         EngineModuleInit::InitializeEngineModule(Application::Instance(), true);
 
+        InitFrameGraph_();
+
         STRATUS_LOG << "Initialization complete" << std::endl;
         isInitializing_.store(false);
     }
@@ -191,7 +198,15 @@ namespace stratus {
     }
 
     void Engine::InitTaskSystem_() {
-        EngineModuleInit::InitializeEngineModule(TaskSystem::Instance_(), new TaskSystem(), true);
+        EngineModuleInit::InitializeEngineModule(TaskSystem::Instance_(), new TaskSystem(_params.taskSystemConfig), true);
+
+        // Workers have already been kept off of the reserved cores so the application thread has them to itself
+        const auto& reserved = TaskSystem::Instance()->Layout().reservedCores;
+        if (_params.taskSystemConfig.pinApplicationThread && reserved.size() > 0) {
+            if (!SetCurrentThreadAffinity(reserved)) {
+                STRATUS_WARN << "Unable to pin application thread to its reserved cores" << std::endl;
+            }
+        }
     }
 
     void Engine::InitMaterialManager_() {
@@ -216,6 +231,50 @@ namespace stratus {
         EngineModuleInit::InitializeEngineModule(RendererFrontend::Instance_(), new RendererFrontend(params), true);
     }
 
+    void Engine::InitFrameGraph_() {
+        frameGraph_.Clear();
+
+        const auto addModule = [this](SystemModule * module,
+                                      const FrameJobAffinity affinity,
+                                      const std::vector<std::string>& reads,
+                                      const std::vector<std::string>& writes) {
+            frameGraph_.AddJob(module->Name(), affinity, reads, writes, [module](const double deltaSeconds) {
+                return module->Update(deltaSeconds);
+            });
+        };
+
+        // Modules which touch SDL or the graphics context (or which run entity processes and input handlers
+        // that are free to do so) stay on the application thread. The CPU only halves of the resource manager
+        // and renderer run as separate jobs so that they overlap with the application thread: model load
+        // bookkeeping with everything up until the renderer, and renderer frame setup with the mesh uploads.
+        const auto app = FrameJobAffinity::APPLICATION_THREAD;
+        const auto any = FrameJobAffinity::ANY_THREAD;
+
+        addModule(Log::Instance(),              any, {},                       {"Log"});
+        addModule(InputManager::Instance(),     app, {},                       {"Input"});
+        addModule(EntityManager::Instance(),    app, {"Input"},                {"Entities"});
+        addModule(TaskSystem::Instance(),       any, {},                       {"Tasks"});
+        addModule(MaterialManager::Instance(),  any, {},                       {"Materials"});
+
+        ResourceManager * resources = ResourceManager::Instance();
+        frameGraph_.AddJob("ResourceLoads", any, {"Tasks", "Entities"}, {"ResourceLoads"}, [resources](const double deltaSeconds) {
+            return resources->UpdateLoads_(deltaSeconds);
+        });
+
+        addModule(Window::Instance(),           app, {},                       {"Window", "Input"});
+
+        RendererFrontend * renderer = RendererFrontend::Instance();
+        frameGraph_.AddJob("RendererPrepareFrame", any, {"Window", "Entities"}, {"RendererFrame"}, [renderer](const double deltaSeconds) {
+            return renderer->PrepareFrame_(deltaSeconds);
+        });
+
+        addModule(ResourceManager::Instance(),  app, {"Tasks", "Entities", "Window"},             {"Resources"});
+        addModule(RendererFrontend::Instance(), app, {"Window", "Materials", "RendererFrame"},    {"Renderer", "Entities", "Resources"});
+
+        // Finish with update to application
+        addModule(Application::Instance(), app, {"Log", "Tasks", "Materials", "ResourceLoads"}, {"Input", "Entities", "Resources", "Window", "Renderer"});
+    }
+
     // Should be called before Shutdown()
     void Engine::BeginShutDown() {
         if (IsShuttingDown()) return;
@@ -230,6 +289,8 @@ namespace stratus {
 
         STRATUS_LOG << "Engine shutting down" << std::endl;
 
+        frameGraph_.Clear();
+
         // Application should shut down first
         ShutdownResourceAndDelete_(Application::Instance_());
         ShutdownResourceAndDelete_(TaskSystem::Instance_());
@@ -289,25 +350,8 @@ namespace stratus {
 
         //ul.unlock();
 
-        SystemStatus status;
-        #define UPDATE_MODULE(name)                                     \
-            status = name::Instance()->Update(deltaSeconds);            \
-            if (status != SystemStatus::SYSTEM_CONTINUE) return status;
-
-        // Update core modules
-        UPDATE_MODULE(Log)
-        UPDATE_MODULE(InputManager)
-        UPDATE_MODULE(EntityManager)
-        UPDATE_MODULE(TaskSystem)
-        UPDATE_MODULE(MaterialManager)
-        UPDATE_MODULE(ResourceManager)
-        UPDATE_MODULE(Window)
-        UPDATE_MODULE(RendererFrontend)
-
-        // Finish with update to application
-        return Application::Instance()->Update(deltaSeconds);
-
-        #undef UPDATE_MODULE
+        // Update core modules followed by the application
+        return frameGraph_.Execute(deltaSeconds);
     }
 
     // Main thread is where both engine + application run
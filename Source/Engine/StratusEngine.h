@@ -9,6 +9,8 @@
 #include "StratusHandle.h"
 #include "StratusApplication.h"
 #include "StratusSystemStatus.h"
+#include "StratusFrameGraph.h"
+#include "StratusTaskSystem.h"
 #include <shared_mutex>
 #include <memory>
 #include <atomic>
@@ -34,6 +36,13 @@ namespace stratus {
         uint32_t           numCmdArgs;
         const char **      cmdArgs;
         uint32_t           maxFrameRate = 1000;
+        // Can be overridden from the command line with:
+        //      --task-threads=<count>
+        //      --reserved-cores=<count>
+        //      --pin-task-threads=<0|1>
+        //      --pin-application-thread=<0|1>
+        //      --numa-aware=<0|1>
+        TaskSystemConfig   taskSystemConfig;
     };
 
     struct EngineStatistics {
@@ -99,6 +108,7 @@ namespace stratus {
         void InitResourceManager_();
         void InitWindow_();
         void InitRenderer_();
+        void InitFrameGraph_();
 
         template<typename E>
         static void DeleteResource_(E *& ptr) {
@@ -118,6 +128,8 @@ namespace stratus {
         EngineStatistics stats_;
         EngineInitParams _params;
         Thread * main_;
+        // Per-frame module updates
+        FrameGraph frameGraph_;
         std::atomic<bool> isInitializing_{false};
         std::atomic<bool> isShuttingDown_{false};
 
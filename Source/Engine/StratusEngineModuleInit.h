@@ -0,0 +1,45 @@
+#pragma once
+
+#include <iostream>
+#include <cstdlib>
+#include "StratusLog.h"
+
+namespace stratus {
+    // Constructs and initializes engine modules through the private Instance_() each one has. Besides
+    // the Engine this lets tests stand up individual modules (for example a TaskSystem) on their own.
+    struct EngineModuleInit {
+        template<typename E>
+        static void InitializeEngineModule(E * instance, const bool log) {
+            if (log) {
+                STRATUS_LOG << "Initializing " << instance->Name() << std::endl;
+            }
+
+            if (!instance->Initialize()) {
+                std::cerr << instance->Name() << " failed to load" << std::endl;
+                exit(-1);
+            }
+        }
+
+        template<typename E>
+        static void InitializeEngineModule(E *& ptr, E * instance, const bool log) {
+            InitializeEngineModule<E>(instance, log);
+            ptr = instance;
+        }
+
+        // Creates E from args and makes it the instance returned by E::Instance()
+        template<typename E, typename ... Types>
+        static void CreateEngineModule(const bool log, const Types&... args) {
+            InitializeEngineModule<E>(E::Instance_(), new E(args...), log);
+        }
+
+        // Undoes CreateEngineModule
+        template<typename E>
+        static void DestroyEngineModule() {
+            E *& ptr = E::Instance_();
+            if (ptr == nullptr) return;
+            ptr->Shutdown();
+            delete ptr;
+            ptr = nullptr;
+        }
+    };
+}
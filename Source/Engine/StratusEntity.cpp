@@ -2,8 +2,18 @@
 #include "StratusEntityManager.h"
 #include "StratusEngine.h"
 #include "StratusPoolAllocator.h"
+#include <atomic>
 
 namespace stratus {
+    EntityComponentId NextEntityComponentId_() {
+        static std::atomic<EntityComponentId> next(0);
+        const EntityComponentId id = next.fetch_add(1);
+        if (id >= MaxEntityComponentTypes) {
+            throw std::runtime_error("Exceeded MaxEntityComponentTypes");
+        }
+        return id;
+    }
+
     EntityPtr Entity::Create() {
         return Create(nullptr);
         //return EntityPtr(new Entity());
@@ -39,8 +49,7 @@ namespace stratus {
 
     EntityComponentSet::~EntityComponentSet() {
         componentManagers_.clear();
-        components_.clear();
-        componentTypeNames_.clear();
+        componentsById_.clear();
     }
 
     void EntityComponentSet::SetOwner_(Entity * owner) {
@@ -50,7 +59,7 @@ namespace stratus {
     Entity::Entity() : Entity(EntityComponentSet::Create()) {}
 
     Entity::Entity(EntityComponentSet * ptr) {
-        handle_ = EntityHandle::NextHandle();
+        handle_ = EntityTable::Instance().Allocate_(this);
         components_ = ptr;
         components_->SetOwner_(this);
     }
@@ -62,6 +71,7 @@ namespace stratus {
     Entity::~Entity() {
         childNodes_.clear();
         EntityComponentSet::Destroy(components_);
+        EntityTable::Instance().Release_(handle_);
     }
 
     bool Entity::IsInWorld() const {
@@ -72,6 +82,8 @@ namespace stratus {
     EntityComponentSet * EntityComponentSet::Copy() const {
         //auto sl = std::shared_lock<std::shared_mutex>(_m);
         EntityComponentSet * copy = EntityComponentSet::Create();
+        copy->componentManagers_.reserve(componentManagers_.size());
+        copy->componentsById_.reserve(componentsById_.size());
         for (const auto& manager : componentManagers_) {
             auto mgrCopy = CopyManager_(manager);
             copy->AttachComponent_(mgrCopy);
@@ -80,14 +92,16 @@ namespace stratus {
     }
 
     void EntityComponentSet::AttachComponent_(std::unique_ptr<EntityComponentPointerManager>& ptr) {
-        EntityComponentView view(ptr->component);
-        const std::string name = view.component->TypeName();
+        EntityComponent * component = ptr->component;
+        const EntityComponentId id = component->ComponentId();
+        if (id >= componentsById_.size()) componentsById_.resize(id + 1, nullptr);
+        componentsById_[id] = component;
+        signature_.set(id);
+        enabled_.set(id);
         componentManagers_.push_back(std::move(ptr));
-        components_.insert(view);
-        componentTypeNames_.insert(std::make_pair(name, std::make_pair(view, EntityComponentStatus::COMPONENT_ENABLED)));
 
         if (owner_ && owner_->IsInWorld()) {
-            INSTANCE(EntityManager)->NotifyComponentsAdded_(owner_->shared_from_this(), view.component);
+            INSTANCE(EntityManager)->NotifyComponentsAdded_(owner_->shared_from_this(), component);
         }
     }
 
@@ -108,9 +122,9 @@ namespace stratus {
     std::vector<EntityComponentPair<EntityComponent>> EntityComponentSet::GetAllComponents() {
         //auto sl = std::shared_lock<std::shared_mutex>(_m);
         std::vector<EntityComponentPair<EntityComponent>> v;
-        v.reserve(components_.size());
-        for (auto& component : componentTypeNames_) {
-            v.push_back(EntityComponentPair<EntityComponent>{component.second.first.component, component.second.second});
+        v.reserve(componentManagers_.size());
+        for (auto& manager : componentManagers_) {
+            v.push_back(GetComponentById_<EntityComponent>(manager->component->ComponentId()));
         }
         return v;
     }
@@ -118,13 +132,21 @@ namespace stratus {
     std::vector<EntityComponentPair<const EntityComponent>> EntityComponentSet::GetAllComponents() const {
         //auto sl = std::shared_lock<std::shared_mutex>(_m);
         std::vector<EntityComponentPair<const EntityComponent>> v;
-        v.reserve(components_.size());
-        for (const auto& component : componentTypeNames_) {
-            v.push_back(EntityComponentPair<const EntityComponent>{component.second.first.component, component.second.second});
+        v.reserve(componentManagers_.size());
+        for (const auto& manager : componentManagers_) {
+            v.push_back(GetComponentById_<const EntityComponent>(manager->component->ComponentId()));
         }
         return v;
     }
 
+    const EntityComponentSignature& EntityComponentSet::Signature() const {
+        return signature_;
+    }
+
+    const EntityComponentSignature& EntityComponentSet::EnabledSignature() const {
+        return enabled_;
+    }
+
     EntityComponentSet& Entity::Components() {
         return *components_;
     }
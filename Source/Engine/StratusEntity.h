@@ -9,7 +9,10 @@
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <bitset>
+#include <cstdint>
 #include "StratusEntityCommon.h"
+#include "StratusEntityTable.h"
 #include "StratusPoolAllocator.h"
 
 template<typename E>
@@ -22,28 +25,45 @@ size_t ClassHashCode() {
     return typeid(E).hash_code();
 }
 
-template<typename Component>
-struct ComponentAllocator_ {
-    std::mutex m;
-    stratus::PoolAllocator<Component> allocator;
-};
+namespace stratus {
+    // Dense integer ID assigned to each component type the first time it is used. These
+    // index directly into EntityComponentSet's storage and signatures.
+    typedef uint32_t EntityComponentId;
+    constexpr size_t MaxEntityComponentTypes = 128;
+    typedef std::bitset<MaxEntityComponentTypes> EntityComponentSignature;
+
+    // Throws if more than MaxEntityComponentTypes component types are used
+    extern EntityComponentId NextEntityComponentId_();
+
+    template<typename Component>
+    EntityComponentId EntityComponentId_() {
+        static const EntityComponentId id = NextEntityComponentId_();
+        return id;
+    }
 
-template<typename Component>
-ComponentAllocator_<Component>& GetComponentAllocator_() {
-    static ComponentAllocator_<Component> allocator;
-    return allocator;
+    // One bit set per component type
+    template<typename ... Components>
+    EntityComponentSignature MakeEntityComponentSignature() {
+        EntityComponentSignature result;
+        (result.set(Components::SComponentId()), ...);
+        return result;
+    }
 }
 
 #define ENTITY_COMPONENT_STRUCT(name)                                                       \
     struct name final : public stratus::EntityComponent {                                   \
         static std::string STypeName() { return ClassName<name>(); }                        \
         static size_t SHashCode() { return ClassHashCode<name>(); }                         \
+        static stratus::EntityComponentId SComponentId() {                                  \
+            return stratus::EntityComponentId_<name>();                                     \
+        }                                                                                   \
         std::string TypeName() const override { return STypeName(); }                       \
         size_t HashCode() const override { return SHashCode(); }                            \
+        stratus::EntityComponentId ComponentId() const override { return SComponentId(); }  \
         bool operator==(const stratus::EntityComponent * other) const override {            \
             if (this == other) return true;                                                 \
             if (!other) return false;                                                       \
-            return TypeName() == std::string(other->TypeName());                            \
+            return ComponentId() == other->ComponentId();                                   \
         }                                                                                   \
         stratus::EntityComponent * Copy() const override {                                  \
             auto ptr = dynamic_cast<stratus::EntityComponent *>(name::Create(*this));       \
@@ -51,21 +71,13 @@ ComponentAllocator_<Component>& GetComponentAllocator_() {
         }                                                                                   \
         template<typename ... Types>                                                        \
         static name * Create(const Types& ... args) {                                       \
-            auto& allocator = GetComponentAllocator_<name>();                               \
-            auto ul = std::unique_lock(allocator.m);                                        \
-            return allocator.allocator.AllocateConstruct(args...);                                   \
+            return stratus::ThreadCachedPoolAllocator<name>::AllocateConstruct(args...);    \
         }                                                                                   \
         static void Destroy(name * ptr) {                                                   \
-            if (ptr == nullptr) return;                                                     \
-            auto& allocator = GetComponentAllocator_<name>();                               \
-            auto ul = std::unique_lock(allocator.m);                                        \
-            allocator.allocator.DestroyDeallocate(ptr);                                            \
+            stratus::ThreadCachedPoolAllocator<name>::DestroyDeallocate(ptr);               \
         }
 
 namespace stratus {
-    class Entity;
-    typedef Handle<Entity> EntityHandle;
-
     enum class EntityComponentStatus : int64_t {
         COMPONENT_ENABLED,
         COMPONENT_DISABLED
@@ -77,6 +89,7 @@ namespace stratus {
         virtual ~EntityComponent() = default;
         virtual std::string TypeName() const = 0;
         virtual size_t HashCode() const = 0;
+        virtual EntityComponentId ComponentId() const = 0;
         virtual bool operator==(const EntityComponent *) const = 0;
 
         virtual EntityComponent * Copy() const = 0;
@@ -92,26 +105,6 @@ namespace stratus {
 
     };
 
-    // Enables an entity component pointer to be inserted into hash set/map
-    struct EntityComponentView {
-        EntityComponent * component = nullptr;
-
-        EntityComponentView(EntityComponent * c = nullptr)
-            : component(c) {}
-
-        size_t HashCode() const {
-            if (!component) return 0;
-            return component->HashCode();
-        }
-
-        bool operator==(const EntityComponentView& other) const {
-            if (component == other.component) return true;
-            if (!component) return false;
-
-            return other.component->operator==(component);
-        }
-    };
-
     struct EntityComponentPointerManager {
         EntityComponent * component = nullptr;
 
@@ -146,15 +139,6 @@ namespace stratus {
     }
 }
 
-namespace std {
-    template<>
-    struct hash<stratus::EntityComponentView> {
-        size_t operator()(const stratus::EntityComponentView & v) const {
-            return v.HashCode();
-        }
-    };
-}
-
 namespace stratus {
     template<typename E>
     struct EntityComponentPair {
@@ -167,6 +151,7 @@ namespace stratus {
     // Guarantee: Component pointers will never move around in memory even when new ones are added
     struct EntityComponentSet final {
         friend class Entity;
+        friend class EntityPrefab;
 
         ~EntityComponentSet();
 
@@ -195,6 +180,11 @@ namespace stratus {
         std::vector<EntityComponentPair<EntityComponent>> GetAllComponents();
         std::vector<EntityComponentPair<const EntityComponent>> GetAllComponents() const;
 
+        // One bit per EntityComponentId for every attached component, and for every attached
+        // component which is also enabled
+        const EntityComponentSignature& Signature() const;
+        const EntityComponentSignature& EnabledSignature() const;
+
         static EntityComponentSet * Create() {
             return new EntityComponentSet();
         }
@@ -209,6 +199,9 @@ namespace stratus {
         template<typename E>
         EntityComponentPair<E> GetComponent_() const;
 
+        template<typename E>
+        EntityComponentPair<E> GetComponentById_(const EntityComponentId) const;
+
         template<typename E>
         EntityComponentPair<E> GetComponentByName_(const std::string&) const;
 
@@ -230,15 +223,16 @@ namespace stratus {
         Entity * owner_;
         // Component pointer managers (allocates and deallocates from shared pool)
         std::vector<std::unique_ptr<EntityComponentPointerManager>> componentManagers_;
-        // List of unique components
-        std::unordered_set<EntityComponentView> components_;
-        // List of components by type name
-        std::unordered_map<std::string, std::pair<EntityComponentView, EntityComponentStatus>> componentTypeNames_;
+        // Indexed by EntityComponentId (nullptr if not attached)
+        std::vector<EntityComponent *> componentsById_;
+        EntityComponentSignature signature_;
+        EntityComponentSignature enabled_;
     };
 
     // Collection of unque ID + configurable component data
     class Entity final : public std::enable_shared_from_this<Entity> {
         friend class EntityManager;
+        friend class EntityPrefab;
 
         Entity();
         Entity(EntityComponentSet *);
@@ -347,8 +341,8 @@ namespace stratus {
 
     template<typename E>
     bool EntityComponentSet::ContainsComponent_() const {
-        std::string name = E::STypeName();
-        return componentTypeNames_.find(name) != componentTypeNames_.end();
+        const EntityComponentId id = E::SComponentId();
+        return signature_.test(id);
     }
 
     template<typename E>
@@ -364,18 +358,30 @@ namespace stratus {
     template<typename E>
     EntityComponentPair<E> EntityComponentSet::GetComponent_() const {
         static_assert(std::is_base_of<EntityComponent, E>::value);
-        std::string name = E::STypeName();
-        return GetComponentByName_<E>(name);
+        return GetComponentById_<E>(E::SComponentId());
+    }
+
+    template<typename E>
+    EntityComponentPair<E> EntityComponentSet::GetComponentById_(const EntityComponentId id) const {
+        static_assert(std::is_base_of<EntityComponent, E>::value);
+        if (!signature_.test(id)) return EntityComponentPair<E>();
+        // The ID uniquely identifies the type so there is no need for dynamic_cast
+        return EntityComponentPair<E>{
+            static_cast<E *>(componentsById_[id]),
+            enabled_.test(id) ? EntityComponentStatus::COMPONENT_ENABLED : EntityComponentStatus::COMPONENT_DISABLED
+        };
     }
 
     template<typename E>
     EntityComponentPair<E> EntityComponentSet::GetComponentByName_(const std::string& name) const {
         static_assert(std::is_base_of<EntityComponent, E>::value);
         //auto sl = std::shared_lock<std::shared_mutex>(_m);
-        auto it = componentTypeNames_.find(name);
-        return it != componentTypeNames_.end() ? 
-            EntityComponentPair<E>{dynamic_cast<E *>(it->second.first.component), it->second.second} : 
-            EntityComponentPair<E>();
+        for (const auto& manager : componentManagers_) {
+            if (manager->component->TypeName() == name) {
+                return GetComponentById_<E>(manager->component->ComponentId());
+            }
+        }
+        return EntityComponentPair<E>();
     }
 
     template<typename E>
@@ -392,11 +398,11 @@ namespace stratus {
     void EntityComponentSet::SetComponentStatus_(EntityComponentStatus status) {
         static_assert(std::is_base_of<EntityComponent, E>::value);
         //auto ul = std::unique_lock<std::shared_mutex>(_m);
-        std::string name = E::STypeName();
-        auto it = componentTypeNames_.find(name);
-        if (it != componentTypeNames_.end()) {
-            if (it->second.second != status) {
-                it->second.second = status;
+        const EntityComponentId id = E::SComponentId();
+        if (signature_.test(id)) {
+            const bool enabled = status == EntityComponentStatus::COMPONENT_ENABLED;
+            if (enabled_.test(id) != enabled) {
+                enabled_.set(id, enabled);
                 NotifyEntityManagerComponentEnabledDisabled_();
             }
         }
@@ -3,6 +3,7 @@
 #include "StratusApplicationThread.h"
 #include "StratusTransformComponent.h"
 #include <algorithm>
+#include <typeinfo>
 
 namespace stratus {
     EntityManager::EntityManager() {}
@@ -26,14 +27,14 @@ namespace stratus {
     }
 
     void EntityManager::AddEntity_(const EntityPtr& e) {
-        entitiesToAdd_.insert(e);
+        pending_.entitiesToAdd.push_back(e);
         for (const EntityPtr& c : e->GetChildNodes()) {
             AddEntity_(c);
         }
     }
 
     void EntityManager::RemoveEntity_(const EntityPtr& e) {
-        entitiesToRemove_.insert(e);    
+        pending_.entitiesToRemove.push_back(e);
         for (const EntityPtr& c : e->GetChildNodes()) {
             RemoveEntity_(c);
         }
@@ -49,38 +50,62 @@ namespace stratus {
     SystemStatus EntityManager::Update(const double deltaSeconds) {
         CHECK_IS_APPLICATION_THREAD();
 
-        // Notify processes of added/removed entities and allow them to
-        // perform their process routine
-        auto entitiesToAdd = std::move(entitiesToAdd_);
-        auto addedComponents = std::move(addedComponents_);
-        auto entitiesToRemove = std::move(entitiesToRemove_);
-        auto componentsEnabledDisabled = std::move(componentsEnabledDisabled_);
-
-        for (auto ptr : entitiesToAdd) ptr->AddToWorld_();
-        for (auto ptr : entitiesToRemove) ptr->RemoveFromWorld_();
-
-        for (EntityProcessPtr& ptr : processes_) {
-            if (entitiesToAdd.size() > 0) ptr->EntitiesAdded(entitiesToAdd);
-            if (addedComponents.size() > 0) ptr->EntityComponentsAdded(addedComponents);
-            if (entitiesToRemove.size() > 0) ptr->EntitiesRemoved(entitiesToRemove);
-            if (componentsEnabledDisabled.size() > 0) ptr->EntityComponentsEnabledDisabled(componentsEnabledDisabled);
-            ptr->Process(deltaSeconds);
+        // Take everything recorded since the last frame. frame_ was cleared at the end of the
+        // last Update so pending_ gets back empty lists which keep their capacity.
+        {
+            std::unique_lock<std::shared_mutex> ul(m_);
+            std::swap(pending_, frame_.changes);
         }
+        frame_.Prepare();
+
+        const ChangeLists_& changes = frame_.changes;
+        for (auto& ptr : changes.entitiesToAdd) ptr->AddToWorld_();
+        for (auto& ptr : changes.entitiesToRemove) ptr->RemoveFromWorld_();
+
+        // Notify processes of added/removed entities
+        for (ProcessEntry_& entry : processes_) {
+            EntityProcessPtr& ptr = entry.process;
+            if (entry.required.none()) {
+                if (changes.entitiesToAdd.size() > 0) ptr->EntitiesAdded(EntityList(changes.entitiesToAdd.data(), changes.entitiesToAdd.size()));
+                if (frame_.componentsAdded.size() > 0) ptr->EntityComponentsAdded(EntityComponentsAddedList(frame_.componentsAdded.data(), frame_.componentsAdded.size()));
+                if (changes.entitiesToRemove.size() > 0) ptr->EntitiesRemoved(EntityList(changes.entitiesToRemove.data(), changes.entitiesToRemove.size()));
+                if (changes.componentsEnabledDisabled.size() > 0) ptr->EntityComponentsEnabledDisabled(EntityList(changes.componentsEnabledDisabled.data(), changes.componentsEnabledDisabled.size()));
+            }
+            else {
+                const FilteredChangeLists_& filtered = frame_.Filter(entry.required);
+                if (filtered.entitiesAdded.size() > 0) ptr->EntitiesAdded(EntityList(filtered.entitiesAdded.data(), filtered.entitiesAdded.size()));
+                if (filtered.componentsAdded.size() > 0) ptr->EntityComponentsAdded(EntityComponentsAddedList(filtered.componentsAdded.data(), filtered.componentsAdded.size()));
+                if (filtered.entitiesRemoved.size() > 0) ptr->EntitiesRemoved(EntityList(filtered.entitiesRemoved.data(), filtered.entitiesRemoved.size()));
+                if (filtered.componentsEnabledDisabled.size() > 0) ptr->EntityComponentsEnabledDisabled(EntityList(filtered.componentsEnabledDisabled.data(), filtered.componentsEnabledDisabled.size()));
+            }
+        }
+
+        // Allow them to perform their process routine
+        if (processGraphDirty_) RebuildProcessGraph_();
+        processGraph_.Execute(deltaSeconds);
 
         // Commit added/removed entities
-        for (auto& e : entitiesToAdd) entities_.insert(e);
-        for (auto& e : entitiesToRemove) entities_.erase(e);
+        for (auto& e : changes.entitiesToAdd) entities_.Insert(e);
+        for (auto& e : changes.entitiesToRemove) entities_.Erase(e);
 
         // If any processes have been added, tell them about all available entities
         // and allow them to perform their process routine for the first time
         auto processesToAdd = std::move(processesToAdd_);
         for (EntityProcessPtr& ptr : processesToAdd) {
-            if (entities_.size() > 0) ptr->EntitiesAdded(entities_);
+            const EntityComponentSignature required = ptr->RequiredComponents();
+
+            auto& existing = frame_.existing;
+            existing.clear();
+            for (auto& e : entities_) {
+                if ((e->Components().Signature() & required) == required) existing.push_back(e);
+            }
+            if (existing.size() > 0) ptr->EntitiesAdded(EntityList(existing.data(), existing.size()));
             ptr->Process(deltaSeconds);
 
             // Commit process to list
-            processes_.push_back(ptr);
+            processes_.push_back(ProcessEntry_{ptr, required, ptr->ComponentAccess()});
             handlesToPtrs_.insert(std::make_pair((EntityProcessHandle)ptr.get(), ptr));
+            processGraphDirty_ = true;
         }
 
         // If any processes have been removed then remove them now
@@ -90,25 +115,167 @@ namespace stratus {
             if (handleIt == handlesToPtrs_.end()) continue;
             auto remove = handleIt->second;
             for (auto it = processes_.begin(); it != processes_.end(); ++it) {
-                EntityProcessPtr process = *it;
-                if (process == remove) {
+                if (it->process == remove) {
                     processes_.erase(it);
+                    processGraphDirty_ = true;
                     break;
                 }
             }
             handlesToPtrs_.erase(handle);
         }
 
+        frame_.Clear();
+
         return SystemStatus::SYSTEM_CONTINUE;
     }
     
     void EntityManager::Shutdown() {
-        entities_.clear();
-        entitiesToAdd_.clear();
-        entitiesToRemove_.clear();
+        processGraph_.Clear();
+        entities_.Clear();
+        pending_.Clear();
+        frame_.Clear();
         processes_.clear();
         processesToAdd_.clear();
-        addedComponents_.clear();
+    }
+
+    void EntityManager::RebuildProcessGraph_() {
+        processGraphDirty_ = false;
+        processGraph_.Clear();
+
+        for (const ProcessEntry_& entry : processes_) {
+            AddEntityProcessJob(processGraph_, entry.process, entry.access);
+        }
+    }
+
+    void AddEntityProcessJob(FrameGraph& graph, const EntityProcessPtr& process, const EntityProcessAccess& access) {
+        // Written by processes with undeclared access and read by everything else so that they
+        // act as a barrier between the processes registered before and after them
+        static const std::string undeclared = "UndeclaredComponentAccess";
+
+        const auto resourceName = [](const size_t id) {
+            return "EntityComponent" + std::to_string(id);
+        };
+
+        std::vector<std::string> reads;
+        std::vector<std::string> writes;
+        FrameJobAffinity affinity;
+        if (access.declared) {
+            affinity = FrameJobAffinity::ANY_THREAD;
+            reads.push_back(undeclared);
+            for (size_t id = 0; id < MaxEntityComponentTypes; ++id) {
+                if (access.writes.test(id)) writes.push_back(resourceName(id));
+                else if (access.reads.test(id)) reads.push_back(resourceName(id));
+            }
+        }
+        else {
+            affinity = FrameJobAffinity::APPLICATION_THREAD;
+            writes.push_back(undeclared);
+        }
+
+        // Named after the process' dynamic type. Bound to a reference first so the typeid operand isn't
+        // an expression with side effects.
+        const EntityProcess& processRef = *process;
+        graph.AddJob(typeid(processRef).name(), affinity, reads, writes, [process](const double deltaSeconds) {
+            process->Process(deltaSeconds);
+            return SystemStatus::SYSTEM_CONTINUE;
+        });
+    }
+
+    // Sorts by handle and removes duplicates
+    static void SortUnique_(std::vector<EntityPtr>& entities) {
+        std::sort(entities.begin(), entities.end(), [](const EntityPtr& a, const EntityPtr& b) {
+            return a->GetHandle() < b->GetHandle();
+        });
+        entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+    }
+
+    static bool HasRequiredComponents_(const EntityPtr& e, const EntityComponentSignature& required) {
+        return (e->Components().Signature() & required) == required;
+    }
+
+    static void FilterEntities_(const std::vector<EntityPtr>& entities, const EntityComponentSignature& required, std::vector<EntityPtr>& out) {
+        for (const auto& e : entities) {
+            if (HasRequiredComponents_(e, required)) out.push_back(e);
+        }
+    }
+
+    void EntityManager::ChangeLists_::Clear() {
+        entitiesToAdd.clear();
+        entitiesToRemove.clear();
+        addedComponents.clear();
+        componentsEnabledDisabled.clear();
+    }
+
+    void EntityManager::FilteredChangeLists_::Clear() {
+        entitiesAdded.clear();
+        entitiesRemoved.clear();
+        componentsAdded.clear();
+        componentsEnabledDisabled.clear();
+        ready = false;
+    }
+
+    void EntityManager::FrameChanges_::Prepare() {
+        SortUnique_(changes.entitiesToAdd);
+        SortUnique_(changes.entitiesToRemove);
+        SortUnique_(changes.componentsEnabledDisabled);
+
+        // Group the added components by entity while keeping the order they were added in
+        auto& added = changes.addedComponents;
+        std::stable_sort(added.begin(), added.end(), [](const auto& a, const auto& b) {
+            return a.first->GetHandle() < b.first->GetHandle();
+        });
+
+        addedComponents.reserve(added.size());
+        for (const auto& entry : added) addedComponents.push_back(entry.second);
+
+        // addedComponents is not resized past this point so the views stay valid
+        for (size_t first = 0; first < added.size();) {
+            size_t last = first + 1;
+            while (last < added.size() && added[last].first == added[first].first) ++last;
+            componentsAdded.push_back(EntityComponentsAddedEntry{
+                added[first].first,
+                ArrayView<EntityComponent *>(addedComponents.data() + first, last - first)
+            });
+            first = last;
+        }
+    }
+
+    const EntityManager::FilteredChangeLists_& EntityManager::FrameChanges_::Filter(const EntityComponentSignature& required) {
+        FilteredChangeLists_ * lists = nullptr;
+        for (auto& entry : filtered) {
+            if (entry.signature == required) {
+                lists = &entry;
+                break;
+            }
+        }
+
+        if (lists == nullptr) {
+            filtered.push_back(FilteredChangeLists_());
+            lists = &filtered.back();
+            lists->signature = required;
+        }
+
+        // Already filtered for an earlier process this frame
+        if (lists->ready) return *lists;
+        lists->ready = true;
+
+        FilterEntities_(changes.entitiesToAdd, required, lists->entitiesAdded);
+        FilterEntities_(changes.entitiesToRemove, required, lists->entitiesRemoved);
+        FilterEntities_(changes.componentsEnabledDisabled, required, lists->componentsEnabledDisabled);
+        for (const auto& entry : componentsAdded) {
+            if (HasRequiredComponents_(entry.entity, required)) lists->componentsAdded.push_back(entry);
+        }
+
+        return *lists;
+    }
+
+    void EntityManager::FrameChanges_::Clear() {
+        changes.Clear();
+        addedComponents.clear();
+        componentsAdded.clear();
+        existing.clear();
+        // Keep the entries (and their memory) around since the same processes will ask again next frame
+        for (auto& entry : filtered) entry.Clear();
     }
     
     void EntityManager::RegisterEntityProcess_(EntityProcessPtr& ptr) {
@@ -123,17 +290,11 @@ namespace stratus {
     
     void EntityManager::NotifyComponentsAdded_(const EntityPtr& ptr, EntityComponent * component) {
         std::unique_lock<std::shared_mutex> ul(m_);
-        auto it = addedComponents_.find(ptr);
-        if (it == addedComponents_.end()) {
-            addedComponents_.insert(std::make_pair(ptr, std::vector<EntityComponent *>{component}));
-        }
-        else {
-            it->second.push_back(component);
-        }
+        pending_.addedComponents.push_back(std::make_pair(ptr, component));
     }
 
     void EntityManager::NotifyComponentsEnabledDisabled_(const EntityPtr& ptr) {
         std::unique_lock<std::shared_mutex> ul(m_);
-        componentsEnabledDisabled_.insert(ptr);
+        pending_.componentsEnabledDisabled.push_back(ptr);
     }
 }
\ No newline at end of file
@@ -11,6 +11,8 @@
 #include <vector>
 #include "StratusEntityCommon.h"
 #include "StratusEntityProcess.h"
+#include "StratusEntitySet.h"
+#include "StratusFrameGraph.h"
 
 namespace stratus {
     SYSTEM_MODULE_CLASS(EntityManager)
@@ -34,10 +36,59 @@ namespace stratus {
         SystemStatus Update(const double) override;
         void Shutdown() override;
 
+    private:
+        // Changes recorded between two calls to Update. Plain vectors which may contain duplicates
+        // until they are prepared at the start of Update.
+        struct ChangeLists_ {
+            std::vector<EntityPtr> entitiesToAdd;
+            std::vector<EntityPtr> entitiesToRemove;
+            std::vector<std::pair<EntityPtr, EntityComponent *>> addedComponents;
+            std::vector<EntityPtr> componentsEnabledDisabled;
+
+            void Clear();
+        };
+
+        // Change lists after filtering against a process' required components
+        struct FilteredChangeLists_ {
+            EntityComponentSignature signature;
+            std::vector<EntityPtr> entitiesAdded;
+            std::vector<EntityPtr> entitiesRemoved;
+            std::vector<EntityComponentsAddedEntry> componentsAdded;
+            std::vector<EntityPtr> componentsEnabledDisabled;
+            // Set once the lists hold this frame's data
+            bool ready = false;
+
+            void Clear();
+        };
+
+        // Per-frame arena for the change lists handed to processes. Everything is cleared at the end of
+        // the frame but keeps its capacity so a steady state frame does not allocate.
+        struct FrameChanges_ {
+            ChangeLists_ changes;
+            // Components from changes.addedComponents grouped by entity
+            std::vector<EntityComponent *> addedComponents;
+            std::vector<EntityComponentsAddedEntry> componentsAdded;
+            // One entry per distinct non-empty process signature
+            std::vector<FilteredChangeLists_> filtered;
+            // Entities handed to newly registered processes
+            std::vector<EntityPtr> existing;
+
+            void Prepare();
+            const FilteredChangeLists_& Filter(const EntityComponentSignature&);
+            void Clear();
+        };
+
+        struct ProcessEntry_ {
+            EntityProcessPtr process;
+            EntityComponentSignature required;
+            EntityProcessAccess access;
+        };
+
     private:
         void RegisterEntityProcess_(EntityProcessPtr&);
         void AddEntity_(const EntityPtr&);
         void RemoveEntity_(const EntityPtr&);
+        void RebuildProcessGraph_();
 
     private:
         // Meant to be called by Entity
@@ -47,24 +98,28 @@ namespace stratus {
     private:
         mutable std::shared_mutex m_;
         // All entities currently tracked
-        std::unordered_set<EntityPtr> entities_;
-        // Entities added within the last frame
-        std::unordered_set<EntityPtr> entitiesToAdd_;
-        // Entities which are pending removal (removed during Update)
-        std::unordered_set<EntityPtr> entitiesToRemove_;
+        EntitySet entities_;
+        // Changes made since the last Update (guarded by m_)
+        ChangeLists_ pending_;
+        // Changes being processed by the current Update
+        FrameChanges_ frame_;
         // Processes removed within last frame
         std::unordered_set<EntityProcessHandle> processesToRemove_;
         // Processes added within last frame
         std::vector<EntityProcessPtr> processesToAdd_;
         // Systems which operate on entities
-        std::vector<EntityProcessPtr> processes_;
+        std::vector<ProcessEntry_> processes_;
         // Convert handle to process ptr
         std::unordered_map<EntityProcessHandle, EntityProcessPtr> handlesToPtrs_;
-        // Component change lists
-        std::unordered_map<EntityPtr, std::vector<EntityComponent *>> addedComponents_;
-        std::unordered_set<EntityPtr> componentsEnabledDisabled_;
+        // Runs Process for everything in processes_ based on their declared component access
+        FrameGraph processGraph_;
+        bool processGraphDirty_ = true;
     };
 
+    // Adds the job EntityManager runs process with each frame. Jobs have to be added in registration order
+    // (see EntityProcess::ComponentAccess for how they are ordered against each other).
+    void AddEntityProcessJob(FrameGraph&, const EntityProcessPtr&, const EntityProcessAccess&);
+
     template<typename E, typename ... Types>
     EntityProcessHandle EntityManager::RegisterEntityProcess(const Types&... args) {
         static_assert(std::is_base_of<EntityProcess, E>::value);
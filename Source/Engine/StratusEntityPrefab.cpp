@@ -0,0 +1,65 @@
+#include "StratusEntityPrefab.h"
+#include "StratusPoolAllocator.h"
+
+namespace stratus {
+    EntityPrefab::EntityPrefab(const EntityPtr& root) {
+        Flatten_(root, NullParent_);
+    }
+
+    EntityPrefabPtr EntityPrefab::Create(const EntityPtr& root) {
+        if (root == nullptr) {
+            throw std::runtime_error("Cannot create EntityPrefab from null entity");
+        }
+        return EntityPrefabPtr(new EntityPrefab(root));
+    }
+
+    EntityPrefab::~EntityPrefab() {
+        for (auto& node : nodes_) {
+            EntityComponentSet::Destroy(node.components);
+        }
+        nodes_.clear();
+    }
+
+    void EntityPrefab::Flatten_(const EntityPtr& entity, const uint32_t parent) {
+        const uint32_t index = uint32_t(nodes_.size());
+        {
+            auto sl = std::shared_lock<std::shared_mutex>(entity->m_);
+            nodes_.push_back(Node_{entity->components_->Copy(), parent, uint32_t(entity->childNodes_.size())});
+        }
+
+        const auto& children = entity->GetChildNodes();
+        for (const auto& child : children) {
+            Flatten_(child, index);
+        }
+    }
+
+    EntityPtr EntityPrefab::Instantiate() const {
+        if (nodes_.size() == 1) return Entity::Create(nodes_[0].components->Copy());
+
+        // Parents always come before children so entities can be linked as they are created
+        std::vector<EntityPtr> created;
+        created.reserve(nodes_.size());
+        for (const auto& node : nodes_) {
+            auto entity = Entity::Create(node.components->Copy());
+            entity->childNodes_.reserve(node.numChildren);
+            if (node.parent != NullParent_) {
+                const EntityPtr& parent = created[node.parent];
+                parent->childNodes_.push_back(entity);
+                entity->parent_ = parent;
+            }
+            created.push_back(std::move(entity));
+        }
+        return created[0];
+    }
+
+    void EntityPrefab::Instantiate(const size_t count, std::vector<EntityPtr>& out) const {
+        out.reserve(out.size() + count);
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back(Instantiate());
+        }
+    }
+
+    size_t EntityPrefab::NumNodes() const {
+        return nodes_.size();
+    }
+}
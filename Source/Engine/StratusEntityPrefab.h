@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "StratusEntity.h"
+#include "StratusEntityCommon.h"
+
+namespace stratus {
+    class EntityPrefab;
+    typedef std::shared_ptr<const EntityPrefab> EntityPrefabPtr;
+
+    // Immutable template for stamping out many copies of the same entity tree (props, default
+    // shapes, models which are placed many times).
+    //
+    // The source tree is copied once when the prefab is created and flattened into an array, so
+    // instantiating never walks or locks the source entities. Components are copied per instance
+    // the same way Entity::Copy does it, but components which hold large read-only data share it
+    // with the template (RenderComponent's meshes and materials), which leaves transforms and
+    // other small per-instance state as the only thing an instance owns.
+    //
+    // Instantiate is thread safe.
+    class EntityPrefab final {
+        struct Node_ {
+            EntityComponentSet * components;
+            // Index into nodes_ (or NullParent_ for the root)
+            uint32_t parent;
+            uint32_t numChildren;
+        };
+
+        static constexpr uint32_t NullParent_ = uint32_t(-1);
+
+        EntityPrefab(const EntityPtr&);
+
+    public:
+        // Snapshot of the entity and all of its children. Later changes to the source entity
+        // do not affect the prefab.
+        static EntityPrefabPtr Create(const EntityPtr&);
+
+        ~EntityPrefab();
+
+        EntityPrefab(EntityPrefab&&) = delete;
+        EntityPrefab(const EntityPrefab&) = delete;
+        EntityPrefab& operator=(EntityPrefab&&) = delete;
+        EntityPrefab& operator=(const EntityPrefab&) = delete;
+
+        // Returns the root of a new entity tree
+        EntityPtr Instantiate() const;
+        // Appends count new roots
+        void Instantiate(const size_t count, std::vector<EntityPtr>& out) const;
+
+        // Number of entities in each instance (root + all children)
+        size_t NumNodes() const;
+
+    private:
+        void Flatten_(const EntityPtr&, const uint32_t parent);
+
+    private:
+        // Pre-order so that every parent comes before its children
+        std::vector<Node_> nodes_;
+    };
+}
@@ -4,17 +4,85 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
+#include <cstddef>
 #include "StratusEntityCommon.h"
+#include "StratusEntity.h"
 
 namespace stratus {
+    // Read-only view of a contiguous array which is owned by someone else
+    template<typename E>
+    struct ArrayView {
+        ArrayView() = default;
+        ArrayView(const E * data, const size_t size)
+            : data_(data), size_(size) {}
+
+        const E * begin() const { return data_; }
+        const E * end() const { return data_ + size_; }
+        const E& operator[](const size_t index) const { return data_[index]; }
+        const E * data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+    private:
+        const E * data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Change lists passed to an EntityProcess. They point into per-frame memory owned by
+    // the EntityManager which is reused every frame, so they are only valid until the call
+    // returns. Each entity shows up at most once per list.
+    typedef ArrayView<EntityPtr> EntityList;
+
+    // An entity along with every component which was attached to it during the last frame
+    struct EntityComponentsAddedEntry {
+        EntityPtr entity;
+        ArrayView<EntityComponent *> components;
+    };
+
+    typedef ArrayView<EntityComponentsAddedEntry> EntityComponentsAddedList;
+
+    // Components an EntityProcess reads and writes from inside of Process. A component which is both
+    // read and written only needs to be in writes.
+    struct EntityProcessAccess {
+        // Undeclared access which means the process may touch anything
+        EntityProcessAccess() = default;
+
+        EntityProcessAccess(const EntityComponentSignature& reads, const EntityComponentSignature& writes)
+            : reads(reads), writes(writes), declared(true) {}
+
+        EntityComponentSignature reads;
+        EntityComponentSignature writes;
+        bool declared = false;
+    };
+
     // An entity system process signals to the engine that it wants to be called once
     // per frame in order to operate on certain entity data lists
     struct EntityProcess : public std::enable_shared_from_this<EntityProcess> {
         virtual ~EntityProcess() = default;
 
+        // Only entities which have every component in this signature attached (enabled or not) are
+        // passed to the change notifications below. The EntityManager filters each change list once
+        // per distinct signature and shares the result between processes. The default signature is
+        // empty which means the process sees every entity.
+        //
+        // Queried once when the process is registered.
+        virtual EntityComponentSignature RequiredComponents() const { return EntityComponentSignature(); }
+
+        // Components touched by Process. Processes which declare their access are run on the task threads
+        // and may overlap with any other process whose access does not conflict (one writes a component
+        // the other reads or writes). Processes with conflicting access run in the order they were
+        // registered.
+        //
+        // The default is undeclared access. Those processes run on the application thread after every
+        // process registered before them has finished and before any registered after them have started.
+        //
+        // Queried once when the process is registered.
+        virtual EntityProcessAccess ComponentAccess() const { return EntityProcessAccess(); }
+
         // Gives the system a change to do whatever processing it needs
-        // Guarantee: only one process will be active at a time and may split
-        // the entities it is looping over across as many threads as it wants
+        // Guarantee: the process is never running more than once at a time and may split
+        // the entities it is looping over across as many threads as it wants. See
+        // ComponentAccess for which other processes can be running at the same time.
         //
         // Requirement: when Process returns no entity data is being touched
         // by any other threads
@@ -23,12 +91,12 @@ namespace stratus {
         // Called when an entity is added or removed from the world directly,
         // or when it is attached or detached from a parent entity who is
         // part of the world
-        virtual void EntitiesAdded(const std::unordered_set<stratus::EntityPtr>&) = 0;
-        virtual void EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>&) = 0;
+        virtual void EntitiesAdded(const EntityList&) = 0;
+        virtual void EntitiesRemoved(const EntityList&) = 0;
 
         // Called when an entity has a component added
-        virtual void EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent *>>&) = 0;
+        virtual void EntityComponentsAdded(const EntityComponentsAddedList&) = 0;
         // Called when an entity component is enabled or disabled
-        virtual void EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>&) = 0;
+        virtual void EntityComponentsEnabledDisabled(const EntityList&) = 0;
     };
-}
\ No newline at end of file
+}
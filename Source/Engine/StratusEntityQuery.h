@@ -0,0 +1,174 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+#include "StratusEntity.h"
+#include "StratusEntityCommon.h"
+
+namespace stratus {
+    // Dense table of every entity whose signature contains all of Components (each one attached
+    // and enabled). Rows are stored as parallel arrays, one per component type plus one for the
+    // entities themselves, so a process can sweep them linearly instead of chasing pointers
+    // through a set of entities and looking up each component per entity.
+    //
+    // Component pointers are cached when a row is added. This relies on components never
+    // moving in memory (see EntityComponentSet) - if a component is detached or disabled the
+    // owning process needs to call Refresh or Remove.
+    //
+    // Rows are looked up through a table indexed by EntityHandle::Index() rather than a hash map.
+    //
+    // Not thread safe. Rows are removed by swapping with the last row so order is only stable
+    // until the next Remove, and SortBy can be used to impose an order afterwards.
+    template<typename ... Components>
+    class EntityQuery final {
+        static_assert(sizeof...(Components) > 0);
+        static_assert((std::is_base_of<EntityComponent, Components>::value && ...));
+
+    public:
+        static constexpr size_t NullRow = std::numeric_limits<size_t>::max();
+
+        EntityQuery() = default;
+
+        EntityQuery(EntityQuery&&) = default;
+        EntityQuery(const EntityQuery&) = default;
+        EntityQuery& operator=(EntityQuery&&) = default;
+        EntityQuery& operator=(const EntityQuery&) = default;
+
+        // One bit set per component type in the query
+        static const EntityComponentSignature& Signature() {
+            static const EntityComponentSignature signature = MakeEntityComponentSignature<Components...>();
+            return signature;
+        }
+
+        // True if every component is attached to the entity and enabled
+        static bool Matches(const EntityPtr& e) {
+            const EntityComponentSignature& signature = Signature();
+            return (e->Components().EnabledSignature() & signature) == signature;
+        }
+
+        // Adds the entity if it matches and is not already present. Returns true if a row was added.
+        bool Add(const EntityPtr& e) {
+            if (e == nullptr || Contains(e) || !Matches(e)) return false;
+            const uint32_t index = e->GetHandle().Index();
+            if (index >= rows_.size()) rows_.resize(size_t(index) + 1, NullRow);
+            rows_[index] = entities_.size();
+            entities_.push_back(e);
+            (std::get<std::vector<Components *>>(columns_).push_back(e->Components().template GetComponent<Components>().component), ...);
+            return true;
+        }
+
+        // Returns true if a row was removed
+        bool Remove(const EntityPtr& e) {
+            const size_t row = RowOf(e);
+            if (row == NullRow) return false;
+
+            const size_t last = entities_.size() - 1;
+            rows_[e->GetHandle().Index()] = NullRow;
+            if (row != last) {
+                entities_[row] = std::move(entities_[last]);
+                ((std::get<std::vector<Components *>>(columns_)[row] = std::get<std::vector<Components *>>(columns_)[last]), ...);
+                rows_[entities_[row]->GetHandle().Index()] = row;
+            }
+            entities_.pop_back();
+            (std::get<std::vector<Components *>>(columns_).pop_back(), ...);
+            return true;
+        }
+
+        // Re-evaluates an entity after its components were added, enabled or disabled. Returns
+        // true if the entity is part of the query afterwards.
+        bool Refresh(const EntityPtr& e) {
+            if (e == nullptr) return false;
+            Remove(e);
+            return Add(e);
+        }
+
+        bool Contains(const EntityPtr& e) const {
+            return RowOf(e) != NullRow;
+        }
+
+        // Returns NullRow if the entity is not part of the query
+        size_t RowOf(const EntityHandle handle) const {
+            if (!handle || handle.Index() >= rows_.size()) return NullRow;
+            const size_t row = rows_[handle.Index()];
+            // Compare handles since the slot may have been reused by a different entity
+            if (row == NullRow || entities_[row]->GetHandle() != handle) return NullRow;
+            return row;
+        }
+
+        size_t RowOf(const Entity * e) const {
+            return e != nullptr ? RowOf(e->GetHandle()) : NullRow;
+        }
+
+        size_t RowOf(const EntityPtr& e) const {
+            return RowOf(e.get());
+        }
+
+        size_t Size() const {
+            return entities_.size();
+        }
+
+        void Clear() {
+            for (const auto& e : entities_) rows_[e->GetHandle().Index()] = NullRow;
+            entities_.clear();
+            (std::get<std::vector<Components *>>(columns_).clear(), ...);
+        }
+
+        // Raw arrays of length Size()
+        const EntityPtr * Entities() const {
+            return entities_.data();
+        }
+
+        template<typename Component>
+        Component * const * Column() const {
+            return std::get<std::vector<Component *>>(columns_).data();
+        }
+
+        // Calls function(const EntityPtr&, Components * ...) for every row in order
+        template<typename Function>
+        void ForEach(Function&& function) const {
+            for (size_t row = 0; row < entities_.size(); ++row) {
+                function(entities_[row], std::get<std::vector<Components *>>(columns_)[row]...);
+            }
+        }
+
+        // Stable sort of the rows by key(const EntityPtr&)
+        template<typename Key>
+        void SortBy(Key key) {
+            typedef typename std::decay<decltype(key(std::declval<const EntityPtr&>()))>::type KeyType;
+
+            const size_t size = entities_.size();
+            std::vector<KeyType> keys;
+            keys.reserve(size);
+            for (const auto& e : entities_) keys.push_back(key(e));
+
+            std::vector<size_t> order(size);
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::stable_sort(order.begin(), order.end(), [&keys](const size_t a, const size_t b) {
+                return keys[a] < keys[b];
+            });
+
+            entities_ = Permute_(entities_, order);
+            ((std::get<std::vector<Components *>>(columns_) = Permute_(std::get<std::vector<Components *>>(columns_), order)), ...);
+            for (size_t row = 0; row < size; ++row) rows_[entities_[row]->GetHandle().Index()] = row;
+        }
+
+    private:
+        template<typename E>
+        static std::vector<E> Permute_(std::vector<E>& values, const std::vector<size_t>& order) {
+            std::vector<E> result;
+            result.reserve(values.size());
+            for (const size_t index : order) result.push_back(std::move(values[index]));
+            return result;
+        }
+
+    private:
+        std::vector<EntityPtr> entities_;
+        std::tuple<std::vector<Components *>...> columns_;
+        // EntityHandle::Index() -> row
+        std::vector<size_t> rows_;
+    };
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include "StratusEntity.h"
+#include "StratusEntityCommon.h"
+
+namespace stratus {
+    // Set of entities stored as a dense array with a lookup table indexed by EntityHandle::Index(),
+    // so membership checks are an array access instead of a hash. Iteration order is only
+    // stable until the next Erase since erasing swaps the last entity into the hole.
+    //
+    // Members are stored as EntityPtr on purpose. It stands in for the sets of EntityPtr the engine used
+    // before, whose owners rely on tracked entities staying alive until they are erased.
+    //
+    // Not thread safe.
+    class EntitySet final {
+        static constexpr uint32_t NullPosition_ = std::numeric_limits<uint32_t>::max();
+
+    public:
+        EntitySet() = default;
+
+        EntitySet(EntitySet&&) = default;
+        EntitySet(const EntitySet&) = default;
+        EntitySet& operator=(EntitySet&&) = default;
+        EntitySet& operator=(const EntitySet&) = default;
+
+        // Returns true if the entity was not already present
+        bool Insert(const EntityPtr& e) {
+            if (e == nullptr || Contains(e)) return false;
+            const uint32_t index = e->GetHandle().Index();
+            if (index >= positions_.size()) positions_.resize(size_t(index) + 1, NullPosition_);
+            positions_[index] = uint32_t(entities_.size());
+            entities_.push_back(e);
+            return true;
+        }
+
+        // Returns true if the entity was present
+        bool Erase(const EntityPtr& e) {
+            if (!Contains(e)) return false;
+            const uint32_t index = e->GetHandle().Index();
+            const uint32_t position = positions_[index];
+            const uint32_t last = uint32_t(entities_.size() - 1);
+            if (position != last) {
+                entities_[position] = std::move(entities_[last]);
+                positions_[entities_[position]->GetHandle().Index()] = position;
+            }
+            entities_.pop_back();
+            positions_[index] = NullPosition_;
+            return true;
+        }
+
+        bool Contains(const EntityPtr& e) const {
+            return e != nullptr && Contains(e->GetHandle());
+        }
+
+        bool Contains(const EntityHandle handle) const {
+            if (!handle || handle.Index() >= positions_.size()) return false;
+            const uint32_t position = positions_[handle.Index()];
+            // Compare handles since the slot may have been reused by a different entity
+            return position != NullPosition_ && entities_[position]->GetHandle() == handle;
+        }
+
+        void Clear() {
+            for (const auto& e : entities_) positions_[e->GetHandle().Index()] = NullPosition_;
+            entities_.clear();
+        }
+
+        size_t Size() const { return entities_.size(); }
+        bool Empty() const { return entities_.empty(); }
+
+        const EntityPtr * Entities() const { return entities_.data(); }
+
+        std::vector<EntityPtr>::const_iterator begin() const { return entities_.begin(); }
+        std::vector<EntityPtr>::const_iterator end() const { return entities_.end(); }
+
+    private:
+        std::vector<EntityPtr> entities_;
+        // Handle index -> position within entities_
+        std::vector<uint32_t> positions_;
+    };
+}
@@ -0,0 +1,95 @@
+#include "StratusEntityTable.h"
+#include "StratusEntity.h"
+#include <stdexcept>
+
+namespace stratus {
+    EntityTable::~EntityTable() {
+        for (auto& chunk : chunks_) {
+            delete[] chunk.load();
+        }
+    }
+
+    EntityTable& EntityTable::Instance() {
+        // Leaked on purpose so that entities destroyed during static destruction can still
+        // release their slots
+        static EntityTable * table = new EntityTable();
+        return *table;
+    }
+
+    EntityTable::Slot_ * EntityTable::GetSlot_(const uint32_t index) const {
+        Slot_ * chunk = chunks_[index >> SlotsPerChunkLog2_].load(std::memory_order_acquire);
+        return chunk + (index & (SlotsPerChunk_ - 1));
+    }
+
+    Entity * EntityTable::Resolve(const EntityHandle handle) const {
+        if (!handle || handle.Index() >= numSlots_.load(std::memory_order_acquire)) return nullptr;
+
+        const Slot_ * slot = GetSlot_(handle.Index());
+        Entity * entity = slot->entity.load(std::memory_order_acquire);
+        // Checked after loading the entity so that a slot which was released (and possibly
+        // reused) in between is detected
+        if (slot->generation.load(std::memory_order_acquire) != handle.Generation()) return nullptr;
+        return entity;
+    }
+
+    EntityPtr EntityTable::Lock(const EntityHandle handle) const {
+        // ~Entity has to go through Release_ (and so wait for this lock) before its memory can be reused,
+        // which keeps the entity readable between the generation check and taking a reference
+        std::shared_lock<std::shared_mutex> sl(m_);
+        Entity * entity = Resolve(handle);
+        if (entity == nullptr) return nullptr;
+        // Empty if the entity is in the middle of being destroyed
+        return entity->weak_from_this().lock();
+    }
+
+    size_t EntityTable::NumSlots() const {
+        return numSlots_.load(std::memory_order_acquire);
+    }
+
+    EntityHandle EntityTable::Allocate_(Entity * entity) {
+        std::unique_lock<std::shared_mutex> ul(m_);
+
+        uint32_t index;
+        if (freeSlots_.size() > 0) {
+            index = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        else {
+            index = numSlots_.load(std::memory_order_relaxed);
+            if (index >= MaxEntities) {
+                throw std::runtime_error("Exceeded EntityTable::MaxEntities");
+            }
+
+            auto& chunk = chunks_[index >> SlotsPerChunkLog2_];
+            if (chunk.load(std::memory_order_relaxed) == nullptr) {
+                chunk.store(new Slot_[SlotsPerChunk_], std::memory_order_release);
+            }
+            numSlots_.store(index + 1, std::memory_order_release);
+        }
+
+        Slot_ * slot = GetSlot_(index);
+        // Release_ already moved reused slots on to a new generation. Generation 0 is reserved
+        // for the null handle.
+        uint32_t generation = slot->generation.load(std::memory_order_relaxed);
+        if (generation == 0) generation = 1;
+
+        slot->entity.store(entity, std::memory_order_release);
+        slot->generation.store(generation, std::memory_order_release);
+        return EntityHandle(index, generation);
+    }
+
+    void EntityTable::Release_(const EntityHandle handle) {
+        if (!handle) return;
+
+        std::unique_lock<std::shared_mutex> ul(m_);
+        Slot_ * slot = GetSlot_(handle.Index());
+        if (slot->generation.load(std::memory_order_relaxed) != handle.Generation()) return;
+
+        // Bumping the generation invalidates every outstanding handle to this slot
+        uint32_t generation = handle.Generation() + 1;
+        if (generation == 0) generation = 1;
+        slot->generation.store(generation, std::memory_order_release);
+        slot->entity.store(nullptr, std::memory_order_release);
+        freeSlots_.push_back(handle.Index());
+    }
+}
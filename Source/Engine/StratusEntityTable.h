@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <functional>
+#include "StratusEntityCommon.h"
+
+namespace stratus {
+    // Generational handle to an entity. The low 32 bits are the entity's slot in the EntityTable
+    // and the high 32 bits are the generation of that slot when the entity was created. Slots
+    // are reused once an entity is destroyed but their generation changes, so stale handles
+    // never resolve to the wrong entity.
+    //
+    // Slot indices are dense which means they can be used to index directly into arrays (see
+    // EntitySet and EntityQuery) instead of hashing.
+    class EntityHandle {
+        friend class EntityTable;
+
+        EntityHandle(const uint32_t index, const uint32_t generation)
+            : index_(index), generation_(generation) {}
+
+    public:
+        // Default constructor creates the Null Handle
+        EntityHandle() = default;
+
+        static EntityHandle Null() { return EntityHandle(); }
+
+        uint32_t Index() const { return index_; }
+        uint32_t Generation() const { return generation_; }
+
+        size_t HashCode() const { return std::hash<uint64_t>{}(Integer()); }
+        // Unsigned 64-bit integer representation
+        uint64_t Integer() const { return (uint64_t(generation_) << 32) | uint64_t(index_); }
+
+        bool operator==(const EntityHandle& other) const { return Integer() == other.Integer(); }
+        bool operator!=(const EntityHandle& other) const { return Integer() != other.Integer(); }
+        bool operator< (const EntityHandle& other) const { return Integer() <  other.Integer(); }
+        bool operator<=(const EntityHandle& other) const { return Integer() <= other.Integer(); }
+        bool operator> (const EntityHandle& other) const { return Integer() >  other.Integer(); }
+        bool operator>=(const EntityHandle& other) const { return Integer() >= other.Integer(); }
+        // Generation 0 is never handed out
+        operator bool() const { return generation_ != 0; }
+
+        friend std::ostream& operator<<(std::ostream& os, const EntityHandle& h) {
+            return os << "EntityHandle{" << h.index_ << ", " << h.generation_ << "}";
+        }
+
+    private:
+        uint32_t index_ = 0;
+        uint32_t generation_ = 0;
+    };
+
+    // Dense slot table of every live entity. Entities register themselves on construction and
+    // release their slot when destroyed.
+    //
+    // Slots are stored in fixed size chunks which never move once allocated, so Resolve is lock free and
+    // safe to call from any thread. The table does not keep anything alive though: a resolved pointer is
+    // only valid for as long as something else (such as the EntityManager for entities in the world) holds
+    // a reference to the entity. Lock is safe against the entity being destroyed at the same time.
+    class EntityTable final {
+        friend class Entity;
+
+        static constexpr uint32_t SlotsPerChunkLog2_ = 12;
+        static constexpr uint32_t SlotsPerChunk_ = 1 << SlotsPerChunkLog2_;
+        static constexpr uint32_t MaxChunks_ = 1 << 14;
+
+        struct Slot_ {
+            std::atomic<Entity *> entity{nullptr};
+            std::atomic<uint32_t> generation{0};
+        };
+
+        EntityTable() = default;
+
+    public:
+        // Upper bound on the number of entities which can be alive at once
+        static constexpr size_t MaxEntities = size_t(SlotsPerChunk_) * size_t(MaxChunks_);
+
+        ~EntityTable();
+
+        EntityTable(const EntityTable&) = delete;
+        EntityTable(EntityTable&&) = delete;
+        EntityTable& operator=(const EntityTable&) = delete;
+        EntityTable& operator=(EntityTable&&) = delete;
+
+        static EntityTable& Instance();
+
+        // Returns nullptr if the handle is null or the entity it referred to has been destroyed
+        Entity * Resolve(const EntityHandle) const;
+        // Same as Resolve but returns a new reference to the entity
+        EntityPtr Lock(const EntityHandle) const;
+
+        // Number of slots which have ever been used. Every live handle's Index() is less than this.
+        size_t NumSlots() const;
+
+    private:
+        // Called by Entity
+        EntityHandle Allocate_(Entity *);
+        void Release_(const EntityHandle);
+
+        Slot_ * GetSlot_(const uint32_t index) const;
+
+    private:
+        std::atomic<Slot_ *> chunks_[MaxChunks_] = {};
+        std::atomic<uint32_t> numSlots_{0};
+        // Guards the free list and allocation of new chunks. Lock holds it shared so that entities can't
+        // finish being destroyed underneath it.
+        mutable std::shared_mutex m_;
+        std::vector<uint32_t> freeSlots_;
+    };
+}
+
+namespace std {
+    template<>
+    struct hash<stratus::EntityHandle> {
+        size_t operator()(const stratus::EntityHandle& h) const {
+            return h.HashCode();
+        }
+    };
+}
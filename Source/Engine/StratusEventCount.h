@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace stratus {
+    // An event count allows threads to sleep until some condition becomes true without
+    // needing to hold a lock while checking the condition. Usage from the waiting side:
+    //
+    //      while (true) {
+    //          if (TryGetWork()) break;
+    //          auto key = ec.PrepareWait();
+    //          if (TryGetWork()) { ec.CancelWait(); break; }
+    //          ec.Wait(key);
+    //      }
+    //
+    // The producer side publishes its work and then calls NotifyOne or NotifyAll. Notifications
+    // are nearly free when no threads are waiting.
+    class EventCount {
+    public:
+        typedef uint64_t Key;
+
+        EventCount() = default;
+
+        EventCount(const EventCount&) = delete;
+        EventCount(EventCount&&) = delete;
+        EventCount& operator=(const EventCount&) = delete;
+        EventCount& operator=(EventCount&&) = delete;
+
+        // Registers the calling thread as a waiter. Must be followed by either Wait or CancelWait.
+        Key PrepareWait() {
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            return epoch_.load(std::memory_order_seq_cst);
+        }
+
+        void CancelWait() {
+            waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        // Blocks until a notification happens after the call to PrepareWait that returned key
+        void Wait(const Key key) {
+            {
+                std::unique_lock<std::mutex> ul(mutex_);
+                condition_.wait(ul, [this, key]() { return epoch_.load(std::memory_order_relaxed) != key; });
+            }
+            waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        void NotifyOne() {
+            Notify_(false);
+        }
+
+        void NotifyAll() {
+            Notify_(true);
+        }
+
+    private:
+        void Notify_(const bool all) {
+            // Pairs with the fetch_add in PrepareWait so that either we see the waiter or the
+            // waiter sees the work we published before calling notify
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed) == 0) return;
+
+            {
+                std::unique_lock<std::mutex> ul(mutex_);
+                epoch_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (all) {
+                condition_.notify_all();
+            }
+            else {
+                condition_.notify_one();
+            }
+        }
+
+    private:
+        std::atomic<uint64_t> epoch_{0};
+        std::atomic<uint64_t> waiters_{0};
+        std::mutex mutex_;
+        std::condition_variable condition_;
+    };
+}
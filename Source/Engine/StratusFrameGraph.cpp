@@ -0,0 +1,185 @@
+#include "StratusFrameGraph.h"
+#include "StratusTaskSystem.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace stratus {
+    size_t FrameGraph::AddJob(const std::string& name,
+                              const FrameJobAffinity affinity,
+                              const std::vector<std::string>& reads,
+                              const std::vector<std::string>& writes,
+                              const FrameJobFunction& function) {
+
+        const size_t index = jobs_.size();
+        auto job = std::make_unique<Job_>();
+        job->name = name;
+        job->affinity = affinity;
+        job->function = function;
+        jobs_.push_back(std::move(job));
+
+        // Read after write
+        for (const std::string& resource : reads) {
+            ResourceState_& state = resources_[resource];
+            AddDependency_(index, state.lastWriter);
+        }
+
+        // Write after write + write after read
+        for (const std::string& resource : writes) {
+            ResourceState_& state = resources_[resource];
+            AddDependency_(index, state.lastWriter);
+            for (const size_t reader : state.readers) {
+                AddDependency_(index, reader);
+            }
+        }
+
+        // Update resource state only after all dependencies are known so that a job which
+        // both reads and writes a resource doesn't end up depending on itself
+        for (const std::string& resource : writes) {
+            ResourceState_& state = resources_[resource];
+            state.lastWriter = index;
+            state.readers.clear();
+        }
+
+        for (const std::string& resource : reads) {
+            ResourceState_& state = resources_[resource];
+            if (state.lastWriter != index) {
+                state.readers.push_back(index);
+            }
+        }
+
+        if (jobs_[index]->dependencies.size() == 0) {
+            roots_.push_back(index);
+        }
+
+        return index;
+    }
+
+    void FrameGraph::AddDependency_(const size_t job, const size_t dependency) {
+        if (dependency == size_t(-1) || dependency == job) return;
+
+        auto& dependencies = jobs_[job]->dependencies;
+        if (std::find(dependencies.begin(), dependencies.end(), dependency) != dependencies.end()) return;
+
+        dependencies.push_back(dependency);
+        jobs_[dependency]->dependents.push_back(job);
+    }
+
+    SystemStatus FrameGraph::Execute(const double deltaSeconds) {
+        if (jobs_.size() == 0) return SystemStatus::SYSTEM_CONTINUE;
+
+        deltaSeconds_ = deltaSeconds;
+        completed_ = 0;
+        aborted_.store(false);
+        status_ = SystemStatus::SYSTEM_CONTINUE;
+        exception_ = nullptr;
+        readyApplicationJobs_.clear();
+
+        for (auto& job : jobs_) {
+            job->remaining.store(job->dependencies.size());
+        }
+
+        for (const size_t root : roots_) {
+            MakeReady_(root);
+        }
+
+        // Service application thread jobs until everything is done
+        auto ul = std::unique_lock<std::mutex>(mutex_);
+        while (completed_ < jobs_.size()) {
+            if (readyApplicationJobs_.size() == 0) {
+                jobsChanged_.wait(ul, [this]() {
+                    return readyApplicationJobs_.size() > 0 || completed_ == jobs_.size();
+                });
+                continue;
+            }
+
+            const size_t next = readyApplicationJobs_.back();
+            readyApplicationJobs_.pop_back();
+
+            ul.unlock();
+            RunJob_(next);
+            ul.lock();
+        }
+
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+
+        return status_;
+    }
+
+    void FrameGraph::MakeReady_(const size_t index) {
+        Job_ * job = jobs_[index].get();
+        TaskSystem * tasks = TaskSystem::Instance();
+
+        if (job->affinity == FrameJobAffinity::ANY_THREAD && tasks != nullptr) {
+            tasks->ScheduleTask([this, index]() {
+                RunJob_(index);
+            });
+        }
+        else {
+            auto ul = std::unique_lock<std::mutex>(mutex_);
+            readyApplicationJobs_.push_back(index);
+            jobsChanged_.notify_all();
+        }
+    }
+
+    void FrameGraph::RunJob_(const size_t index) {
+        // Once something has failed we still walk the rest of the graph so that
+        // completion tracking stays consistent, but no more jobs are run
+        if (!aborted_.load()) {
+            SystemStatus status = SystemStatus::SYSTEM_CONTINUE;
+            std::exception_ptr exception = nullptr;
+            try {
+                status = jobs_[index]->function(deltaSeconds_);
+            }
+            catch (...) {
+                exception = std::current_exception();
+            }
+
+            if (status != SystemStatus::SYSTEM_CONTINUE || exception) {
+                auto ul = std::unique_lock<std::mutex>(mutex_);
+                if (!aborted_.load()) {
+                    aborted_.store(true);
+                    status_ = status;
+                    exception_ = exception;
+                }
+            }
+        }
+
+        CompleteJob_(index);
+    }
+
+    void FrameGraph::CompleteJob_(const size_t index) {
+        for (const size_t dependent : jobs_[index]->dependents) {
+            if (jobs_[dependent]->remaining.fetch_sub(1) == 1) {
+                MakeReady_(dependent);
+            }
+        }
+
+        // Must be the last thing we touch since Execute is free to return as soon as
+        // the final job is marked complete
+        auto ul = std::unique_lock<std::mutex>(mutex_);
+        ++completed_;
+        jobsChanged_.notify_all();
+    }
+
+    void FrameGraph::Clear() {
+        jobs_.clear();
+        resources_.clear();
+        roots_.clear();
+    }
+
+    size_t FrameGraph::Size() const {
+        return jobs_.size();
+    }
+
+    const std::string& FrameGraph::JobName(const size_t index) const {
+        if (index >= jobs_.size()) throw std::out_of_range("FrameGraph job index out of range");
+        return jobs_[index]->name;
+    }
+
+    const std::vector<size_t>& FrameGraph::JobDependencies(const size_t index) const {
+        if (index >= jobs_.size()) throw std::out_of_range("FrameGraph job index out of range");
+        return jobs_[index]->dependencies;
+    }
+}
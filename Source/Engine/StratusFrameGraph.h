@@ -0,0 +1,106 @@
+#pragma once
+
+#include "StratusSystemStatus.h"
+#include <functional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <exception>
+
+namespace stratus {
+    // Determines which thread a frame job is allowed to run on
+    enum class FrameJobAffinity : int {
+        // Job can run on any task thread
+        ANY_THREAD,
+        // Job must run on the thread which calls FrameGraph::Execute (generally the application
+        // thread). Anything which touches the graphics context or SDL needs this.
+        APPLICATION_THREAD
+    };
+
+    typedef std::function<SystemStatus (const double)> FrameJobFunction;
+
+    // A frame graph is a set of CPU jobs which run once per frame. Each job declares the named resources
+    // it reads and writes, and ordering between jobs is derived from that:
+    //
+    //      a job runs after the most recent previously added job which writes something it reads or writes
+    //      a job which writes a resource also runs after all previously added jobs which read it
+    //
+    // Jobs with no ordering between them are free to run in parallel. ANY_THREAD jobs are sent to the
+    // TaskSystem (or run on the calling thread if there is no TaskSystem) while APPLICATION_THREAD jobs
+    // always run on the thread which called Execute.
+    class FrameGraph {
+        struct Job_ {
+            std::string name;
+            FrameJobAffinity affinity;
+            FrameJobFunction function;
+            // Jobs which must wait for this one to complete
+            std::vector<size_t> dependents;
+            // Jobs this one must wait on
+            std::vector<size_t> dependencies;
+            // Number of dependencies which have not completed yet for the current call to Execute
+            std::atomic<size_t> remaining{0};
+        };
+
+        // Tracks the last writer and readers since then for a resource
+        struct ResourceState_ {
+            size_t lastWriter = size_t(-1);
+            std::vector<size_t> readers;
+        };
+
+    public:
+        FrameGraph() = default;
+        ~FrameGraph() = default;
+
+        FrameGraph(const FrameGraph&) = delete;
+        FrameGraph(FrameGraph&&) = delete;
+        FrameGraph& operator=(const FrameGraph&) = delete;
+        FrameGraph& operator=(FrameGraph&&) = delete;
+
+        // Adds a new job and returns its index. Jobs can't be added while Execute is running.
+        size_t AddJob(const std::string& name,
+                      const FrameJobAffinity affinity,
+                      const std::vector<std::string>& reads,
+                      const std::vector<std::string>& writes,
+                      const FrameJobFunction& function);
+
+        // Runs every job once, blocking until all have completed. If any job returns something other than
+        // SYSTEM_CONTINUE, jobs which have not started yet are skipped and the first such status is returned.
+        // If a job throws, the exception is rethrown here once all running jobs have finished.
+        SystemStatus Execute(const double deltaSeconds);
+
+        // Removes all jobs
+        void Clear();
+
+        size_t Size() const;
+        const std::string& JobName(const size_t) const;
+        // Indices of jobs which must complete before the given job can start
+        const std::vector<size_t>& JobDependencies(const size_t) const;
+
+    private:
+        void AddDependency_(const size_t job, const size_t dependency);
+        void MakeReady_(const size_t);
+        void RunJob_(const size_t);
+        void CompleteJob_(const size_t);
+
+    private:
+        std::vector<std::unique_ptr<Job_>> jobs_;
+        std::unordered_map<std::string, ResourceState_> resources_;
+        // Jobs with no dependencies
+        std::vector<size_t> roots_;
+
+        // State for the current call to Execute
+        double deltaSeconds_ = 0.0;
+        std::mutex mutex_;
+        std::condition_variable jobsChanged_;
+        // APPLICATION_THREAD jobs which are ready to run
+        std::vector<size_t> readyApplicationJobs_;
+        size_t completed_ = 0;
+        std::atomic<bool> aborted_{false};
+        SystemStatus status_ = SystemStatus::SYSTEM_CONTINUE;
+        std::exception_ptr exception_;
+    };
+}
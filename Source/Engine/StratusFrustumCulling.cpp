@@ -0,0 +1,258 @@
+#include "StratusFrustumCulling.h"
+#include "StratusCpuTopology.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+// SSE2 is part of the x86-64 baseline while AVX is selected at runtime
+#define STRATUS_CULLING_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define STRATUS_TARGET_AVX_
+#else
+#define STRATUS_TARGET_AVX_ __attribute__((target("avx")))
+#endif
+#endif
+
+namespace stratus {
+    void SoaAabbs::Resize(const size_t size) {
+        const size_t padded = ((size + Width - 1) / Width) * Width;
+        for (int axis = 0; axis < 3; ++axis) {
+            centers_[axis].resize(padded, 0.0f);
+            extents_[axis].resize(padded, 0.0f);
+            // Shrinking can leave old boxes behind in the padding
+            std::fill(centers_[axis].begin() + size, centers_[axis].end(), 0.0f);
+            std::fill(extents_[axis].begin() + size, extents_[axis].end(), 0.0f);
+        }
+        size_ = size;
+    }
+
+    void SoaAabbs::Clear() {
+        Resize(0);
+    }
+
+    size_t SoaAabbs::Size() const {
+        return size_;
+    }
+
+    size_t SoaAabbs::PaddedSize() const {
+        return centers_[0].size();
+    }
+
+    void SoaAabbs::Set(const size_t index, const GpuAABB& aabb) {
+        const glm::vec3 vmin = aabb.vmin.ToVec4();
+        const glm::vec3 vmax = aabb.vmax.ToVec4();
+        const glm::vec3 center = (vmin + vmax) * 0.5f;
+        const glm::vec3 extent = (vmax - vmin) * 0.5f;
+        for (int axis = 0; axis < 3; ++axis) {
+            centers_[axis][index] = center[axis];
+            extents_[axis][index] = extent[axis];
+        }
+    }
+
+    void SoaAabbs::Set(const size_t index, const GpuAABB& local, const AffineTransform& transform) {
+        Set(index, TransformAabb(local, transform));
+    }
+
+    GpuAABB SoaAabbs::Get(const size_t index) const {
+        const glm::vec3 center(centers_[0][index], centers_[1][index], centers_[2][index]);
+        const glm::vec3 extent(extents_[0][index], extents_[1][index], extents_[2][index]);
+        GpuAABB aabb;
+        aabb.vmin = glm::vec4(center - extent, 1.0f);
+        aabb.vmax = glm::vec4(center + extent, 1.0f);
+        return aabb;
+    }
+
+    GpuAABB TransformAabb(const GpuAABB& aabb, const AffineTransform& transform) {
+        const glm::vec3 vmin = aabb.vmin.ToVec4();
+        const glm::vec3 vmax = aabb.vmax.ToVec4();
+        const glm::vec3 center = (vmin + vmax) * 0.5f;
+        const glm::vec3 extent = (vmax - vmin) * 0.5f;
+
+        glm::vec3 worldCenter;
+        glm::vec3 worldExtent;
+        for (int r = 0; r < 3; ++r) {
+            const glm::vec3 axes(transform.rows[r]);
+            worldCenter[r] = glm::dot(axes, center) + transform.rows[r].w;
+            worldExtent[r] = glm::dot(glm::abs(axes), extent);
+        }
+
+        GpuAABB result;
+        result.vmin = glm::vec4(worldCenter - worldExtent, 1.0f);
+        result.vmax = glm::vec4(worldCenter + worldExtent, 1.0f);
+        return result;
+    }
+
+    void ExtractFrustumPlanes(const glm::mat4& projectionView, glm::vec4 planes[6]) {
+        const glm::mat4 t = glm::transpose(projectionView);
+        // left, right, bottom, top
+        planes[0] = t[3] + t[0];
+        planes[1] = t[3] - t[0];
+        planes[2] = t[3] + t[1];
+        planes[3] = t[3] - t[1];
+        // near, far
+        planes[4] = t[3] + t[2];
+        planes[5] = t[3] - t[2];
+    }
+
+    // ORs bit into out[i] for every visible box and returns how many were visible
+    typedef size_t (*CullAabbsKernel_)(const SoaAabbs&, const glm::vec4 *, const uint8_t, uint8_t *);
+
+    // For each plane the box is outside if center distance + projected extent < 0, which is the same as its
+    // furthest corner along the plane normal being behind the plane
+    static size_t CullAabbsScalar_(const SoaAabbs& aabbs, const glm::vec4 * planes, const uint8_t bit, uint8_t * out) {
+        const float * cx = aabbs.Centers(0);
+        const float * cy = aabbs.Centers(1);
+        const float * cz = aabbs.Centers(2);
+        const float * ex = aabbs.Extents(0);
+        const float * ey = aabbs.Extents(1);
+        const float * ez = aabbs.Extents(2);
+
+        size_t count = 0;
+        for (size_t i = 0; i < aabbs.Size(); ++i) {
+            bool inside = true;
+            for (int p = 0; p < 6; ++p) {
+                const glm::vec4& g = planes[p];
+                const float distance = g.x * cx[i] + g.y * cy[i] + g.z * cz[i] + g.w;
+                const float radius = std::fabs(g.x) * ex[i] + std::fabs(g.y) * ey[i] + std::fabs(g.z) * ez[i];
+                inside = inside && (distance + radius >= 0.0f);
+            }
+
+            out[i] |= inside ? bit : uint8_t(0);
+            count += inside ? 1 : 0;
+        }
+
+        return count;
+    }
+
+#ifdef STRATUS_CULLING_X64
+    // Applies the lane mask of one register of boxes to out
+    static inline size_t WriteLanes_(const int mask, const size_t lanes, const uint8_t bit, uint8_t * out) {
+        size_t count = 0;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            const int inside = (mask >> lane) & 1;
+            out[lane] |= bit & uint8_t(-inside);
+            count += size_t(inside);
+        }
+        return count;
+    }
+
+    // Four boxes at a time
+    static size_t CullAabbsSse_(const SoaAabbs& aabbs, const glm::vec4 * planes, const uint8_t bit, uint8_t * out) {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+        for (int p = 0; p < 6; ++p) {
+            nx[p] = _mm_set1_ps(planes[p].x);
+            ny[p] = _mm_set1_ps(planes[p].y);
+            nz[p] = _mm_set1_ps(planes[p].z);
+            nw[p] = _mm_set1_ps(planes[p].w);
+            ax[p] = _mm_set1_ps(std::fabs(planes[p].x));
+            ay[p] = _mm_set1_ps(std::fabs(planes[p].y));
+            az[p] = _mm_set1_ps(std::fabs(planes[p].z));
+        }
+
+        size_t count = 0;
+        const size_t size = aabbs.Size();
+        for (size_t i = 0; i < size; i += 4) {
+            const __m128 cx = _mm_loadu_ps(aabbs.Centers(0) + i);
+            const __m128 cy = _mm_loadu_ps(aabbs.Centers(1) + i);
+            const __m128 cz = _mm_loadu_ps(aabbs.Centers(2) + i);
+            const __m128 ex = _mm_loadu_ps(aabbs.Extents(0) + i);
+            const __m128 ey = _mm_loadu_ps(aabbs.Extents(1) + i);
+            const __m128 ez = _mm_loadu_ps(aabbs.Extents(2) + i);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy));
+                distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(nz[p], cz)), nw[p]);
+                __m128 radius = _mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey));
+                radius = _mm_add_ps(radius, _mm_mul_ps(az[p], ez));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            count += WriteLanes_(_mm_movemask_ps(inside), std::min<size_t>(4, size - i), bit, out + i);
+        }
+
+        return count;
+    }
+
+    // Eight boxes at a time
+    STRATUS_TARGET_AVX_ static size_t CullAabbsAvx_(const SoaAabbs& aabbs, const glm::vec4 * planes, const uint8_t bit, uint8_t * out) {
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+        for (int p = 0; p < 6; ++p) {
+            nx[p] = _mm256_set1_ps(planes[p].x);
+            ny[p] = _mm256_set1_ps(planes[p].y);
+            nz[p] = _mm256_set1_ps(planes[p].z);
+            nw[p] = _mm256_set1_ps(planes[p].w);
+            ax[p] = _mm256_set1_ps(std::fabs(planes[p].x));
+            ay[p] = _mm256_set1_ps(std::fabs(planes[p].y));
+            az[p] = _mm256_set1_ps(std::fabs(planes[p].z));
+        }
+
+        size_t count = 0;
+        const size_t size = aabbs.Size();
+        for (size_t i = 0; i < size; i += 8) {
+            const __m256 cx = _mm256_loadu_ps(aabbs.Centers(0) + i);
+            const __m256 cy = _mm256_loadu_ps(aabbs.Centers(1) + i);
+            const __m256 cz = _mm256_loadu_ps(aabbs.Centers(2) + i);
+            const __m256 ex = _mm256_loadu_ps(aabbs.Extents(0) + i);
+            const __m256 ey = _mm256_loadu_ps(aabbs.Extents(1) + i);
+            const __m256 ez = _mm256_loadu_ps(aabbs.Extents(2) + i);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy));
+                distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(nz[p], cz)), nw[p]);
+                __m256 radius = _mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey));
+                radius = _mm256_add_ps(radius, _mm256_mul_ps(az[p], ez));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+            }
+
+            count += WriteLanes_(_mm256_movemask_ps(inside), std::min<size_t>(8, size - i), bit, out + i);
+        }
+
+        return count;
+    }
+#endif
+
+    struct CullingKernels_ {
+        CullAabbsKernel_ cull = CullAabbsScalar_;
+        const char * name = "Scalar";
+
+        CullingKernels_() {
+#ifdef STRATUS_CULLING_X64
+            cull = CullAabbsSse_;
+            name = "SSE";
+            if (CpuSupportsAvx()) {
+                cull = CullAabbsAvx_;
+                name = "AVX";
+            }
+#endif
+        }
+    };
+
+    static const CullingKernels_& Kernels_() {
+        static const CullingKernels_ kernels;
+        return kernels;
+    }
+
+    size_t CullAabbs(const SoaAabbs& aabbs, const glm::vec4 * planes, uint8_t * visible) {
+        std::fill(visible, visible + aabbs.Size(), uint8_t(0));
+        return Kernels_().cull(aabbs, planes, 1, visible);
+    }
+
+    void CullAabbs(const SoaAabbs& aabbs, const glm::vec4 * planes, const size_t numFrusta, uint8_t * masks) {
+        if (numFrusta > 8) throw std::runtime_error("CullAabbs supports at most 8 frusta");
+
+        std::fill(masks, masks + aabbs.Size(), uint8_t(0));
+        for (size_t k = 0; k < numFrusta; ++k) {
+            Kernels_().cull(aabbs, planes + 6 * k, uint8_t(1 << k), masks);
+        }
+    }
+
+    const char * FrustumCullingKernelName() {
+        return Kernels_().name;
+    }
+}
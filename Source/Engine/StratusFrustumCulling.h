@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "glm/glm.hpp"
+#include "StratusGpuCommon.h"
+#include "StratusAffineTransform.h"
+
+namespace stratus {
+    // Structure of arrays AABBs in center/extent form, which is what the culling kernels consume. Storage
+    // is padded to a multiple of Width boxes (padding is all zeros) so the wide kernels never need a
+    // scalar tail.
+    class SoaAabbs final {
+    public:
+        static constexpr size_t Width = 8;
+
+        SoaAabbs() = default;
+
+        // New boxes are all zeros
+        void Resize(const size_t);
+        void Clear();
+        size_t Size() const;
+        size_t PaddedSize() const;
+
+        void Set(const size_t, const GpuAABB&);
+        // Stores the world space bounds of a local space box
+        void Set(const size_t, const GpuAABB& local, const AffineTransform&);
+        GpuAABB Get(const size_t) const;
+
+        // Component arrays with PaddedSize() elements each (0 = x, 1 = y, 2 = z)
+        const float * Centers(const size_t axis) const { return centers_[axis].data(); }
+        const float * Extents(const size_t axis) const { return extents_[axis].data(); }
+
+    private:
+        std::vector<float> centers_[3];
+        std::vector<float> extents_[3];
+        size_t size_ = 0;
+    };
+
+    // World space bounds of a local space box. Transforms the center and extents instead of all 8
+    // corners (see "Transforming Axis-Aligned Bounding Boxes", Graphics Gems).
+    GpuAABB TransformAabb(const GpuAABB&, const AffineTransform&);
+
+    // Extracts the inward facing left, right, bottom, top, near and far planes from a projection * view
+    // matrix (see "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix").
+    // Works for the main view, CSM cascades and each face of a point light's cube map.
+    void ExtractFrustumPlanes(const glm::mat4& projectionView, glm::vec4 planes[6]);
+
+    // Batched kernels which use AVX or SSE when the CPU supports them and fall back to scalar code otherwise.
+    // A box is culled if it is fully behind any plane, which gives the same result as IsAabbInFrustum. Every
+    // kernel performs the same operations in the same order so results do not depend on the kernel.
+
+    // visible[i] = 1 if box i is inside the frustum given by 6 planes, 0 otherwise. Returns the number of
+    // visible boxes.
+    size_t CullAabbs(const SoaAabbs&, const glm::vec4 * planes, uint8_t * visible);
+    // Culls against several frusta in one call (for example all CSM cascades or all 6 point light faces).
+    // planes holds 6 planes per frustum and bit k of masks[i] is set if box i is inside frustum k. At most
+    // 8 frusta are supported.
+    void CullAabbs(const SoaAabbs&, const glm::vec4 * planes, const size_t numFrusta, uint8_t * masks);
+
+    // Name of the kernel selected for this CPU ("AVX", "SSE" or "Scalar")
+    const char * FrustumCullingKernelName();
+}
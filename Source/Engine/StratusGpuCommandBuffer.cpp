@@ -13,8 +13,8 @@ namespace stratus {
 
         visibleCommands_ = GpuTypedBuffer<GpuDrawElementsIndirectCommand>::Create(commandBlockSize, true);
         selectedLodCommands_ = GpuTypedBuffer<GpuDrawElementsIndirectCommand>::Create(commandBlockSize, true);
-        prevFrameModelTransforms_ = GpuTypedBuffer<glm::mat4>::Create(commandBlockSize, true);
-        modelTransforms_ = GpuTypedBuffer<glm::mat4>::Create(commandBlockSize, true);
+        prevFrameModelTransforms_ = GpuTypedBuffer<AffineTransform>::Create(commandBlockSize, true);
+        modelTransforms_ = GpuTypedBuffer<AffineTransform>::Create(commandBlockSize, true);
         aabbs_ = GpuTypedBuffer<GpuAABB>::Create(commandBlockSize, true);
         materialIndices_ = GpuTypedBuffer<uint32_t>::Create(commandBlockSize, true);
     }
@@ -70,8 +70,9 @@ namespace stratus {
         std::vector<GpuTypedBufferPtr<GpuDrawElementsIndirectCommand>> drawCommands_;
         GpuTypedBufferPtr<GpuDrawElementsIndirectCommand> visibleCommands_;
         GpuTypedBufferPtr<GpuDrawElementsIndirectCommand> selectedLodCommands_;
-        GpuTypedBufferPtr<glm::mat4> prevFrameModelTransforms_;
-        GpuTypedBufferPtr<glm::mat4> modelTransforms_;
+        // Stored in the compact 3x4 form (see model_transform.glsl)
+        GpuTypedBufferPtr<AffineTransform> prevFrameModelTransforms_;
+        GpuTypedBufferPtr<AffineTransform> modelTransforms_;
         GpuTypedBufferPtr<GpuAABB> aabbs_;
         GpuTypedBufferPtr<uint32_t> materialIndices_;
         std::unordered_map<RenderComponent *, std::unordered_map<MeshPtr, uint32_t>> drawCommandIndices_;
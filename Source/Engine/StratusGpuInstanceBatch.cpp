@@ -0,0 +1,119 @@
+#include "StratusGpuInstanceBatch.h"
+#include <algorithm>
+
+namespace stratus {
+    void GpuInstanceBatchList::Insert(const uint32_t instance, const GpuInstanceBatchKey& key) {
+        if (instance >= positions_.size()) {
+            positions_.resize(size_t(instance) + 1, NullPosition_);
+            keys_.resize(size_t(instance) + 1);
+        }
+
+        if (positions_[instance] == NullPosition_) {
+            positions_[instance] = uint32_t(members_.size());
+            members_.push_back(instance);
+        }
+        else if (keys_[instance] == key) {
+            return;
+        }
+
+        keys_[instance] = key;
+        dirty_ = true;
+    }
+
+    bool GpuInstanceBatchList::Remove(const uint32_t instance) {
+        if (!Contains(instance)) return false;
+
+        // Swap the last member into the hole
+        const uint32_t position = positions_[instance];
+        const uint32_t last = members_.back();
+        members_[position] = last;
+        positions_[last] = position;
+        members_.pop_back();
+
+        positions_[instance] = NullPosition_;
+        keys_[instance] = GpuInstanceBatchKey();
+        dirty_ = true;
+        return true;
+    }
+
+    void GpuInstanceBatchList::Clear() {
+        if (members_.size() > 0) dirty_ = true;
+        keys_.clear();
+        positions_.clear();
+        members_.clear();
+    }
+
+    bool GpuInstanceBatchList::Contains(const uint32_t instance) const {
+        return instance < positions_.size() && positions_[instance] != NullPosition_;
+    }
+
+    const GpuInstanceBatchKey& GpuInstanceBatchList::GetKey(const uint32_t instance) const {
+        return keys_[instance];
+    }
+
+    size_t GpuInstanceBatchList::NumInstances() const {
+        return members_.size();
+    }
+
+    void GpuInstanceBatchList::MarkDirty() {
+        dirty_ = true;
+    }
+
+    bool GpuInstanceBatchList::Dirty() const {
+        return dirty_;
+    }
+
+    bool GpuInstanceBatchList::Build() {
+        if (!dirty_) return false;
+        dirty_ = false;
+
+        instances_.assign(members_.begin(), members_.end());
+        std::sort(instances_.begin(), instances_.end(), [this](const uint32_t a, const uint32_t b) {
+            if (keys_[a] != keys_[b]) return keys_[a] < keys_[b];
+            return a < b;
+        });
+
+        batches_.clear();
+        for (uint32_t i = 0; i < uint32_t(instances_.size()); ++i) {
+            const GpuInstanceBatchKey& key = keys_[instances_[i]];
+            if (batches_.size() == 0 || batches_.back().key != key) {
+                batches_.push_back(GpuInstanceBatch{key, i, 0});
+            }
+            ++batches_.back().instanceCount;
+        }
+
+        return true;
+    }
+
+    const std::vector<GpuInstanceBatch>& GpuInstanceBatchList::Batches() const {
+        return batches_;
+    }
+
+    const std::vector<uint32_t>& GpuInstanceBatchList::Instances() const {
+        return instances_;
+    }
+
+    void GpuInstanceBatchList::Compact(const uint8_t * visible, std::vector<GpuInstanceBatch>& outBatches, std::vector<uint32_t>& outInstances) const {
+        outBatches.clear();
+        // Sized for the worst case so every instance can be written unconditionally and then
+        // kept or overwritten depending on visibility
+        outInstances.resize(instances_.size());
+
+        uint32_t count = 0;
+        for (const GpuInstanceBatch& batch : batches_) {
+            const uint32_t first = count;
+            const uint32_t * instances = instances_.data() + batch.firstInstance;
+            for (uint32_t i = 0; i < batch.instanceCount; ++i) {
+                const uint32_t instance = instances[i];
+                outInstances[count] = instance;
+                count += visible[instance] != 0 ? 1 : 0;
+            }
+
+            if (count > first) {
+                outBatches.push_back(GpuInstanceBatch{batch.key, first, count - first});
+            }
+        }
+
+        outInstances.resize(count);
+    }
+}
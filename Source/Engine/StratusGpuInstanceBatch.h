@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace stratus {
+    struct Mesh;
+
+    // Everything which has to match for two instances to be drawn by the same instanced command.
+    // Face culling is not part of the key since each GpuCommandBuffer only holds one cull mode.
+    struct GpuInstanceBatchKey {
+        const Mesh * mesh = nullptr;
+        uint32_t materialIndex = 0;
+
+        bool operator==(const GpuInstanceBatchKey& other) const {
+            return mesh == other.mesh && materialIndex == other.materialIndex;
+        }
+
+        bool operator!=(const GpuInstanceBatchKey& other) const {
+            return !(*this == other);
+        }
+
+        bool operator<(const GpuInstanceBatchKey& other) const {
+            if (mesh != other.mesh) return mesh < other.mesh;
+            return materialIndex < other.materialIndex;
+        }
+    };
+
+    // Range of instances which share a key
+    struct GpuInstanceBatch {
+        GpuInstanceBatchKey key;
+        // Offset into the instance list the batch was built with
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+    };
+
+    // Groups instance slots (for example the indices into GpuCommandBuffer's per-draw transform, material
+    // and aabb buffers) into batches of identical mesh + material, which is the grouping an instanced
+    // draw needs.
+    //
+    // The slots themselves never move. Instead the list produces an array of slot indices ordered by
+    // batch, so each batch is a contiguous range [firstInstance, firstInstance + instanceCount) of it
+    // that can be culled (see Compact) or iterated without searching.
+    //
+    // Nothing here touches the GPU so it can be used (and tested) without a GL context.
+    class GpuInstanceBatchList final {
+    public:
+        GpuInstanceBatchList() = default;
+
+        // Adds the instance or changes its key if it already exists
+        void Insert(const uint32_t instance, const GpuInstanceBatchKey&);
+        // Returns false if the instance was not present
+        bool Remove(const uint32_t instance);
+        void Clear();
+
+        bool Contains(const uint32_t instance) const;
+        // Undefined if the instance is not present
+        const GpuInstanceBatchKey& GetKey(const uint32_t instance) const;
+        size_t NumInstances() const;
+
+        // Forces the next Build to report a change even if no instance was added, removed or
+        // re-keyed (for example when a mesh finishes loading and its draw commands change)
+        void MarkDirty();
+        bool Dirty() const;
+
+        // Regroups instances into batches if anything changed since the last call. Returns true
+        // if Batches()/Instances() changed.
+        //
+        // Batches are ordered by key and instances within a batch by slot, so the result only
+        // depends on what the list contains and not on the order it was modified in.
+        bool Build();
+
+        const std::vector<GpuInstanceBatch>& Batches() const;
+        // Instance slots grouped by batch - GpuInstanceBatch::firstInstance indexes into this
+        const std::vector<uint32_t>& Instances() const;
+
+        // Culls the last Build's batches down to visible instances only. visible is indexed by
+        // instance slot and must cover every slot in the list. The output batches index into
+        // outInstances and batches with no visible instances are dropped. Both outputs are
+        // cleared first.
+        void Compact(const uint8_t * visible, std::vector<GpuInstanceBatch>& outBatches, std::vector<uint32_t>& outInstances) const;
+
+    private:
+        static constexpr uint32_t NullPosition_ = uint32_t(-1);
+
+        // Indexed by instance slot
+        std::vector<GpuInstanceBatchKey> keys_;
+        // Indexed by instance slot, position within members_ (NullPosition_ if not present)
+        std::vector<uint32_t> positions_;
+        // Dense list of every instance slot in the list
+        std::vector<uint32_t> members_;
+        std::vector<GpuInstanceBatch> batches_;
+        std::vector<uint32_t> instances_;
+        bool dirty_ = false;
+    };
+}
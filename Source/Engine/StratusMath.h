@@ -362,22 +362,21 @@ namespace stratus {
         return result;
     }
 
+    // The box is outside if it is fully behind any plane, i.e. the corner furthest along the plane normal is
+    // behind it. Uses the center/extent form so each plane costs two dot products instead of eight (see
+    // CullAabbs in StratusFrustumCulling.h for the batched version).
     template<typename Array>
     bool IsAabbInFrustum(const GpuAABB& aabb, const Array& frustumPlanes) {
-        const glm::vec4 vmin = aabb.vmin.ToVec4();
-        const glm::vec4 vmax = aabb.vmax.ToVec4();
+        const glm::vec3 vmin = aabb.vmin.ToVec4();
+        const glm::vec3 vmax = aabb.vmax.ToVec4();
+        const glm::vec3 center = (vmin + vmax) * 0.5f;
+        const glm::vec3 extent = (vmax - vmin) * 0.5f;
 
         for (int i = 0; i < 6; ++i) {
             const glm::vec4& g = frustumPlanes[i];
-            if ((glm::dot(g, glm::vec4(vmin.x, vmin.y, vmin.z, 1.0f)) < 0.0) &&
-                (glm::dot(g, glm::vec4(vmax.x, vmin.y, vmin.z, 1.0f)) < 0.0) &&
-                (glm::dot(g, glm::vec4(vmin.x, vmax.y, vmin.z, 1.0f)) < 0.0) &&
-                (glm::dot(g, glm::vec4(vmax.x, vmax.y, vmin.z, 1.0f)) < 0.0) &&
-                (glm::dot(g, glm::vec4(vmin.x, vmin.y, vmax.z, 1.0f)) < 0.0) &&
-                (glm::dot(g, glm::vec4(vmax.x, vmin.y, vmax.z, 1.0f)) < 0.0) &&
-                (glm::dot(g, glm::vec4(vmin.x, vmax.y, vmax.z, 1.0f)) < 0.0) &&
-                (glm::dot(g, glm::vec4(vmax.x, vmax.y, vmax.z, 1.0f)) < 0.0))
-            {
+            const float distance = g.x * center.x + g.y * center.y + g.z * center.z + g.w;
+            const float radius = std::fabs(g.x) * extent.x + std::fabs(g.y) * extent.y + std::fabs(g.z) * extent.z;
+            if (!(distance + radius >= 0.0f)) {
                 return false;
             }
         }
@@ -417,7 +416,7 @@ namespace stratus {
         float dy = std::max<float>(aabb.vmin.v[1] - point.y, std::max<float>(0.0f, point.y - aabb.vmax.v[1]));
         float dz = std::max<float>(aabb.vmin.v[2] - point.z, std::max<float>(0.0f, point.z - aabb.vmax.v[2]));
 
-        return std::sqrt(dx * dx + dy * dy + dz + dz);
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
     }
 
     // These are the first 512 values of the Halton sequence. For more information see:
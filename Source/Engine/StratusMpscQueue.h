@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+
+namespace stratus {
+    // Intrusive lock-free multi-producer single-consumer queue. Any number of threads can push
+    // while one consumer takes everything that has been pushed so far in a single operation.
+    //
+    // E is required to have a public member E * next which the queue uses to link elements
+    // together. The queue never allocates or frees memory - ownership of pushed elements is
+    // transferred to whoever calls PopAll.
+    template<typename E>
+    class MpscQueue {
+    public:
+        MpscQueue() = default;
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue(MpscQueue&&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+        MpscQueue& operator=(MpscQueue&&) = delete;
+
+        // Any thread
+        void Push(E * elem) {
+            PushMany(elem, elem);
+        }
+
+        // Any thread - pushes an already linked list of elements in one step. The list must be linked
+        // newest to oldest (first->next->...->last where last was "pushed" first) since that is how
+        // the queue stores them internally.
+        void PushMany(E * first, E * last) {
+            E * head = head_.load(std::memory_order_relaxed);
+            do {
+                last->next = head;
+            } while (!head_.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // Consumer thread only - removes all elements and returns them as a linked list
+        // in the order they were pushed (nullptr if empty)
+        E * PopAll() {
+            E * head = head_.exchange(nullptr, std::memory_order_acquire);
+            // Elements are stored newest first so reverse them
+            E * ordered = nullptr;
+            while (head != nullptr) {
+                E * next = head->next;
+                head->next = ordered;
+                ordered = head;
+                head = next;
+            }
+            return ordered;
+        }
+
+        // Any thread (only a hint if other threads are pushing)
+        bool Empty() const {
+            return head_.load(std::memory_order_relaxed) == nullptr;
+        }
+
+    private:
+        std::atomic<E *> head_{nullptr};
+    };
+}
@@ -0,0 +1,398 @@
+#include "StratusOcclusionCulling.h"
+#include "StratusTaskSystem.h"
+#include "StratusCommon.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+// SSE2 is part of the x86-64 baseline
+#define STRATUS_OCCLUSION_X64 1
+#include <immintrin.h>
+#endif
+
+namespace stratus {
+    // Below these the work is done on the calling thread
+    static constexpr size_t MinTrianglesForParallelRasterize_ = 256;
+    static constexpr size_t MinBoxesForParallelCull_ = 1024;
+
+    // Rasterizes one row of a triangle. depth points at the first pixel of numGroups groups of 4 pixels,
+    // edges and z are the edge functions and depth at the center of that pixel, and steps and zStep are how
+    // much they change per pixel. Covered pixels keep the nearest depth.
+    typedef void (*RasterizeSpanKernel_)(float *, const size_t, const float *, const float *, const float, const float);
+
+    static void RasterizeSpanScalar_(float * depth, const size_t numGroups, const float * edges, const float * steps, const float z, const float zStep) {
+        float e[3][4];
+        float lz[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            for (int k = 0; k < 3; ++k) e[k][lane] = edges[k] + steps[k] * float(lane);
+            lz[lane] = z + zStep * float(lane);
+        }
+        const float groupSteps[3] = { steps[0] * 4.0f, steps[1] * 4.0f, steps[2] * 4.0f };
+        const float groupZStep = zStep * 4.0f;
+
+        for (size_t group = 0; group < numGroups; ++group, depth += 4) {
+            for (int lane = 0; lane < 4; ++lane) {
+                const bool covered = e[0][lane] >= 0.0f && e[1][lane] >= 0.0f && e[2][lane] >= 0.0f;
+                const float nearest = depth[lane] < lz[lane] ? depth[lane] : lz[lane];
+                depth[lane] = covered ? nearest : depth[lane];
+
+                for (int k = 0; k < 3; ++k) e[k][lane] = e[k][lane] + groupSteps[k];
+                lz[lane] = lz[lane] + groupZStep;
+            }
+        }
+    }
+
+#ifdef STRATUS_OCCLUSION_X64
+    // Same operations as the scalar kernel with one coverage mask for 4 pixels at a time
+    static void RasterizeSpanSse_(float * depth, const size_t numGroups, const float * edges, const float * steps, const float z, const float zStep) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+        __m128 e[3];
+        __m128 groupSteps[3];
+        for (int k = 0; k < 3; ++k) {
+            e[k] = _mm_add_ps(_mm_set1_ps(edges[k]), _mm_mul_ps(_mm_set1_ps(steps[k]), lanes));
+            groupSteps[k] = _mm_set1_ps(steps[k] * 4.0f);
+        }
+        __m128 lz = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(_mm_set1_ps(zStep), lanes));
+        const __m128 groupZStep = _mm_set1_ps(zStep * 4.0f);
+
+        for (size_t group = 0; group < numGroups; ++group, depth += 4) {
+            __m128 covered = _mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero));
+            covered = _mm_and_ps(covered, _mm_cmpge_ps(e[2], zero));
+            if (_mm_movemask_ps(covered) != 0) {
+                const __m128 current = _mm_loadu_ps(depth);
+                const __m128 nearest = _mm_min_ps(current, lz);
+                _mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(covered, nearest), _mm_andnot_ps(covered, current)));
+            }
+
+            for (int k = 0; k < 3; ++k) e[k] = _mm_add_ps(e[k], groupSteps[k]);
+            lz = _mm_add_ps(lz, groupZStep);
+        }
+    }
+#endif
+
+    struct OcclusionKernels_ {
+        RasterizeSpanKernel_ rasterize = RasterizeSpanScalar_;
+        const char * name = "Scalar";
+
+        OcclusionKernels_() {
+#ifdef STRATUS_OCCLUSION_X64
+            rasterize = RasterizeSpanSse_;
+            name = "SSE";
+#endif
+        }
+    };
+
+    static const OcclusionKernels_& Kernels_() {
+        static const OcclusionKernels_ kernels;
+        return kernels;
+    }
+
+    const char * OcclusionCullingKernelName() {
+        return Kernels_().name;
+    }
+
+    OcclusionBuffer::OcclusionBuffer(const uint32_t width, const uint32_t height) {
+        tilesX_ = std::max<uint32_t>(1, (width + TileWidth - 1) / TileWidth);
+        tilesY_ = std::max<uint32_t>(1, (height + TileHeight - 1) / TileHeight);
+        width_ = tilesX_ * TileWidth;
+        height_ = tilesY_ * TileHeight;
+        bins_.resize(size_t(tilesX_) * tilesY_);
+
+        uint32_t levelWidth = width_;
+        uint32_t levelHeight = height_;
+        levelSizes_.push_back(glm::uvec2(levelWidth, levelHeight));
+        while (levelWidth > 1 || levelHeight > 1) {
+            levelWidth = (levelWidth + 1) / 2;
+            levelHeight = (levelHeight + 1) / 2;
+            levelSizes_.push_back(glm::uvec2(levelWidth, levelHeight));
+        }
+
+        levels_.resize(levelSizes_.size());
+        for (size_t level = 0; level < levels_.size(); ++level) {
+            levels_[level].resize(size_t(levelSizes_[level].x) * levelSizes_[level].y, 1.0f);
+        }
+    }
+
+    uint32_t OcclusionBuffer::Width() const {
+        return width_;
+    }
+
+    uint32_t OcclusionBuffer::Height() const {
+        return height_;
+    }
+
+    size_t OcclusionBuffer::NumTriangles() const {
+        return triangles_.size();
+    }
+
+    size_t OcclusionBuffer::NumLevels() const {
+        return levels_.size();
+    }
+
+    uint32_t OcclusionBuffer::LevelWidth(const size_t level) const {
+        return levelSizes_[level].x;
+    }
+
+    uint32_t OcclusionBuffer::LevelHeight(const size_t level) const {
+        return levelSizes_[level].y;
+    }
+
+    const float * OcclusionBuffer::Depth(const size_t level) const {
+        return levels_[level].data();
+    }
+
+    void OcclusionBuffer::Begin(const glm::mat4& projectionView) {
+        projectionView_ = projectionView;
+        triangles_.clear();
+        for (auto& bin : bins_) bin.clear();
+        for (auto& level : levels_) std::fill(level.begin(), level.end(), 1.0f);
+    }
+
+    void OcclusionBuffer::AddOccluder(
+        const glm::vec3 * vertices,
+        const size_t numVertices,
+        const uint32_t * indices,
+        const size_t numIndices,
+        const glm::mat4& transform) {
+
+        const glm::mat4 mvp = projectionView_ * transform;
+        for (size_t i = 0; i + 2 < numIndices; i += 3) {
+            if (indices[i] >= numVertices || indices[i + 1] >= numVertices || indices[i + 2] >= numVertices) {
+                throw std::runtime_error("Occluder index out of range");
+            }
+
+            const glm::vec4 clip[3] = {
+                mvp * glm::vec4(vertices[indices[i]], 1.0f),
+                mvp * glm::vec4(vertices[indices[i + 1]], 1.0f),
+                mvp * glm::vec4(vertices[indices[i + 2]], 1.0f)
+            };
+
+            // Clip against the near plane (z + w >= 0, same plane as ExtractFrustumPlanes) which
+            // leaves at most 4 vertices
+            glm::vec4 clipped[4];
+            size_t numClipped = 0;
+            for (size_t v = 0; v < 3; ++v) {
+                const glm::vec4& current = clip[v];
+                const glm::vec4& next = clip[(v + 1) % 3];
+                const float currentDistance = current.z + current.w;
+                const float nextDistance = next.z + next.w;
+                if (currentDistance >= 0.0f) clipped[numClipped++] = current;
+                if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                    const float t = currentDistance / (currentDistance - nextDistance);
+                    clipped[numClipped++] = current + (next - current) * t;
+                }
+            }
+
+            for (size_t v = 2; v < numClipped; ++v) {
+                const glm::vec4 triangle[3] = { clipped[0], clipped[v - 1], clipped[v] };
+                AddTriangle_(triangle);
+            }
+        }
+    }
+
+    void OcclusionBuffer::AddTriangle_(const glm::vec4 * clip) {
+        double x[3], y[3], z[3];
+        for (int v = 0; v < 3; ++v) {
+            // Degenerate projections or vertices on the eye plane can't be divided through
+            if (!(clip[v].w > 0.0f)) return;
+            const double invW = 1.0 / double(clip[v].w);
+            x[v] = (double(clip[v].x) * invW * 0.5 + 0.5) * double(width_);
+            y[v] = (double(clip[v].y) * invW * 0.5 + 0.5) * double(height_);
+            z[v] = double(clip[v].z) * invW * 0.5 + 0.5;
+            if (!std::isfinite(x[v]) || !std::isfinite(y[v]) || !std::isfinite(z[v])) return;
+        }
+
+        // Pixel centers (i + 0.5) inside the bounding box
+        const double minX = std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5);
+        const double maxX = std::floor(std::max({ x[0], x[1], x[2] }) - 0.5);
+        const double minY = std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5);
+        const double maxY = std::floor(std::max({ y[0], y[1], y[2] }) - 0.5);
+        if (maxX < 0.0 || maxY < 0.0 || minX > double(width_ - 1) || minY > double(height_ - 1) || minX > maxX || minY > maxY) return;
+
+        // Both windings are drawn by flipping clockwise triangles
+        double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (area == 0.0) return;
+        if (area < 0.0) {
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+            std::swap(z[1], z[2]);
+            area = -area;
+        }
+
+        Triangle_ triangle;
+        for (int k = 0; k < 3; ++k) {
+            const int next = (k + 1) % 3;
+            triangle.a[k] = -(y[next] - y[k]);
+            triangle.b[k] = x[next] - x[k];
+            triangle.c[k] = (y[next] - y[k]) * x[k] - (x[next] - x[k]) * y[k];
+        }
+        triangle.zx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+        triangle.zy = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+        triangle.z0 = z[0] - triangle.zx * x[0] - triangle.zy * y[0];
+        triangle.minX = int32_t(std::max(minX, 0.0));
+        triangle.maxX = int32_t(std::min(maxX, double(width_ - 1)));
+        triangle.minY = int32_t(std::max(minY, 0.0));
+        triangle.maxY = int32_t(std::min(maxY, double(height_ - 1)));
+
+        const uint32_t index = uint32_t(triangles_.size());
+        triangles_.push_back(triangle);
+        for (int32_t ty = triangle.minY / int32_t(TileHeight); ty <= triangle.maxY / int32_t(TileHeight); ++ty) {
+            for (int32_t tx = triangle.minX / int32_t(TileWidth); tx <= triangle.maxX / int32_t(TileWidth); ++tx) {
+                bins_[size_t(ty) * tilesX_ + size_t(tx)].push_back(index);
+            }
+        }
+    }
+
+    void OcclusionBuffer::Finish() {
+        const size_t numTiles = bins_.size();
+        TaskSystem * tasks = INSTANCE(TaskSystem);
+        if (tasks == nullptr || triangles_.size() < MinTrianglesForParallelRasterize_) {
+            for (size_t tile = 0; tile < numTiles; ++tile) RasterizeTile_(tile);
+        }
+        else {
+            // Tiles own disjoint pixels so they never need to synchronize
+            tasks->ParallelFor(0, numTiles, 1, [this](const size_t first, const size_t last) {
+                for (size_t tile = first; tile < last; ++tile) RasterizeTile_(tile);
+            });
+        }
+
+        BuildHiZ_();
+    }
+
+    void OcclusionBuffer::RasterizeTile_(const size_t tile) {
+        const int32_t tileX = int32_t(tile % tilesX_) * int32_t(TileWidth);
+        const int32_t tileY = int32_t(tile / tilesX_) * int32_t(TileHeight);
+        const RasterizeSpanKernel_ rasterize = Kernels_().rasterize;
+        float * depth = levels_[0].data();
+
+        for (const uint32_t index : bins_[tile]) {
+            const Triangle_& triangle = triangles_[index];
+            const int32_t startX = std::max(triangle.minX, tileX);
+            const int32_t endX = std::min(triangle.maxX, tileX + int32_t(TileWidth) - 1);
+            const int32_t startY = std::max(triangle.minY, tileY);
+            const int32_t endY = std::min(triangle.maxY, tileY + int32_t(TileHeight) - 1);
+
+            // Spans start on a group of 4 inside the tile. Pixels in the group which are outside the
+            // bounding box are also outside the triangle so the edge functions reject them.
+            const int32_t groupX = tileX + ((startX - tileX) & ~3);
+            const size_t numGroups = size_t((endX - groupX) / 4 + 1);
+            const float steps[3] = { float(triangle.a[0]), float(triangle.a[1]), float(triangle.a[2]) };
+            const float zStep = float(triangle.zx);
+
+            for (int32_t y = startY; y <= endY; ++y) {
+                // Evaluated in double at the start of each span so only a few float steps accumulate
+                const double px = double(groupX) + 0.5;
+                const double py = double(y) + 0.5;
+                float edges[3];
+                for (int k = 0; k < 3; ++k) {
+                    edges[k] = float(triangle.a[k] * px + triangle.b[k] * py + triangle.c[k]);
+                }
+                const float z = float(triangle.zx * px + triangle.zy * py + triangle.z0);
+                rasterize(depth + size_t(y) * width_ + size_t(groupX), numGroups, edges, steps, z, zStep);
+            }
+        }
+    }
+
+    void OcclusionBuffer::BuildHiZ_() {
+        for (size_t level = 1; level < levels_.size(); ++level) {
+            const std::vector<float>& below = levels_[level - 1];
+            const uint32_t belowWidth = levelSizes_[level - 1].x;
+            const uint32_t belowHeight = levelSizes_[level - 1].y;
+            std::vector<float>& current = levels_[level];
+            const uint32_t levelWidth = levelSizes_[level].x;
+            const uint32_t levelHeight = levelSizes_[level].y;
+
+            for (uint32_t y = 0; y < levelHeight; ++y) {
+                // Odd sizes clamp so the last texel covers the leftover row/column
+                const size_t y0 = size_t(2 * y) * belowWidth;
+                const size_t y1 = size_t(std::min(2 * y + 1, belowHeight - 1)) * belowWidth;
+                for (uint32_t x = 0; x < levelWidth; ++x) {
+                    const uint32_t x0 = 2 * x;
+                    const uint32_t x1 = std::min(2 * x + 1, belowWidth - 1);
+                    current[size_t(y) * levelWidth + x] = std::max(
+                        std::max(below[y0 + x0], below[y0 + x1]),
+                        std::max(below[y1 + x0], below[y1 + x1]));
+                }
+            }
+        }
+    }
+
+    bool OcclusionBuffer::IsAabbOccluded(const GpuAABB& aabb) const {
+        const glm::vec3 vmin = aabb.vmin.ToVec4();
+        const glm::vec3 vmax = aabb.vmax.ToVec4();
+
+        float minX = std::numeric_limits<float>::max();
+        float minY = std::numeric_limits<float>::max();
+        float maxX = std::numeric_limits<float>::lowest();
+        float maxY = std::numeric_limits<float>::lowest();
+        float minZ = std::numeric_limits<float>::max();
+        for (int c = 0; c < 8; ++c) {
+            const glm::vec3 corner((c & 1) ? vmax.x : vmin.x, (c & 2) ? vmax.y : vmin.y, (c & 4) ? vmax.z : vmin.z);
+            const glm::vec4 clip = projectionView_ * glm::vec4(corner, 1.0f);
+            // Anything in front of the near plane could cover the whole screen
+            if (!(clip.z + clip.w >= 0.0f) || !(clip.w > 0.0f)) return false;
+
+            const float invW = 1.0f / clip.w;
+            const float x = (clip.x * invW * 0.5f + 0.5f) * float(width_);
+            const float y = (clip.y * invW * 0.5f + 0.5f) * float(height_);
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+            minZ = std::min(minZ, clip.z * invW * 0.5f + 0.5f);
+        }
+
+        if (!(maxX >= 0.0f && maxY >= 0.0f && minX <= float(width_) && minY <= float(height_))) return false;
+
+        // Every pixel the screen rectangle touches
+        const uint32_t x0 = std::min(uint32_t(std::max(minX, 0.0f)), width_ - 1);
+        const uint32_t y0 = std::min(uint32_t(std::max(minY, 0.0f)), height_ - 1);
+        const uint32_t x1 = std::min(uint32_t(std::min(maxX, float(width_))), width_ - 1);
+        const uint32_t y1 = std::min(uint32_t(std::min(maxY, float(height_))), height_ - 1);
+
+        // Finest level where the rectangle covers at most 4x4 texels. Texel t of level L holds the
+        // furthest depth of pixels [t << L, (t + 1) << L) so this is conservative, and reading a few
+        // more texels than 2x2 keeps large boxes from picking up depth from far outside of them.
+        size_t level = 0;
+        while (level + 1 < levels_.size() && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3)) {
+            ++level;
+        }
+
+        const std::vector<float>& texels = levels_[level];
+        const uint32_t levelWidth = levelSizes_[level].x;
+        float furthest = 0.0f;
+        for (uint32_t y = y0 >> level; y <= (y1 >> level); ++y) {
+            for (uint32_t x = x0 >> level; x <= (x1 >> level); ++x) {
+                furthest = std::max(furthest, texels[size_t(y) * levelWidth + x]);
+            }
+        }
+
+        // Boxes past the far plane are clamped so an empty buffer never occludes anything
+        return std::min(minZ, 1.0f) > furthest;
+    }
+
+    size_t OcclusionBuffer::CullOccluded(const SoaAabbs& aabbs, uint8_t * visible) const {
+        const size_t size = aabbs.Size();
+        const auto cull = [this, &aabbs, visible](const size_t first, const size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                if (visible[i] != 0 && IsAabbOccluded(aabbs.Get(i))) visible[i] = 0;
+            }
+        };
+
+        TaskSystem * tasks = INSTANCE(TaskSystem);
+        if (tasks == nullptr || size < MinBoxesForParallelCull_) {
+            cull(0, size);
+        }
+        else {
+            tasks->ParallelFor(0, size, MinBoxesForParallelCull_ / 4, cull);
+        }
+
+        size_t count = 0;
+        for (size_t i = 0; i < size; ++i) count += visible[i] != 0 ? 1 : 0;
+        return count;
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "glm/glm.hpp"
+#include "StratusGpuCommon.h"
+#include "StratusFrustumCulling.h"
+
+namespace stratus {
+    // Low resolution depth buffer which low poly occluders (for example a mesh's coarsest lod) are
+    // rasterized into on the CPU, plus a hierarchical Z pyramid built from it which boxes are tested
+    // against (see "Masked Software Occlusion Culling" and "Software Occlusion Culling" from Intel).
+    //
+    // Usage per frame:
+    //      Begin(projectionView)
+    //      AddOccluder(...) for each occluder
+    //      Finish()
+    //      IsAabbOccluded / CullOccluded
+    //
+    // AddOccluder transforms, near plane clips and bins triangles into TileWidth x TileHeight screen tiles.
+    // Finish then rasterizes every tile (in parallel over the TaskSystem when there is one) using SSE
+    // coverage masks for 4 pixels at a time when the CPU supports it, and builds the HiZ pyramid where each
+    // texel is the furthest depth of the 4 texels below it.
+    //
+    // Depth is window space depth in [0, 1] where 1 is the far plane and is cleared to 1. Both windings are
+    // drawn so occluders do not need consistent face culling. Row 0 is the bottom of the screen.
+    //
+    // AddOccluder is not thread safe. Queries are read only and safe to run from several threads at once
+    // once Finish has returned.
+    class OcclusionBuffer final {
+    public:
+        static constexpr uint32_t TileWidth = 32;
+        static constexpr uint32_t TileHeight = 8;
+
+        // Dimensions are rounded up to a multiple of the tile size
+        OcclusionBuffer(const uint32_t width = 256, const uint32_t height = 128);
+
+        uint32_t Width() const;
+        uint32_t Height() const;
+
+        // Clears depth and all binned triangles
+        void Begin(const glm::mat4& projectionView);
+        // indices form a triangle list into vertices which are transformed by transform and then by the
+        // projectionView given to Begin
+        void AddOccluder(
+            const glm::vec3 * vertices,
+            const size_t numVertices,
+            const uint32_t * indices,
+            const size_t numIndices,
+            const glm::mat4& transform);
+        void Finish();
+
+        // True only if the box is certain to be hidden behind the occluders. Boxes which cross the near plane
+        // or are completely off screen are never reported as occluded (leave those to frustum culling).
+        bool IsAabbOccluded(const GpuAABB&) const;
+        // Sets visible[i] to 0 for every occluded box. Boxes which already have visible[i] == 0 (for example
+        // after CullAabbs) are skipped. Returns the number of boxes still visible.
+        size_t CullOccluded(const SoaAabbs&, uint8_t * visible) const;
+
+        // Triangles binned since Begin (after clipping)
+        size_t NumTriangles() const;
+        // Level 0 is the full resolution depth buffer
+        size_t NumLevels() const;
+        uint32_t LevelWidth(const size_t level) const;
+        uint32_t LevelHeight(const size_t level) const;
+        // Row major with LevelWidth(level) texels per row
+        const float * Depth(const size_t level = 0) const;
+
+    private:
+        // Screen space edge functions (inside when A * x + B * y + C >= 0 for all 3) and depth plane
+        // (z = zx * x + zy * y + z0). Setup is in double precision so large off screen triangles stay exact.
+        struct Triangle_ {
+            double a[3];
+            double b[3];
+            double c[3];
+            double zx;
+            double zy;
+            double z0;
+            // Pixel bounds, inclusive and clamped to the screen
+            int32_t minX;
+            int32_t minY;
+            int32_t maxX;
+            int32_t maxY;
+        };
+
+        void AddTriangle_(const glm::vec4 * clip);
+        void RasterizeTile_(const size_t tile);
+        void BuildHiZ_();
+
+    private:
+        uint32_t width_;
+        uint32_t height_;
+        uint32_t tilesX_;
+        uint32_t tilesY_;
+        glm::mat4 projectionView_ = glm::mat4(1.0f);
+        std::vector<Triangle_> triangles_;
+        // Indices into triangles_ for each tile
+        std::vector<std::vector<uint32_t>> bins_;
+        // levels_[0] is the depth buffer
+        std::vector<std::vector<float>> levels_;
+        std::vector<glm::uvec2> levelSizes_;
+    };
+
+    // Name of the rasterizer kernel selected for this CPU ("SSE" or "Scalar")
+    const char * OcclusionCullingKernelName();
+}
@@ -6,6 +6,9 @@
 #include <shared_mutex>
 #include <functional>
 #include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
 #include "StratusPointer.h"
 
 // See https://www.qt.io/blog/a-fast-and-thread-safe-pool-allocator-for-qt-part-1
@@ -362,4 +365,180 @@ namespace stratus {
     private:
         inline thread_local static std::weak_ptr<Allocator> alloc_;
     };
+
+    // Pool allocator which can be used from any number of threads at once. Each thread allocates from and
+    // frees into its own cache and only touches the shared pool (and its lock) to move a whole batch of
+    // ElemsPerBatch free elements at a time. Memory is allowed to migrate between threads: anything freed
+    // on a thread other than the one that allocated it ends up in the freeing thread's cache.
+    //
+    // Memory is never returned to the system, and the shared pool is intentionally never destroyed so that
+    // objects released during static destruction are still safe to free.
+    template<typename E, size_t ElemsPerBatch = 64>
+    struct ThreadCachedPoolAllocator final {
+        static_assert(ElemsPerBatch > 0);
+
+    private:
+        struct MemBlock_ {
+            MemBlock_ * next;
+        };
+
+    public:
+        static constexpr size_t Alignment = std::max<size_t>(alignof(E), alignof(MemBlock_));
+        static constexpr size_t BytesPerElem = (std::max<size_t>(sizeof(E), sizeof(MemBlock_)) + Alignment - 1) / Alignment * Alignment;
+        static constexpr size_t BytesPerChunk = BytesPerElem * ElemsPerBatch;
+
+        ThreadCachedPoolAllocator() = delete;
+
+        template<typename ... Types>
+        static E * AllocateConstruct(const Types&... args) {
+            return AllocateCustomConstruct(PlacementNew_<Types...>, args...);
+        }
+
+        template<typename Construct, typename ... Types>
+        static E * AllocateCustomConstruct(Construct c, const Types&... args) {
+            return c(Allocate_(), args...);
+        }
+
+        static void DestroyDeallocate(E * ptr) {
+            if (ptr == nullptr) return;
+            ptr->~E();
+            Deallocate_(reinterpret_cast<uint8_t *>(ptr));
+        }
+
+        static size_t NumChunks() {
+            SharedPool_& pool = GetSharedPool_();
+            auto ul = std::unique_lock<std::mutex>(pool.m);
+            return pool.chunks.size();
+        }
+
+        static size_t NumElems() {
+            return NumChunks() * ElemsPerBatch;
+        }
+
+    private:
+        struct alignas(Alignment) Chunk_ {
+            uint8_t memory[BytesPerChunk];
+        };
+
+        // Singly linked list of free elements
+        struct FreeList_ {
+            MemBlock_ * head = nullptr;
+            size_t count = 0;
+        };
+
+        struct SharedPool_ {
+            std::mutex m;
+            std::vector<FreeList_> batches;
+            std::vector<Chunk_ *> chunks;
+
+            FreeList_ TakeBatch() {
+                auto ul = std::unique_lock<std::mutex>(m);
+                if (batches.size() > 0) {
+                    FreeList_ batch = batches.back();
+                    batches.pop_back();
+                    return batch;
+                }
+
+                Chunk_ * chunk = new Chunk_();
+                chunks.push_back(chunk);
+                ul.unlock();
+
+                FreeList_ batch;
+                uint8_t * mem = chunk->memory + BytesPerElem * (ElemsPerBatch - 1);
+                for (size_t i = ElemsPerBatch; i > 0; --i, mem -= BytesPerElem) {
+                    MemBlock_ * b = reinterpret_cast<MemBlock_ *>(mem);
+                    b->next = batch.head;
+                    batch.head = b;
+                }
+                batch.count = ElemsPerBatch;
+                return batch;
+            }
+
+            void ReturnBatch(const FreeList_& batch) {
+                if (batch.count == 0) return;
+                auto ul = std::unique_lock<std::mutex>(m);
+                batches.push_back(batch);
+            }
+        };
+
+        struct LocalCache_ {
+            FreeList_ free;
+
+            ~LocalCache_() {
+                GetSharedPool_().ReturnBatch(free);
+                LocalCacheDestroyed_() = true;
+            }
+
+            uint8_t * Pop() {
+                if (free.head == nullptr) free = GetSharedPool_().TakeBatch();
+                MemBlock_ * b = free.head;
+                free.head = b->next;
+                --free.count;
+                return reinterpret_cast<uint8_t *>(b);
+            }
+
+            void Push(uint8_t * bytes) {
+                MemBlock_ * b = reinterpret_cast<MemBlock_ *>(bytes);
+                b->next = free.head;
+                free.head = b;
+                ++free.count;
+
+                // Keep one batch around for reuse and hand the rest back
+                if (free.count >= 2 * ElemsPerBatch) {
+                    FreeList_ batch;
+                    batch.head = free.head;
+                    batch.count = ElemsPerBatch;
+                    MemBlock_ * last = free.head;
+                    for (size_t i = 1; i < ElemsPerBatch; ++i) last = last->next;
+                    free.head = last->next;
+                    free.count -= ElemsPerBatch;
+                    last->next = nullptr;
+                    GetSharedPool_().ReturnBatch(batch);
+                }
+            }
+        };
+
+        template<typename ... Types>
+        static E * PlacementNew_(uint8_t * memory, const Types&... args) {
+            return new (memory) E(args...);
+        }
+
+        static SharedPool_& GetSharedPool_() {
+            static SharedPool_ * pool = new SharedPool_();
+            return *pool;
+        }
+
+        static bool& LocalCacheDestroyed_() {
+            thread_local bool destroyed = false;
+            return destroyed;
+        }
+
+        static LocalCache_& GetLocalCache_() {
+            thread_local LocalCache_ cache;
+            return cache;
+        }
+
+        static uint8_t * Allocate_() {
+            if (LocalCacheDestroyed_()) {
+                // Thread is exiting - bypass the cache
+                FreeList_ batch = GetSharedPool_().TakeBatch();
+                MemBlock_ * b = batch.head;
+                batch.head = b->next;
+                --batch.count;
+                GetSharedPool_().ReturnBatch(batch);
+                return reinterpret_cast<uint8_t *>(b);
+            }
+            return GetLocalCache_().Pop();
+        }
+
+        static void Deallocate_(uint8_t * bytes) {
+            if (LocalCacheDestroyed_()) {
+                MemBlock_ * b = reinterpret_cast<MemBlock_ *>(bytes);
+                b->next = nullptr;
+                GetSharedPool_().ReturnBatch(FreeList_{b, 1});
+                return;
+            }
+            GetLocalCache_().Push(bytes);
+        }
+    };
 }
\ No newline at end of file
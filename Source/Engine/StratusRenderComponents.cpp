@@ -6,6 +6,7 @@
 #include "StratusLog.h"
 #include "StratusTransformComponent.h"
 #include "StratusPoolAllocator.h"
+#include "StratusTaskSystem.h"
 #include "meshoptimizer.h"
 
 namespace stratus {
@@ -19,6 +20,25 @@ namespace stratus {
         return allocator;
     }
 
+    // Temporary index storage which comes from the calling thread's scratch memory if there is enough
+    // of it left, otherwise from the heap
+    struct ScratchIndices_ {
+        ScratchIndices_(const size_t count) {
+            UnsafePtr<StackAllocator> scratch = TaskSystem::CurrentScratch();
+            // + 1 covers alignment padding
+            if (scratch->Remaining() >= sizeof(uint32_t) * (count + 1)) {
+                data = reinterpret_cast<uint32_t *>(scratch->Allocate(sizeof(uint32_t) * count, alignof(uint32_t)));
+            }
+            else {
+                fallback.resize(count);
+                data = fallback.data();
+            }
+        }
+
+        uint32_t * data;
+        std::vector<uint32_t> fallback;
+    };
+
     MeshPtr Mesh::PlacementNew_(uint8_t * memory) {
         return new (memory) Mesh();
     }
@@ -134,23 +154,26 @@ namespace stratus {
         cpuData_->tangents.clear();
         cpuData_->bitangents.clear();
 
-        std::vector<uint32_t> indexBuffer;
-        const std::vector<uint32_t> * order;
+        StackAllocatorScope scratch(TaskSystem::CurrentScratch());
+        ScratchIndices_ indexBuffer(numIndices_ == 0 ? numVertices_ : 0);
+        const uint32_t * order;
+        size_t orderSize;
         if (numIndices_ == 0) {
-            indexBuffer.resize(numVertices_);
-            for (uint32_t i = 0; i < numVertices_; ++i) indexBuffer[i] = i;
-            order = &indexBuffer;
+            for (uint32_t i = 0; i < numVertices_; ++i) indexBuffer.data[i] = i;
+            order = indexBuffer.data;
+            orderSize = numVertices_;
         }
         else {
-            order = &cpuData_->indices;
+            order = cpuData_->indices.data();
+            orderSize = cpuData_->indices.size();
         }
 
         cpuData_->tangents = std::vector<glm::vec3>(numVertices_, glm::vec3(0.0f));
         cpuData_->bitangents = std::vector<glm::vec3>(numVertices_, glm::vec3(0.0f));
-        for (int i = 0; i < order->size(); i += 3) {
-            const uint32_t i0 = (*order)[i];
-            const uint32_t i1 = (*order)[i + 1];
-            const uint32_t i2 = (*order)[i + 2];
+        for (size_t i = 0; i < orderSize; i += 3) {
+            const uint32_t i0 = order[i];
+            const uint32_t i1 = order[i + 1];
+            const uint32_t i2 = order[i + 2];
             auto tanBitan = calculateTangentAndBitangent(cpuData_->vertices[i0], cpuData_->vertices[i1], cpuData_->vertices[i2], cpuData_->uvs[i0], cpuData_->uvs[i1], cpuData_->uvs[i2]);
             
             cpuData_->tangents[i0] += tanBitan.tangent;
@@ -282,10 +305,13 @@ namespace stratus {
         };
 
         for (int i = 0; i < errors.size(); ++i) {
+            // Simplification needs room for the full index list but usually only keeps about half of it, so
+            // the result is worked on in scratch memory and then copied out at its final size
+            StackAllocatorScope scratch(TaskSystem::CurrentScratch());
             auto& prevIndices = cpuData_->indicesPerLod[cpuData_->indicesPerLod.size() - 1];
             const size_t targetIndices = size_t(prevIndices.size() * 0.5);
-            std::vector<uint32_t> simplified(prevIndices.size());
-            auto size = meshopt_simplify(simplified.data(), prevIndices.data(), prevIndices.size(), &cpuData_->vertices[0][0], numVertices_, sizeof(float) * 3, targetIndices, 0.005f);
+            ScratchIndices_ simplified(prevIndices.size());
+            auto size = meshopt_simplify(simplified.data, prevIndices.data(), prevIndices.size(), &cpuData_->vertices[0][0], numVertices_, sizeof(float) * 3, targetIndices, 0.005f);
             //auto size = meshopt_simplify(simplified.data(), prevIndices.data(), prevIndices.size(), &cpuData_->vertices[0][0], numVertices_, sizeof(float) * 3, targetIndices, errors[i]);
             // If we didn't see at least a 10% reduction, try the more aggressive algorithm
             //if ((prevIndices.size() * 0.9) < double(size)) {
@@ -293,22 +319,23 @@ namespace stratus {
             //   error *= 2.0f;
             //   size = meshopt_simplify(simplified.data(), prevIndices.data(), prevIndices.size(), &cpuData_->vertices[0][0], numVertices_, sizeof(float) * 3, prevIndices.size() / 2, error);
             //}
-            simplified.resize(size);
-            meshopt_optimizeVertexCache(simplified.data(), simplified.data(), size, numVertices_);
-            cpuData_->indicesPerLod.push_back(std::move(simplified));
+            meshopt_optimizeVertexCache(simplified.data, simplified.data, size, numVertices_);
+            cpuData_->indicesPerLod.push_back(std::vector<uint32_t>(simplified.data, simplified.data + size));
             numIndicesPerLod_.push_back(size);
             if (size < 1024) break;
         }
 
         // One last lod computed more aggressively than the previous ones
-        auto& prevIndices = cpuData_->indicesPerLod[0];
-        std::vector<uint32_t> simplified(prevIndices.size());
-        const size_t targetIndices = std::min<size_t>(prevIndices.size(), 1024);
-        auto size = meshopt_simplify(simplified.data(), prevIndices.data(), prevIndices.size(), &cpuData_->vertices[0][0], numVertices_, sizeof(float) * 3, targetIndices, 0.8f);
-        simplified.resize(size);
-        meshopt_optimizeVertexCache(simplified.data(), simplified.data(), size, numVertices_);
-        cpuData_->indicesPerLod.push_back(std::move(simplified));
-        numIndicesPerLod_.push_back(size);
+        {
+            StackAllocatorScope scratch(TaskSystem::CurrentScratch());
+            auto& prevIndices = cpuData_->indicesPerLod[0];
+            ScratchIndices_ simplified(prevIndices.size());
+            const size_t targetIndices = std::min<size_t>(prevIndices.size(), 1024);
+            auto size = meshopt_simplify(simplified.data, prevIndices.data(), prevIndices.size(), &cpuData_->vertices[0][0], numVertices_, sizeof(float) * 3, targetIndices, 0.8f);
+            meshopt_optimizeVertexCache(simplified.data, simplified.data, size, numVertices_);
+            cpuData_->indicesPerLod.push_back(std::vector<uint32_t>(simplified.data, simplified.data + size));
+            numIndicesPerLod_.push_back(size);
+        }
 
         meshopt_optimizeVertexCache(cpuData_->indices.data(), cpuData_->indices.data(), cpuData_->indices.size(), cpuData_->vertices.size());
         cpuData_->indicesPerLod[0] = cpuData_->indices;
@@ -435,7 +462,8 @@ namespace stratus {
     }
 
     RenderComponent::RenderComponent()
-        : meshes(std::make_shared<MeshData>()) {}
+        : meshes(std::make_shared<MeshData>()),
+          materials_(std::make_shared<std::vector<MaterialPtr>>()) {}
 
     RenderComponent::RenderComponent(const RenderComponent& other) {
         this->meshes = other.meshes;
@@ -455,24 +483,32 @@ namespace stratus {
     }
 
     size_t RenderComponent::GetMaterialCount() const {
-        return materials_.size();
+        return materials_->size();
     }
 
     const std::vector<MaterialPtr>& RenderComponent::GetAllMaterials() const {
-        return materials_;
+        return *materials_;
     }
 
     const MaterialPtr& RenderComponent::GetMaterialAt(size_t index) const {
-        return materials_[index];
+        return (*materials_)[index];
     }
 
     void RenderComponent::AddMaterial(MaterialPtr material) {
-        materials_.push_back(material);
+        MakeMaterialsUnique_();
+        materials_->push_back(material);
         MarkChanged();
     }
 
     void RenderComponent::SetMaterialAt(MaterialPtr material, size_t index) {
-        materials_[index] = material;
+        MakeMaterialsUnique_();
+        (*materials_)[index] = material;
         MarkChanged();
     }
+
+    void RenderComponent::MakeMaterialsUnique_() {
+        if (materials_.use_count() > 1) {
+            materials_ = std::make_shared<std::vector<MaterialPtr>>(*materials_);
+        }
+    }
 }
\ No newline at end of file
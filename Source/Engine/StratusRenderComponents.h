@@ -140,9 +140,14 @@ namespace stratus {
         void SetMaterialAt(MaterialPtr, size_t);
 
     private:
-        // This is per RenderComponent which means the same mesh may end up being
-        // used with multiple different materials
-        std::vector<MaterialPtr> materials_;
+        // Shared copy-on-write between copies of a RenderComponent (see EntityPrefab) so that
+        // thousands of instances of the same prop don't each own a material list. Only once a
+        // component changes its materials does it get its own list, which means the same mesh
+        // may still end up being used with multiple different materials.
+        void MakeMaterialsUnique_();
+
+    private:
+        std::shared_ptr<std::vector<MaterialPtr>> materials_;
     };
 
     // If enabled then the entity interacts with light, otherwise it is flat shaded
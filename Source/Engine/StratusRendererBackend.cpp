@@ -45,8 +45,8 @@ static MaterialPtr GetMeshMaterial(const RenderMeshContainerPtr& p) {
     return p->render->GetMaterialAt(p->meshIndex);
 }
 
-static const glm::mat4& GetMeshTransform(const RenderMeshContainerPtr& p) {
-    return p->transform->transforms[p->meshIndex];
+static glm::mat4 GetMeshTransform(const RenderMeshContainerPtr& p) {
+    return p->transform->transforms[p->meshIndex].ToMat4();
 }
 
 // See https://www.khronos.org/opengl/wiki/Debug_Output
@@ -11,8 +11,10 @@
 #include "StratusEntityManager.h"
 #include "StratusGraphicsDriver.h"
 #include "StratusGpuMaterialBuffer.h"
+#include "StratusFrustumCulling.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace stratus {
     using Vec3Allocator = StackBasedPoolAllocator<glm::vec3>;
@@ -23,53 +25,57 @@ namespace stratus {
     struct RenderEntityProcess : public EntityProcess {
         virtual ~RenderEntityProcess() = default;
 
+        // Everything the renderer cares about has a RenderComponent (see IsRenderable)
+        EntityComponentSignature RequiredComponents() const override {
+            return MakeEntityComponentSignature<RenderComponent>();
+        }
+
         virtual void Process(const double deltaSeconds) {}
 
-        void EntitiesAdded(const std::unordered_set<stratus::EntityPtr>& e) override {
+        void EntitiesAdded(const EntityList& e) override {
             auto rf = INSTANCE(RendererFrontend);
             if (rf) rf->EntitiesAdded_(e);
         }
 
-        void EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>& e) override {
+        void EntitiesRemoved(const EntityList& e) override {
             auto rf = INSTANCE(RendererFrontend);
             if (rf) rf->EntitiesRemoved_(e);
         }
 
-        void EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent *>>& e) override {
+        void EntityComponentsAdded(const EntityComponentsAddedList& e) override {
             auto rf = INSTANCE(RendererFrontend);
             if (rf) rf->EntityComponentsAdded_(e);
         }
 
-        void EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>& e) override {
+        void EntityComponentsEnabledDisabled(const EntityList& e) override {
             auto rf = INSTANCE(RendererFrontend);
             if (rf) rf->EntityComponentsEnabledDisabled_(e);
         }
     };
 
-    static void InitializeMeshTransformComponent(const EntityPtr& p) {
-        if (!p->Components().ContainsComponent<MeshWorldTransforms>()) p->Components().AttachComponent<MeshWorldTransforms>();
-
-        auto global = p->Components().GetComponent<GlobalTransformComponent>().component;
-        auto rc = p->Components().GetComponent<RenderComponent>().component;
-        auto meshTransform = p->Components().GetComponent<MeshWorldTransforms>().component;
+    static void InitializeMeshTransformComponent(const GlobalTransformComponent * global, const RenderComponent * rc, MeshWorldTransforms * meshTransform) {
         meshTransform->transforms.resize(rc->GetMeshCount());
 
+        const AffineTransform globalTransform(global->GetGlobalTransform());
         for (size_t i = 0; i < rc->GetMeshCount(); ++i) {
-            meshTransform->transforms[i] = global->GetGlobalTransform() * rc->meshes->transforms[i];
+            meshTransform->transforms[i] = AffineTransform(rc->meshes->transforms[i]);
+            MultiplyAffineTransforms(1, &globalTransform, &meshTransform->transforms[i], &meshTransform->transforms[i]);
         }
     }
 
-    static bool IsStaticEntity(const EntityPtr& p) {
-        auto sc = p->Components().GetComponent<StaticObjectComponent>();
-        return sc.component != nullptr && sc.status == EntityComponentStatus::COMPONENT_ENABLED;
-    }
+    static void InitializeMeshTransformComponent(const EntityPtr& p) {
+        if (!p->Components().ContainsComponent<MeshWorldTransforms>()) p->Components().AttachComponent<MeshWorldTransforms>();
 
-    static glm::vec3 GetWorldTransform(const EntityPtr& p, const size_t meshIndex) {
-        return glm::vec3(GetTranslate(p->Components().GetComponent<MeshWorldTransforms>().component->transforms[meshIndex]));
+        InitializeMeshTransformComponent(
+            p->Components().GetComponent<GlobalTransformComponent>().component,
+            p->Components().GetComponent<RenderComponent>().component,
+            p->Components().GetComponent<MeshWorldTransforms>().component
+        );
     }
 
-    static MeshPtr GetMesh(const EntityPtr& p, const size_t meshIndex) {
-        return p->Components().GetComponent<RenderComponent>().component->GetMesh(meshIndex);
+    static bool IsStaticEntity(const EntityPtr& p) {
+        auto sc = p->Components().GetComponent<StaticObjectComponent>();
+        return sc.component != nullptr && sc.status == EntityComponentStatus::COMPONENT_ENABLED;
     }
 
     static bool InsertMesh(EntityMeshData& map, const EntityPtr& p, const size_t meshIndex) {
@@ -110,6 +116,46 @@ namespace stratus {
         return false;
     }
 
+    // Union of the entity's mesh AABBs in world space
+    static GpuAABB ComputeWorldAabb(const RenderComponent * rc, const MeshWorldTransforms * meshTransforms) {
+        glm::vec3 vmin(std::numeric_limits<float>::max());
+        glm::vec3 vmax(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < rc->GetMeshCount(); ++i) {
+            const GpuAABB world = TransformAabb(rc->GetMesh(i)->GetAABB(), meshTransforms->transforms[i]);
+            vmin = glm::min(vmin, glm::vec3(world.vmin.ToVec4()));
+            vmax = glm::max(vmax, glm::vec3(world.vmax.ToVec4()));
+        }
+
+        GpuAABB result;
+        result.vmin = glm::vec4(vmin, 1.0f);
+        result.vmax = glm::vec4(vmax, 1.0f);
+        return result;
+    }
+
+    static GpuAABB ComputeWorldAabb(const EntityPtr& p) {
+        return ComputeWorldAabb(
+            p->Components().GetComponent<RenderComponent>().component,
+            p->Components().GetComponent<MeshWorldTransforms>().component
+        );
+    }
+
+    // Mesh AABBs are computed while the mesh loads so they can only be trusted once it is finalized
+    static bool MeshesFinalized(const EntityPtr& p) {
+        const RenderComponent * rc = p->Components().GetComponent<RenderComponent>().component;
+        for (size_t i = 0; i < rc->GetMeshCount(); ++i) {
+            if (!rc->GetMesh(i)->IsFinalized()) return false;
+        }
+        return true;
+    }
+
+    static GpuAABB ComputeLightBounds(const LightPtr& light) {
+        const glm::vec3 radius(light->GetRadius());
+        GpuAABB result;
+        result.vmin = glm::vec4(light->GetPosition() - radius, 1.0f);
+        result.vmax = glm::vec4(light->GetPosition() + radius, 1.0f);
+        return result;
+    }
+
     RendererFrontend::RendererFrontend(const RendererParams& p)
         : params_(p) {
     }
@@ -124,15 +170,15 @@ namespace stratus {
         frame_->materialInfo->MarkMaterialsUnused(c);
     }
 
-    void RendererFrontend::EntitiesAdded_(const std::unordered_set<stratus::EntityPtr>& e) {
+    void RendererFrontend::EntitiesAdded_(const EntityList& e) {
         auto ul = LockWrite_();
         bool added = false;
-        for (auto ptr : e) {
+        for (const auto& ptr : e) {
             added |= AddEntity_(ptr);
         }
     }
 
-    void RendererFrontend::EntitiesRemoved_(const std::unordered_set<stratus::EntityPtr>& e) {
+    void RendererFrontend::EntitiesRemoved_(const EntityList& e) {
         auto ul = LockWrite_();
         bool removed = false;
         for (auto& ptr : e) {
@@ -140,11 +186,11 @@ namespace stratus {
         }
     }
 
-    void RendererFrontend::EntityComponentsAdded_(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent *>>& e) {
+    void RendererFrontend::EntityComponentsAdded_(const EntityComponentsAddedList& e) {
         auto ul = LockWrite_();
         bool changed = false;
         for (auto& entry : e) {
-            auto ptr = entry.first;
+            const auto& ptr = entry.entity;
             if (RemoveEntity_(ptr)) {
                 changed = true;
                 AddEntity_(ptr);
@@ -152,7 +198,7 @@ namespace stratus {
         }
     }
 
-    void RendererFrontend::EntityComponentsEnabledDisabled_(const std::unordered_set<stratus::EntityPtr>& e) {
+    void RendererFrontend::EntityComponentsEnabledDisabled_(const EntityList& e) {
         auto ul = LockWrite_();
         bool changed = false;
         for (auto& ptr : e) {
@@ -164,41 +210,45 @@ namespace stratus {
     }
 
     bool RendererFrontend::AddEntity_(const EntityPtr& p) {
-        if (p == nullptr || entities_.find(p) != entities_.end()) return false;
+        if (p == nullptr || entities_.Contains(p)) return false;
         
         if (IsRenderable(p)) {
             InitializeMeshTransformComponent(p);
 
-            entities_.insert(p);
+            entities_.Insert(p);
 
             const bool isStatic = IsStaticEntity(p);
 
             if (!isStatic) {
-                dynamicEntities_.insert(p);
+                dynamicEntities_.Add(p);
             }
 
             AddAllMaterialsForEntity_(p);
             
             frame_->drawCommands->RecordCommands(p, frame_->materialInfo);
             //_renderComponents.insert(p->Components().GetComponent<RenderComponent>().component);
+
+            GpuAABB aabb;
+            bool hasProxy = false;
+            if (GetMeshCount(p) > 0) {
+                if (MeshesFinalized(p)) {
+                    aabb = ComputeWorldAabb(p);
+                    SetEntityProxy_(p, entityBvh_.Insert(aabb, p->GetHandle().Integer()));
+                    hasProxy = true;
+                }
+                else {
+                    entitiesPendingProxy_.Insert(p);
+                }
+            }
             
             if (IsLightInteracting(p)) {
                 for (size_t i = 0; i < GetMeshCount(p); ++i) {
                     if (isStatic) InsertMesh(staticPbrEntities_, p, i);
                     else InsertMesh(dynamicPbrEntities_, p, i);
-
-                    auto mesh = GetMesh(p, i);
-                    for (auto& entry : lights_) {
-                        if (!entry->CastsShadows()) continue;
-                        auto pos = entry->GetPosition();
-                        if ((isStatic && entry->IsStaticLight()) || !entry->IsStaticLight()) {
-                            if (glm::distance(GetWorldTransform(p, i), pos) < entry->GetRadius()) {
-                            //if (DistanceFromPointToAABB(pos, mesh->GetAABB()) < entry->GetRadius()) {
-                                frame_->lightsToUpdate.PushBack(entry);
-                            }
-                        }
-                    }
                 }
+
+                if (hasProxy) MarkLightsOverlappingDirty_(aabb, isStatic);
+                else if (GetMeshCount(p) > 0) MarkLightsNearMeshesDirty_(p, isStatic);
             }
             else {
                 for (size_t i = 0; i < GetMeshCount(p); ++i) {
@@ -214,13 +264,14 @@ namespace stratus {
     }
 
     bool RendererFrontend::RemoveEntity_(const EntityPtr& p) {
-        if (p == nullptr || entities_.find(p) == entities_.end() || !IsRenderable(p)) return false;
+        if (p == nullptr || !entities_.Contains(p) || !IsRenderable(p)) return false;
 
-        entities_.erase(p);
-        dynamicEntities_.erase(p);
+        entities_.Erase(p);
+        dynamicEntities_.Remove(p);
         dynamicPbrEntities_.erase(p);
         staticPbrEntities_.erase(p);
         flatEntities_.erase(p);
+        entitiesPendingProxy_.Erase(p);
 
         RemoveAllMaterialsForEntity_(p);
 
@@ -228,34 +279,67 @@ namespace stratus {
 
         const auto entityIsStatic = IsStaticEntity(p);
 
-        for (auto& entry : lights_) {
-            if (!entry->CastsShadows()) {
-                continue;
-            }
+        const BvhProxy proxy = GetEntityProxy_(p);
+        if (proxy != NullBvhProxy) {
+            MarkLightsOverlappingDirty_(entityBvh_.GetAABB(proxy), entityIsStatic);
+            entityBvh_.Remove(proxy);
+            SetEntityProxy_(p, NullBvhProxy);
+        }
 
-            for (size_t i = 0; i < GetMeshCount(p); ++i) {
-                auto pos = entry->GetPosition();
-                if (glm::distance(GetWorldTransform(p, i), pos) > entry->GetRadius()) {
-                //if (DistanceFromPointToAABB(pos, mesh->GetAABB()) > entry->GetRadius()) {
-                    continue;
-                }
+        return true;
+    }
 
-                //if (entry.second.visible.erase(p)) {
-                if (entry->IsStaticLight()) {
-                    if (entityIsStatic) {
-                        frame_->lightsToUpdate.PushBack(entry);
-                        break;
-                    }
-                }
-                else {
-                    frame_->lightsToUpdate.PushBack(entry);
-                    break;
-                }
-            }
-            //}
+    BvhProxy RendererFrontend::GetEntityProxy_(const EntityPtr& p) const {
+        const uint32_t index = p->GetHandle().Index();
+        return index < entityProxies_.size() ? entityProxies_[index] : NullBvhProxy;
+    }
+
+    void RendererFrontend::SetEntityProxy_(const EntityPtr& p, const BvhProxy proxy) {
+        const uint32_t index = p->GetHandle().Index();
+        if (index >= entityProxies_.size()) entityProxies_.resize(size_t(index) + 1, NullBvhProxy);
+        entityProxies_[index] = proxy;
+    }
+
+    void RendererFrontend::MarkLightsOverlappingDirty_(const GpuAABB& aabb, const bool entityIsStatic) {
+        bvhQueryResults_.clear();
+        lightBvh_.QueryAabb(aabb, bvhQueryResults_);
+
+        for (const BvhProxy proxy : bvhQueryResults_) {
+            const LightPtr& light = lightsByProxy_[proxy];
+            if (!light->CastsShadows()) continue;
+            // Static lights only cache static entities
+            if (light->IsStaticLight() && !entityIsStatic) continue;
+            // Query was against the light's bounding box so narrow it down to its sphere
+            if (DistanceFromPointToAABB(light->GetPosition(), aabb) > light->GetRadius()) continue;
+
+            frame_->lightsToUpdate.PushBack(light);
         }
+    }
 
-        return true;
+    void RendererFrontend::MarkLightsNearMeshesDirty_(const EntityPtr& p, const bool entityIsStatic) {
+        const MeshWorldTransforms * meshTransforms = p->Components().GetComponent<MeshWorldTransforms>().component;
+        for (const AffineTransform& transform : meshTransforms->transforms) {
+            // Zero size box so that the light test is against the mesh origin
+            GpuAABB origin;
+            origin.vmin = glm::vec4(transform.GetTranslate(), 1.0f);
+            origin.vmax = glm::vec4(transform.GetTranslate(), 1.0f);
+            MarkLightsOverlappingDirty_(origin, entityIsStatic);
+        }
+    }
+
+    void RendererFrontend::InsertFinalizedEntityProxies_() {
+        // Back to front since Erase moves the last entity into the erased slot
+        for (size_t i = entitiesPendingProxy_.Size(); i > 0; --i) {
+            const EntityPtr p = entitiesPendingProxy_.Entities()[i - 1];
+            if (!MeshesFinalized(p)) continue;
+
+            entitiesPendingProxy_.Erase(p);
+
+            const GpuAABB aabb = ComputeWorldAabb(p);
+            SetEntityProxy_(p, entityBvh_.Insert(aabb, p->GetHandle().Integer()));
+            // Lights were only tested against the mesh origins until now
+            if (IsLightInteracting(p)) MarkLightsOverlappingDirty_(aabb, IsStaticEntity(p));
+        }
     }
 
     void RendererFrontend::AddLight(const LightPtr& light) {
@@ -265,6 +349,11 @@ namespace stratus {
         lights_.insert(light);
         frame_->lights.insert(light);
 
+        const BvhProxy proxy = lightBvh_.Insert(ComputeLightBounds(light));
+        lightProxies_.insert(std::make_pair(light, proxy));
+        if (proxy >= lightsByProxy_.size()) lightsByProxy_.resize(size_t(proxy) + 1);
+        lightsByProxy_[proxy] = light;
+
         if ( light->IsVirtualLight() ) virtualPointLights_.insert(light);
 
         if ( light->IsVirtualLight() || light->IsStaticLight() ) {
@@ -290,6 +379,11 @@ namespace stratus {
         virtualPointLights_.erase(light);
         lightsToRemove_.insert(light);
         frame_->lightsToUpdate.Erase(light);
+
+        auto proxy = lightProxies_.find(light);
+        lightBvh_.Remove(proxy->second);
+        lightsByProxy_[proxy->second].reset();
+        lightProxies_.erase(proxy);
     }
 
     void RendererFrontend::ClearLights() {
@@ -302,6 +396,9 @@ namespace stratus {
         staticLights_.clear();
         virtualPointLights_.clear();
         frame_->lightsToUpdate.Clear();
+        lightBvh_.Clear();
+        lightProxies_.clear();
+        lightsByProxy_.clear();
     }
 
     void RendererFrontend::SetWorldLight(const InfiniteLightPtr& light) {
@@ -371,12 +468,17 @@ namespace stratus {
         return jitter;
     }
 
-    SystemStatus RendererFrontend::Update(const double deltaSeconds) {
-        CHECK_IS_APPLICATION_THREAD();
-
+    SystemStatus RendererFrontend::PrepareFrame_(const double deltaSeconds) {
         auto ul = LockWrite_();
-        if (camera_ == nullptr) return SystemStatus::SYSTEM_CONTINUE;
+        if (camera_ == nullptr || framePrepared_) return SystemStatus::SYSTEM_CONTINUE;
+
+        UpdateFrameData_(deltaSeconds);
+        framePrepared_ = true;
+
+        return SystemStatus::SYSTEM_CONTINUE;
+    }
 
+    void RendererFrontend::UpdateFrameData_(const double deltaSeconds) {
         // Update per frame scratch memory if application requested a different size
         if (frame_->settings.perFrameMaxScratchMemoryBytes > 0 &&
             frame_->perFrameScratchMemory->Capacity() < frame_->settings.perFrameMaxScratchMemoryBytes) {
@@ -392,6 +494,20 @@ namespace stratus {
         UpdateCascadeData_();
         CheckForEntityChanges_();
         UpdateLights_();
+    }
+
+    SystemStatus RendererFrontend::Update(const double deltaSeconds) {
+        CHECK_IS_APPLICATION_THREAD();
+
+        auto ul = LockWrite_();
+        if (camera_ == nullptr) return SystemStatus::SYSTEM_CONTINUE;
+
+        if (!framePrepared_) UpdateFrameData_(deltaSeconds);
+        framePrepared_ = false;
+
+        // Meshes are finalized on this thread so this can't race with them finishing
+        InsertFinalizedEntityProxies_();
+
         UpdateMaterialSet_();
         UpdateDrawCommands_();
         UpdateVisibility_();
@@ -519,10 +635,16 @@ namespace stratus {
         frame_.reset();
         renderer_.reset();
 
-        entities_.clear();
-        dynamicEntities_.clear();
+        entities_.Clear();
+        dynamicEntities_.Clear();
         lights_.clear();
         lightsToRemove_.clear();
+        entityBvh_.Clear();
+        lightBvh_.Clear();
+        entitiesPendingProxy_.Clear();
+        entityProxies_.clear();
+        lightProxies_.clear();
+        lightsByProxy_.clear();
 
         INSTANCE(EntityManager)->UnregisterEntityProcess(entityHandler_);
     }
@@ -806,40 +928,38 @@ namespace stratus {
         }
     }
 
-    bool RendererFrontend::EntityChanged_(const EntityPtr& p) {
-        auto tc = p->Components().GetComponent<GlobalTransformComponent>().component;
-        auto rc = p->Components().GetComponent<RenderComponent>().component;
-        return tc->ChangedWithinLastFrame() || rc->ChangedWithinLastFrame();
-    }
+    void RendererFrontend::CheckEntitySetForChanges_(const EntityQuery<GlobalTransformComponent, RenderComponent, MeshWorldTransforms>& set) {
+        const EntityPtr * entities = set.Entities();
+        auto globals = set.Column<GlobalTransformComponent>();
+        auto renders = set.Column<RenderComponent>();
+        auto meshTransforms = set.Column<MeshWorldTransforms>();
+
+        for (size_t row = 0; row < set.Size(); ++row) {
+            if (!globals[row]->ChangedWithinLastFrame() && !renders[row]->ChangedWithinLastFrame()) continue;
+
+            const EntityPtr& entity = entities[row];
+            InitializeMeshTransformComponent(globals[row], renders[row], meshTransforms[row]);
 
-    void RendererFrontend::CheckEntitySetForChanges_(std::unordered_set<EntityPtr>& set) {
-        for (auto& entity : set) {
-            // If this is a light-interacting node, run through all the lights to see if they need to be updated
-            if (EntityChanged_(entity)) {               
-
-                InitializeMeshTransformComponent(entity);
-
-                frame_->drawCommands->UpdateTransforms(entity);
-
-                if (IsLightInteracting(entity)) {
-                    for (const auto& light : lights_) {
-                        // Static lights don't care about entity movement changes
-                        if (light->IsStaticLight()) continue;
-
-                        auto lightPos = light->GetPosition();
-                        auto lightRadius = light->GetRadius();
-                        //If the EntityView is in the light's visible set, its shadows are now out of date
-                        for (size_t i = 0; i < GetMeshCount(entity); ++i) {
-                            if (glm::distance(GetWorldTransform(entity, i), lightPos) > lightRadius) {
-                                frame_->lightsToUpdate.PushBack(light);
-                            }
-                            // If the EntityView has moved inside the light's radius, add it
-                            else if (glm::distance(GetWorldTransform(entity, i), lightPos) < lightRadius) {
-                                frame_->lightsToUpdate.PushBack(light);
-                            }
-                        }
-                    }
+            frame_->drawCommands->UpdateTransforms(entity);
+
+            const BvhProxy proxy = GetEntityProxy_(entity);
+            if (proxy == NullBvhProxy) {
+                // Still loading so its bounds aren't known yet
+                if (IsLightInteracting(entity) && entitiesPendingProxy_.Contains(entity)) {
+                    MarkLightsNearMeshesDirty_(entity, false);
                 }
+                continue;
+            }
+
+            const GpuAABB oldAabb = entityBvh_.GetAABB(proxy);
+            const GpuAABB newAabb = ComputeWorldAabb(renders[row], meshTransforms[row]);
+            entityBvh_.Update(proxy, newAabb);
+
+            // Lights the entity moved out of and lights it moved into both have out of date shadows. Dynamic
+            // entities never affect static lights.
+            if (IsLightInteracting(entity)) {
+                MarkLightsOverlappingDirty_(oldAabb, false);
+                MarkLightsOverlappingDirty_(newAabb, false);
             }
         }
     }
@@ -882,11 +1002,10 @@ namespace stratus {
 
         // Now go through and update all lights that have changed in some way
         for (auto& light : lights_) {
-            if ( !light->CastsShadows() ) continue;
-
             // See if the light moved or its radius changed
             if (light->PositionChangedWithinLastFrame() || light->RadiusChangedWithinLastFrame()) {
-                frame_->lightsToUpdate.PushBack(light);
+                lightBvh_.Update(lightProxies_.find(light)->second, ComputeLightBounds(light));
+                if ( light->CastsShadows() ) frame_->lightsToUpdate.PushBack(light);
             }
         }
     }
@@ -1049,7 +1168,6 @@ namespace stratus {
         };
 
         const glm::mat4 vp = projection * view;
-        const glm::mat4 vpt = glm::transpose(vp);
         //const glm::mat4 ivp = glm::inverse(vp);
 
         // See https://gamedev.stackexchange.com/questions/29999/how-do-i-create-a-bounding-frustum-from-a-view-projection-matrix
@@ -1072,19 +1190,9 @@ namespace stratus {
         //     corners[i] = q / q.w;
         // }
 
-        std::vector<glm::vec4, Vec4Allocator> frustumPlanes({
-            // left, right, bottom, top
-            (vpt[3] + vpt[0]),
-            (vpt[3] - vpt[0]),
-            (vpt[3] + vpt[1]),
-            (vpt[3] - vpt[1]),
-            // near, far
-            (vpt[3] + vpt[2]),
-            (vpt[3] - vpt[2]),
-            },
-
-            Vec4Allocator(frame_->perFrameScratchMemory)
-        );
+        glm::vec4 planes[6];
+        ExtractFrustumPlanes(vp, planes);
+        std::vector<glm::vec4, Vec4Allocator> frustumPlanes(planes, planes + 6, Vec4Allocator(frame_->perFrameScratchMemory));
 
         frame_->viewFrustumPlanes = frustumPlanes;
 
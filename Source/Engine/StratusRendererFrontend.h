@@ -4,6 +4,8 @@
 #include "StratusRendererBackend.h"
 #include "StratusEntity.h"
 #include "StratusEntityCommon.h"
+#include "StratusEntityQuery.h"
+#include "StratusEntitySet.h"
 #include "StratusSystemModule.h"
 #include "StratusLight.h"
 #include "StratusThread.h"
@@ -19,6 +21,7 @@
 #include "StratusPipeline.h"
 #include "StratusGpuMaterialBuffer.h"
 #include "StratusGpuCommandBuffer.h"
+#include "StratusBvh.h"
 
 namespace stratus {
     struct RendererParams {
@@ -62,18 +65,31 @@ namespace stratus {
         virtual SystemStatus Update(const double);
         virtual void Shutdown();
 
+        // CPU side frame setup (camera, viewport, cascades, transform changes and lights) which doesn't need the
+        // graphics context. The Engine runs this as its own frame job so that it can overlap with the application
+        // thread. Update does it inline if it hasn't already happened this frame.
+        SystemStatus PrepareFrame_(const double);
+
     private:
         std::unique_lock<std::shared_mutex> LockWrite_() const { return std::unique_lock<std::shared_mutex>(mutex_); }
         std::shared_lock<std::shared_mutex> LockRead_()  const { return std::shared_lock<std::shared_mutex>(mutex_); }
         void AddAllMaterialsForEntity_(const EntityPtr&);
         void RemoveAllMaterialsForEntity_(const EntityPtr&);
         bool AddEntity_(const EntityPtr& p);
-        static bool EntityChanged_(const EntityPtr&);
         bool RemoveEntity_(const EntityPtr&);
-        void CheckEntitySetForChanges_(std::unordered_set<EntityPtr>&);
+        void CheckEntitySetForChanges_(const EntityQuery<GlobalTransformComponent, RenderComponent, MeshWorldTransforms>&);
+        BvhProxy GetEntityProxy_(const EntityPtr&) const;
+        void SetEntityProxy_(const EntityPtr&, const BvhProxy);
+        // Pushes every shadow casting light overlapping aabb whose shadows depend on the entity
+        void MarkLightsOverlappingDirty_(const GpuAABB&, const bool entityIsStatic);
+        // Same as above but only tests against each mesh's origin, for entities with no bounds yet
+        void MarkLightsNearMeshesDirty_(const EntityPtr&, const bool entityIsStatic);
+        // Inserts the Bvh leaf of every entity in entitiesPendingProxy_ whose meshes have all been finalized
+        void InsertFinalizedEntityProxies_();
         void CopyMaterialToGpuAndMarkForUse_(const MaterialPtr& material, GpuMaterial* gpuMaterial);
 
     private:
+        void UpdateFrameData_(const double);
         void UpdateViewport_();
         void UpdateCascadeData_();
         void CheckForEntityChanges_();
@@ -100,16 +116,16 @@ namespace stratus {
     private:
         // These are called by the private entity handler
         friend struct RenderEntityProcess;
-        void EntitiesAdded_(const std::unordered_set<stratus::EntityPtr>&);
-        void EntitiesRemoved_(const std::unordered_set<stratus::EntityPtr>&);
-        void EntityComponentsAdded_(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent *>>&);
-        void EntityComponentsEnabledDisabled_(const std::unordered_set<stratus::EntityPtr>&);
+        void EntitiesAdded_(const EntityList&);
+        void EntitiesRemoved_(const EntityList&);
+        void EntityComponentsAdded_(const EntityComponentsAddedList&);
+        void EntityComponentsEnabledDisabled_(const EntityList&);
 
     private:
         RendererParams params_;
-        std::unordered_set<EntityPtr> entities_;
+        EntitySet entities_;
         // These are entities we need to check for position/orientation/scale updates
-        std::unordered_set<EntityPtr> dynamicEntities_;
+        EntityQuery<GlobalTransformComponent, RenderComponent, MeshWorldTransforms> dynamicEntities_;
         //std::vector<GpuMaterial> _gpuMaterials;
         std::unordered_set<LightPtr> lights_;
         std::unordered_set<LightPtr> dynamicLights_;
@@ -120,11 +136,26 @@ namespace stratus {
         EntityMeshData flatEntities_;
         EntityMeshData dynamicPbrEntities_;
         EntityMeshData staticPbrEntities_;
+        // World space bounds of every renderable entity and every light's sphere of influence
+        Bvh entityBvh_;
+        Bvh lightBvh_;
+        // Renderable entities with meshes which are still loading. They are left out of entityBvh_ until
+        // every mesh is finalized since their AABBs aren't valid before then.
+        EntitySet entitiesPendingProxy_;
+        // Indexed by EntityHandle::Index()
+        std::vector<BvhProxy> entityProxies_;
+        std::unordered_map<LightPtr, BvhProxy> lightProxies_;
+        // Indexed by lightBvh_ proxy
+        std::vector<LightPtr> lightsByProxy_;
+        // Scratch space for Bvh queries
+        std::vector<BvhProxy> bvhQueryResults_;
         uint64_t lastFrameMaterialIndicesRecomputed_ = 0;
         CameraPtr camera_;
         glm::mat4 projection_ = glm::mat4(1.0f);
         bool viewportDirty_ = true;
         bool recompileShaders_ = false;
+        // Set by PrepareFrame_ and cleared by Update
+        bool framePrepared_ = false;
         std::shared_ptr<RendererFrame> frame_;
         std::unique_ptr<RendererBackend> renderer_;
         // This forwards entity state changes to the renderer
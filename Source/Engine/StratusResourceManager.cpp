@@ -24,15 +24,30 @@ namespace stratus {
     }
 
     SystemStatus ResourceManager::Update(const double deltaSeconds) {
+        CHECK_IS_APPLICATION_THREAD();
+
         {
             auto ul = LockWrite_();
-            ClearAsyncTextureData_();
-            ClearAsyncModelData_();
+            GenerateMeshGpuData_();
         }
 
         return SystemStatus::SYSTEM_CONTINUE;
     }
 
+    SystemStatus ResourceManager::UpdateLoads_(const double deltaSeconds) {
+        std::vector<MeshPtr> meshes;
+        {
+            auto ul = LockWrite_();
+            ClearAsyncModelData_(meshes);
+        }
+
+        // Scheduled without holding the lock since the continuation needs it and runs right away if the
+        // task has already finished
+        if (meshes.size() > 0) ProcessMeshes_(std::move(meshes));
+
+        return SystemStatus::SYSTEM_CONTINUE;
+    }
+
     bool ResourceManager::Initialize() {
         InitCube_();
         InitQuad_();
@@ -41,62 +56,36 @@ namespace stratus {
     }
 
     void ResourceManager::Shutdown() {
+        for (auto& entry : modelLoadTokens_) entry.second.Cancel();
+        modelLoadTokens_.clear();
         loadedModels_.clear();
+        loadedModelPrefabs_.clear();
         pendingFinalize_.clear();
         meshFinalizeQueue_.clear();
-        asyncLoadedTextureData_.clear();
         loadedTextures_.clear();
         loadedTexturesByFile_.clear();
     }
 
-    void ResourceManager::ClearAsyncTextureData_() {
-        std::vector<TextureHandle> toDelete;
-        //constexpr size_t maxBytes = 1024 * 1024 * 10; // 10 mb per frame
-        size_t totalTex = 0;
-        size_t totalBytes = 0;
-        std::vector<TextureHandle> handles;
-        std::vector<std::shared_ptr<RawTextureData>> rawTexData;
-        for (auto& tpair : asyncLoadedTextureData_) {
-            //if (totalBytes > maxBytes) break;
-            if (tpair.second.Completed()) {
-                toDelete.push_back(tpair.first);
-                if (tpair.second.Failed()) {
-                    continue;
-                }
-                TextureHandle handle = tpair.first;
-                auto texdata = tpair.second.GetPtr();
-                if (!texdata) continue;
-                totalBytes += texdata->sizeBytes;
-                ++totalTex;
-
-                handles.push_back(handle);
-                rawTexData.push_back(texdata);
-            }
-        }
+    void ResourceManager::FinalizeAsyncTextureData_(const TextureHandle handle, const Async<RawTextureData>& as) {
+        CHECK_IS_APPLICATION_THREAD();
 
-        if (totalBytes > 0) {
-            STRATUS_LOG << "Texture data bytes processed: " << totalBytes << ", " << totalTex << std::endl;
+        // Texture calls glGenTextures so this has to happen on the application thread
+        Texture * ptr = nullptr;
+        if (as.CompleteAndValid()) {
+            ptr = FinalizeTexture_(as.Get());
+            STRATUS_LOG << "Texture data bytes processed: " << as.Get().sizeBytes << " (handle = " << handle << ")" << std::endl;
         }
 
-        for (auto handle : toDelete) asyncLoadedTextureData_.erase(handle);
-
-        ApplicationThread::Instance()->Queue([this, handles, rawTexData]() {
-            std::vector<Texture *> ptrs(rawTexData.size());
-            for (int i = 0; i < rawTexData.size(); ++i) {
-                ptrs[i] = FinalizeTexture_(*rawTexData[i]);
-            }
-
-            auto ul = LockWrite_();
-            for (int i = 0; i < handles.size(); ++i) {
-                texturesStillLoading_.erase(handles[i]);
-                loadedTextures_.insert(std::make_pair(handles[i], Async<Texture>(std::shared_ptr<Texture>(ptrs[i]))));
-            }
-        });
+        auto ul = LockWrite_();
+        texturesStillLoading_.erase(handle);
+        if (ptr != nullptr) {
+            loadedTextures_.insert(std::make_pair(handle, Async<Texture>(std::shared_ptr<Texture>(ptr))));
+        }
     }
 
-    void ResourceManager::ClearAsyncModelData_() {
+    void ResourceManager::GenerateMeshGpuData_() {
         static constexpr size_t maxModelBytesPerFrame = 1024 * 1024 * 2;
-        // First generate GPU data for some of the meshes
+        // Generate GPU data for some of the meshes
         size_t totalBytes = 0;
         std::vector<MeshPtr> removeFromGpuDataQueue;
         for (auto mesh : generateMeshGpuDataQueue_) {
@@ -110,15 +99,19 @@ namespace stratus {
         for (auto mesh : removeFromGpuDataQueue) generateMeshGpuDataQueue_.erase(mesh);
 
         if (totalBytes > 0) STRATUS_LOG << "Processed " << totalBytes << " bytes of mesh data: " << removeFromGpuDataQueue.size() << " meshes" << std::endl;
+    }
 
+    void ResourceManager::ClearAsyncModelData_(std::vector<MeshPtr>& meshes) {
         // If none other left to finalize, end early
         if (pendingFinalize_.size() == 0) return;
 
         //constexpr size_t maxBytes = 1024 * 1024 * 10; // 10 mb per frame
         std::vector<std::string> toDelete;
         for (auto& mpair : pendingFinalize_) {
-            if (mpair.second.Completed() && !mpair.second.Failed()) {
-                toDelete.push_back(mpair.first);
+            if (!mpair.second.Completed()) continue;
+
+            toDelete.push_back(mpair.first);
+            if (!mpair.second.Failed()) {
                 auto ptr = mpair.second.GetPtr();
 
                 ClearAsyncModelData_(ptr);
@@ -127,68 +120,36 @@ namespace stratus {
 
         for (const std::string& name : toDelete) {
            pendingFinalize_.erase(name);
+           modelLoadTokens_.erase(name);
         }
 
-        if (meshFinalizeQueue_.size() == 0) return;
-
-        //size_t totalBytes = 0;
-        std::vector<MeshPtr> meshesToDelete(meshFinalizeQueue_.size());
-        size_t idx = 0;
-        for (auto& mesh : meshFinalizeQueue_) {
-            meshesToDelete[idx] = mesh;
-            ++idx;
-        }
-
+        meshes.assign(meshFinalizeQueue_.begin(), meshFinalizeQueue_.end());
         meshFinalizeQueue_.clear();
+    }
 
-        // for (MeshPtr mesh : _meshFinalizeQueue) {
-        //     mesh->FinalizeData();
-        //     totalBytes += mesh->GetGpuSizeBytes();
-        //     meshesToDelete.push_back(mesh);
-        //     //if (totalBytes >= maxBytes) break;
-        // }
-
-        std::vector<Async<bool>> waiting;
-        const size_t numThreads = INSTANCE(TaskSystem)->Size();
-        for (size_t i = 0; i < numThreads; ++i) {
-            const size_t threadIndex = i;
-
-            const auto process = [this, threadIndex, numThreads, meshesToDelete]() {
-                STRATUS_LOG << "Processing " << meshesToDelete.size() << " as a task group" << std::endl;
-                for (size_t i = threadIndex; i < meshesToDelete.size(); i += numThreads) {
-                    MeshPtr mesh = meshesToDelete[i];
+    void ResourceManager::ProcessMeshes_(std::vector<MeshPtr> meshes) {
+        // Critical since these meshes are already in the scene and are only waiting on this before they can be
+        // uploaded, whereas anything still loading from disk can afford to wait a bit longer
+        Async<void> as = INSTANCE(TaskSystem)->ScheduleTask([meshes]() {
+            STRATUS_LOG << "Processing " << meshes.size() << " as a task group" << std::endl;
+            INSTANCE(TaskSystem)->ParallelFor(0, meshes.size(), 1, [&meshes](const size_t first, const size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    MeshPtr mesh = meshes[i];
                     mesh->PackCpuData();
                     mesh->CalculateAabbs(glm::mat4(1.0f));
                     mesh->GenerateLODs();
                 }
+            });
+        }, TaskPriority::CRITICAL);
 
-                return new bool(true);
-            };
-
-           waiting.push_back(INSTANCE(TaskSystem)->ScheduleTask<bool>(process));
-        }
-
-        const auto callback = [this, meshesToDelete](auto) {
-            for (auto mesh : meshesToDelete) {
+        // UpdateLoads_ runs on whichever thread the frame graph picks, so rather than a callback queued onto
+        // that thread the meshes are handed over under the lock as soon as the task finishes
+        as.Then([this, meshes](auto) {
+            auto ul = LockWrite_();
+            for (auto mesh : meshes) {
                 generateMeshGpuDataQueue_.insert(mesh);
             }
-        };
-
-        INSTANCE(TaskSystem)->AddTaskGroupCallback<bool>(callback, waiting);
-
-        // for (auto& wait : waiting) {
-        //    while (!wait.Completed())
-        //        ;
-        // }
-
-        // for (auto mesh : meshesToDelete) {
-        //    mesh->FinalizeData();
-        //    totalBytes += mesh->GetGpuSizeBytes();
-        // }
-
-        // for (MeshPtr mesh : meshesToDelete) _meshFinalizeQueue.erase(mesh);
-
-        //if (totalBytes > 0) STRATUS_LOG << "Processed " << totalBytes << " bytes of mesh data: " << meshesToDelete.size() << " meshes" << std::endl;
+        });
     }
 
     void ResourceManager::ClearAsyncModelData_(EntityPtr ptr) {
@@ -205,9 +166,15 @@ namespace stratus {
         }
     }
 
-    Async<Entity> ResourceManager::LoadModel(const std::string& name, const ColorSpace& cspace, const bool optimizeGraph, RenderFaceCulling defaultCullMode) {
+    Async<Entity> ResourceManager::LoadModel(const std::string& name, const ColorSpace& cspace, const bool optimizeGraph, RenderFaceCulling defaultCullMode,
+                                             const TaskPriority priority) {
         {
             auto sl = LockRead_();
+            auto prefab = loadedModelPrefabs_.find(name);
+            if (prefab != loadedModelPrefabs_.end()) {
+                return Async<Entity>(prefab->second->Instantiate());
+            }
+
             if (loadedModels_.find(name) != loadedModels_.end()) {
                 Async<Entity> e = loadedModels_.find(name)->second;
                 return (e.Completed() && !e.Failed()) ? Async<Entity>(e.GetPtr()->Copy()) : e;
@@ -216,15 +183,39 @@ namespace stratus {
 
         auto ul = LockWrite_();
         TaskSystem * tasks = TaskSystem::Instance();
-        Async<Entity> e = tasks->ScheduleTask<Entity>([this, name, defaultCullMode, optimizeGraph, cspace]() {
-            return LoadModel_(name, cspace, optimizeGraph, defaultCullMode);
-        });
+        CancellationToken token = CancellationToken::Create();
+        Async<Entity> e = tasks->ScheduleTask<Entity>([this, name, defaultCullMode, optimizeGraph, cspace, token]() {
+            return LoadModel_(name, cspace, optimizeGraph, defaultCullMode, token);
+        }, priority, token);
 
         loadedModels_.insert(std::make_pair(name, e));
         pendingFinalize_.insert(std::make_pair(name, e));
+        modelLoadTokens_.insert(std::make_pair(name, token));
         return e;
     }
 
+    TaskPriority ResourceManager::LoadPriorityForPosition(const glm::vec3& position) const {
+        // Anything past this many world units from the camera waits behind everything closer
+        static constexpr float maxNormalPriorityDistance = 250.0f;
+
+        const CameraPtr camera = INSTANCE(RendererFrontend)->GetCamera();
+        const glm::vec3 cameraPosition = camera != nullptr ? camera->GetPosition() : glm::vec3(0.0f);
+        return glm::distance(position, cameraPosition) <= maxNormalPriorityDistance ? TaskPriority::NORMAL : TaskPriority::BACKGROUND;
+    }
+
+    void ResourceManager::CancelModelLoad(const std::string& name) {
+        auto ul = LockWrite_();
+        auto it = modelLoadTokens_.find(name);
+        if (it == modelLoadTokens_.end()) return;
+
+        it->second.Cancel();
+        modelLoadTokens_.erase(it);
+        // Removed right away so that a new request for the same model doesn't get back the cancelled Async
+        loadedModels_.erase(name);
+        loadedModelPrefabs_.erase(name);
+        pendingFinalize_.erase(name);
+    }
+
     TextureHandle ResourceManager::LoadTexture(const std::string& name, const ColorSpace& cspace) {
         return LoadTextureImpl_({name}, cspace);
     }
@@ -266,18 +257,20 @@ namespace stratus {
 
         auto ul = LockWrite_();
         auto handle = TextureHandle::NextHandle();
-        TaskSystem * tasks = TaskSystem::Instance();
-        // We have to use the main thread since Texture calls glGenTextures :(
-        Async<RawTextureData> as = tasks->ScheduleTask<RawTextureData>([this, files, handle, cspace, type, wrap, min, mag]() {
-            auto result = LoadTexture_(files, handle, cspace, type, wrap, min, mag);
-            //auto ul = this->LockWrite_();
-            //this->texturesStillLoading_.erase(handle);
-            return result;
-        });
 
         texturesStillLoading_.insert(handle);
         loadedTexturesByFile_.insert(std::make_pair(name, handle));
-        asyncLoadedTextureData_.insert(std::make_pair(handle, as));
+
+        // When requested while loading a model this picks up the model's priority. We have to finalize on
+        // the main thread since Texture calls glGenTextures :(
+        Async<RawTextureData> as = TaskSystem::Instance()->ScheduleTask<RawTextureData>([this, files, handle, cspace, type, wrap, min, mag]() {
+            return LoadTexture_(files, handle, cspace, type, wrap, min, mag);
+        }, TaskSystem::CurrentPriority());
+
+        // Upload as soon as decoding finishes rather than waiting for Update to notice
+        as.Then(*INSTANCE(Engine)->GetMainThread(), [this, handle](Async<RawTextureData> data) {
+            FinalizeAsyncTextureData_(handle, data);
+        });
 
         return handle;
     }
@@ -643,7 +636,8 @@ namespace stratus {
         }
     }
 
-    EntityPtr ResourceManager::LoadModel_(const std::string& name, const ColorSpace& cspace, const bool optimizeGraph, RenderFaceCulling defaultCullMode) {
+    EntityPtr ResourceManager::LoadModel_(const std::string& name, const ColorSpace& cspace, const bool optimizeGraph, RenderFaceCulling defaultCullMode,
+                                          const CancellationToken& token) {
         STRATUS_LOG << "Attempting to load model: " << name << std::endl;
 
         Assimp::Importer importer;
@@ -683,6 +677,9 @@ namespace stratus {
             return nullptr;
         }
 
+        // Reading the file is by far the slowest part so check here before doing any more work
+        token.ThrowIfCancelled();
+
         // Create all scene materials
         for (uint32_t i = 0; i < scene->mNumMaterials; ++i) {
             const std::string materialName = name + "#" + std::to_string(i);
@@ -699,44 +696,27 @@ namespace stratus {
         //    ProcessMesh(mesh, scene, directory, extension, defaultCullMode, cspace);
         //}
 
-        std::vector<Async<void>> waiting;
-        // There are cases where the number of meshes to process is less than the total available threads,
-        // so in that case just use meshes.size() as the upper limit
-        const size_t numThreads = std::min(INSTANCE(TaskSystem)->Size(), meshes.size());
-        std::atomic<size_t> counter = 0;
-        // Important we start at 1 since we are including this current task thread already
-        for (size_t i = 1; i < numThreads; ++i) {
-            const size_t threadNum = i;
-            const auto process = [&counter, &meshes, threadNum, numThreads, scene, &directory, &extension, &defaultCullMode, &cspace]() {
-                size_t processed = 0;
-                for (size_t idx = threadNum; idx < meshes.size(); idx += numThreads, ++processed) {
-                    ProcessMesh(meshes[idx], scene, directory, extension, defaultCullMode, cspace);
-                }
-
-                counter += processed;
-            };
-
-            waiting.push_back(INSTANCE(TaskSystem)->ScheduleTask(process));
-        }
-
-        // Now process our portion
-        size_t processed = 0;
-        for (size_t i = 0; i < meshes.size(); i += numThreads, ++processed) {
-            ProcessMesh(meshes[i], scene, directory, extension, defaultCullMode, cspace);
-        }
+        // Meshes are independent of each other so they can be spread across all task threads (including this one)
+        INSTANCE(TaskSystem)->ParallelFor(0, meshes.size(), 1, [&](const size_t first, const size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                ProcessMesh(meshes[i], scene, directory, extension, defaultCullMode, cspace);
+            }
+        });
 
-        counter += processed;
+        token.ThrowIfCancelled();
 
-        while (counter.load() < meshes.size())
-            ;
+        // Immutable internal copy which later loads of the same model are instanced from
+        auto prefab = EntityPrefab::Create(e);
 
         auto ul = LockWrite_();
-        // Create an internal copy for thread safety
-        loadedModels_.insert(std::make_pair(name, Async<Entity>(e->Copy())));
+        // CancelModelLoad may have run since the last check, and inserting the prefab after it would bring
+        // the cancelled model back
+        token.ThrowIfCancelled();
+        loadedModelPrefabs_.insert(std::make_pair(name, prefab));
 
         STRATUS_LOG << "Model loaded [" << name << "] with [" << meshes.size() << "] meshes" << std::endl;
 
-        return e->Copy();
+        return prefab->Instantiate();
     }
 
     std::shared_ptr<ResourceManager::RawTextureData> ResourceManager::LoadTexture_(const std::vector<std::string>& files, 
@@ -853,11 +833,19 @@ namespace stratus {
     }
 
     EntityPtr ResourceManager::CreateCube() {
-        return cube_->Copy();
+        return cubePrefab_->Instantiate();
     }
 
     EntityPtr ResourceManager::CreateQuad() {
-        return quad_->Copy();
+        return quadPrefab_->Instantiate();
+    }
+
+    EntityPrefabPtr ResourceManager::GetCubePrefab() const {
+        return cubePrefab_;
+    }
+
+    EntityPrefabPtr ResourceManager::GetQuadPrefab() const {
+        return quadPrefab_;
     }
 
     static const std::vector<GLfloat> cubeData = std::vector<GLfloat>{
@@ -938,6 +926,7 @@ namespace stratus {
 
         mesh->CalculateAabbs(glm::mat4(1.0f));
         pendingFinalize_.insert(std::make_pair("DefaultCube", Async<Entity>(cube_)));
+        cubePrefab_ = EntityPrefab::Create(cube_);
 
         // rmesh->GenerateCpuData();
         // rnode->AddMeshContainer(RenderMeshContainer{rmesh, mat});
@@ -969,6 +958,7 @@ namespace stratus {
         mesh->SetFaceCulling(RenderFaceCulling::CULLING_NONE);
         mesh->CalculateAabbs(glm::mat4(1.0f));
         pendingFinalize_.insert(std::make_pair("DefaultQuad", Async<Entity>(quad_)));
+        quadPrefab_ = EntityPrefab::Create(quad_);
 
         // rmesh->GenerateCpuData();
         // rnode->AddMeshContainer(RenderMeshContainer{rmesh, mat});
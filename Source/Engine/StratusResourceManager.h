@@ -5,10 +5,12 @@
 #include "StratusThread.h"
 #include "StratusEntity.h"
 #include "StratusEntityCommon.h"
+#include "StratusEntityPrefab.h"
 #include "StratusRenderComponents.h"
 #include "StratusTexture.h"
 #include "StratusSystemModule.h"
 #include "StratusAsync.h"
+#include "StratusTaskSystem.h"
 #include <vector>
 #include <shared_mutex>
 #include <unordered_map>
@@ -45,7 +47,16 @@ namespace stratus {
 
         virtual ~ResourceManager();
 
-        Async<Entity> LoadModel(const std::string&, const ColorSpace&, const bool optimizeGraph, RenderFaceCulling defaultCullMode = RenderFaceCulling::CULLING_CCW);
+        // Priority should be lowered for assets which are far away from the camera so that they don't hold up
+        // anything closer. Textures requested by the model are decoded at the same priority.
+        Async<Entity> LoadModel(const std::string&, const ColorSpace&, const bool optimizeGraph, RenderFaceCulling defaultCullMode = RenderFaceCulling::CULLING_CCW,
+                                const TaskPriority priority = TaskPriority::NORMAL);
+        // Priority for a model which is going to be placed at the given world position, based on its distance
+        // from the current camera (or the origin if there is no camera yet)
+        TaskPriority LoadPriorityForPosition(const glm::vec3&) const;
+        // Stops a model load which has not finished yet (e.g. the entity it was for was removed). The Async returned
+        // by LoadModel fails with "Task cancelled" and the model can be requested again later.
+        void CancelModelLoad(const std::string&);
         TextureHandle LoadTexture(const std::string&, const ColorSpace&);
         // prefix is used to select all faces with one string. It ends up expanding to:
         //      prefix + "right." + fileExt
@@ -58,22 +69,34 @@ namespace stratus {
         // Default shapes
         EntityPtr CreateCube();
         EntityPtr CreateQuad();
+        // Templates the default shapes are instanced from
+        EntityPrefabPtr GetCubePrefab() const;
+        EntityPrefabPtr GetQuadPrefab() const;
 
     private:
         // SystemModule inteface
         virtual bool Initialize();
+        // Only does the work which needs the graphics context. The rest happens in UpdateLoads_.
         virtual SystemStatus Update(const double);
         virtual void Shutdown();
 
+        // Bookkeeping for finished model loads which doesn't touch the graphics context. The Engine runs this
+        // as its own frame job so that it can overlap with the application thread.
+        SystemStatus UpdateLoads_(const double);
+
     private:
-        void ClearAsyncTextureData_();
-        void ClearAsyncModelData_();
+        void FinalizeAsyncTextureData_(const TextureHandle, const Async<RawTextureData>&);
+        void GenerateMeshGpuData_();
+        // Collects the meshes of every model which finished loading
+        void ClearAsyncModelData_(std::vector<MeshPtr>&);
         void ClearAsyncModelData_(EntityPtr);
+        // Packs, computes bounds and generates LODs on the task threads, then queues the meshes for GenerateMeshGpuData_
+        void ProcessMeshes_(std::vector<MeshPtr>);
 
     private:
         std::unique_lock<std::shared_mutex> LockWrite_() const { return std::unique_lock<std::shared_mutex>(mutex_); }
         std::shared_lock<std::shared_mutex> LockRead_()  const { return std::shared_lock<std::shared_mutex>(mutex_); }
-        EntityPtr LoadModel_(const std::string&, const ColorSpace&, const bool optimizeGraph, RenderFaceCulling);
+        EntityPtr LoadModel_(const std::string&, const ColorSpace&, const bool optimizeGraph, RenderFaceCulling, const CancellationToken&);
         // Despite accepting multiple files, it assumes they all have the same format (e.g. for cube texture)
         TextureHandle LoadTextureImpl_(const std::vector<std::string>&, 
                                        const ColorSpace&,
@@ -96,12 +119,17 @@ namespace stratus {
     private:
         EntityPtr cube_;
         EntityPtr quad_;
+        EntityPrefabPtr cubePrefab_;
+        EntityPrefabPtr quadPrefab_;
         std::unordered_map<std::string, Async<Entity>> loadedModels_;
+        // Finished models which further loads are instanced from
+        std::unordered_map<std::string, EntityPrefabPtr> loadedModelPrefabs_;
         std::unordered_map<std::string, Async<Entity>> pendingFinalize_;
+        // Only contains models which are still loading
+        std::unordered_map<std::string, CancellationToken> modelLoadTokens_;
         std::unordered_set<MeshPtr> meshFinalizeQueue_;
         std::unordered_set<MeshPtr> generateMeshGpuDataQueue_;
         //std::vector<MeshPtr> _meshFinalizeQueue;
-        std::unordered_map<TextureHandle, Async<RawTextureData>> asyncLoadedTextureData_;
         std::unordered_set<TextureHandle> texturesStillLoading_;
         std::unordered_map<TextureHandle, Async<Texture>> loadedTextures_;
         std::unordered_map<std::string, TextureHandle> loadedTexturesByFile_;
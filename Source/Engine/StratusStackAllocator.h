@@ -3,6 +3,7 @@
 #include <memory>
 #include <typeinfo>
 #include <exception>
+#include <cstdint>
 #include "StratusPointer.h"
 
 // A stack allocator is meant to provide O(1) allocation by only ever moving
@@ -27,15 +28,20 @@ namespace stratus {
 			}
 		}
 
-		// Allocates a block of memory
+		// Allocates a block of memory. On failure the allocator is left unchanged.
 		void * Allocate(const size_t bytes) {
-			uint8_t * memory = current_;
-			current_ = current_ + bytes;
-			if (current_ > end_) {
+			return Allocate_(current_, bytes);
+		}
+
+		// Allocates a block of memory starting at a multiple of alignment (must be a power of 2)
+		void * Allocate(const size_t bytes, const size_t alignment) {
+			const uintptr_t address = reinterpret_cast<uintptr_t>(current_);
+			const uintptr_t aligned = (address + (alignment - 1)) & ~uintptr_t(alignment - 1);
+			if (aligned > reinterpret_cast<uintptr_t>(end_)) {
 				throw std::bad_alloc();
 			}
 
-			return reinterpret_cast<void *>(memory);
+			return Allocate_(reinterpret_cast<uint8_t *>(aligned), bytes);
 		}
 
 		// Deallocates ALL memory
@@ -43,6 +49,16 @@ namespace stratus {
 			current_ = start_;
 		}
 
+		// Mark + Rewind deallocate everything allocated after the call to Mark while
+		// leaving anything allocated before it alone
+		size_t Mark() const noexcept {
+			return current_ - start_;
+		}
+
+		void Rewind(const size_t marker) noexcept {
+			current_ = start_ + marker;
+		}
+
 		// Capacity in bytes
 		size_t Capacity() const noexcept {
 			return end_ - start_;
@@ -54,12 +70,42 @@ namespace stratus {
 			return end_ - current_;
 		}
 
+	private:
+		// Only moves current_ once the block is known to fit
+		void * Allocate_(uint8_t * memory, const size_t bytes) {
+			if (bytes > size_t(end_ - memory)) {
+				throw std::bad_alloc();
+			}
+
+			current_ = memory + bytes;
+			return reinterpret_cast<void *>(memory);
+		}
+
 	private:
 		uint8_t * start_ = nullptr;
 		uint8_t * end_ = nullptr;
 		uint8_t * current_ = nullptr;
 	};
 
+	// Rewinds the allocator back to where it was when the scope was created
+	struct StackAllocatorScope {
+		StackAllocatorScope(const UnsafePtr<StackAllocator>& allocator)
+			: allocator_(allocator), marker_(allocator_->Mark()) {}
+
+		~StackAllocatorScope() {
+			allocator_->Rewind(marker_);
+		}
+
+		StackAllocatorScope(const StackAllocatorScope&) = delete;
+		StackAllocatorScope(StackAllocatorScope&&) = delete;
+		StackAllocatorScope& operator=(const StackAllocatorScope&) = delete;
+		StackAllocatorScope& operator=(StackAllocatorScope&&) = delete;
+
+	private:
+		UnsafePtr<StackAllocator> allocator_;
+		size_t marker_;
+	};
+
 	inline static UnsafePtr<StackAllocator> GetDefaultStackAllocator_() {
 		thread_local static UnsafePtr<StackAllocator> allocator = MakeUnsafe<StackAllocator>(1024);
 		return allocator;
@@ -120,7 +166,7 @@ namespace stratus {
 		}
 
 		pointer allocate(std::size_t n) {
-			return (pointer)allocator_->Allocate(sizeof(value_type) * n);
+			return (pointer)allocator_->Allocate(sizeof(value_type) * n, alignof(value_type));
 		}
 
 		void deallocate(pointer p, std::size_t n) {
@@ -1,63 +1,147 @@
 #include "StratusTaskSystem.h"
 #include "StratusLog.h"
 #include <string>
+#include <chrono>
+#include <exception>
 
 namespace stratus {
     TaskSystem::TaskSystem() {}
-            
-    bool TaskSystem::Initialize() {
-        taskThreads_.clear();
-        // Important that this is > 1
-        unsigned int concurrency = 2;
-        if (std::thread::hardware_concurrency() > concurrency) {
-            concurrency = std::thread::hardware_concurrency();
+
+    TaskSystem::TaskSystem(const TaskSystemConfig& config)
+        : config_(config) {}
+
+    TaskSystemLayout TaskSystemLayout::Plan(const TaskSystemConfig& config, const CpuTopology& topology) {
+        TaskSystemLayout layout;
+        layout.numNumaNodes = std::max<size_t>(topology.nodes.size(), 1);
+
+        // Reserved cores come off the front of the first node, but at least one core is always left for workers
+        const size_t numCores = topology.NumCores();
+        size_t numReserved = numCores > 1 ? std::min<size_t>(config.numReservedCores, numCores - 1) : 0;
+
+        std::vector<std::vector<uint32_t>> available = topology.nodes;
+        for (auto& cores : available) {
+            const size_t count = std::min(numReserved, cores.size());
+            layout.reservedCores.insert(layout.reservedCores.end(), cores.begin(), cores.begin() + count);
+            cores.erase(cores.begin(), cores.begin() + count);
+            numReserved -= count;
         }
 
-        for (unsigned int i = 0; i < concurrency; ++i) {
-            Thread * ptr = new Thread("TaskThread#" + std::to_string(i + 1), true);
-            threadsWorking_.push_back(std::unique_ptr<std::atomic<size_t>>(new std::atomic<size_t>(0)));
-            threadToIndexMap_.insert(std::make_pair(ptr->Id(), threadsWorking_.size() - 1));
-            taskThreads_.push_back(ThreadPtr(std::move(ptr)));
+        // Workers fill up one node before moving on to the next
+        struct Slot_ { uint32_t core; uint32_t node; };
+        std::vector<Slot_> slots;
+        for (size_t node = 0; node < available.size(); ++node) {
+            for (const uint32_t core : available[node]) slots.push_back(Slot_{core, uint32_t(node)});
+        }
+
+        // Important that this is > 1
+        size_t numWorkers = config.numWorkers > 0 ? size_t(config.numWorkers) : slots.size();
+        numWorkers = std::max<size_t>(numWorkers, 2);
+
+        const bool multipleNodes = available.size() > 1;
+        for (size_t i = 0; i < numWorkers; ++i) {
+            TaskWorkerPlacement placement;
+            if (slots.size() > 0) {
+                const Slot_& slot = slots[i % slots.size()];
+                placement.numaNode = slot.node;
+                if (config.pinWorkers && numWorkers <= slots.size()) {
+                    placement.cores = {slot.core};
+                }
+                else if (config.numaAware && multipleNodes) {
+                    placement.cores = available[slot.node];
+                }
+                else if (config.pinApplicationThread && layout.reservedCores.size() > 0) {
+                    for (const Slot_& other : slots) placement.cores.push_back(other.core);
+                }
+            }
+            layout.workers.push_back(std::move(placement));
         }
 
-        nextTaskThread_ = 0;
+        return layout;
+    }
 
-        STRATUS_LOG << "Started " << Name() << " with " << concurrency << " threads" << std::endl;
+    // See https://en.wikipedia.org/wiki/Xorshift
+    static uint64_t NextRandom(uint64_t& state) {
+        uint64_t x = state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        state = x;
+        return x;
+    }
 
-        return true;
+    // Helper tasks can start running after ParallelFor has already returned (they will find no chunks
+    // left to claim) so this is reference counted rather than living on the caller's stack
+    struct TaskSystem::ParallelForState_ {
+        size_t begin;
+        size_t end;
+        size_t chunkSize;
+        size_t numChunks;
+        // Only dereferenced after claiming a chunk, at which point the caller is guaranteed to still be waiting
+        const std::function<void (size_t, size_t)> * fn;
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> completedChunks{0};
+        std::atomic<bool> failed{false};
+        std::mutex exceptionMutex;
+        std::exception_ptr exception;
+    };
+
+    TaskSystem::TaskWorker_ *& TaskSystem::CurrentWorker_() {
+        static thread_local TaskWorker_ * current = nullptr;
+        return current;
     }
+            
+    bool TaskSystem::Initialize() {
+        workers_.clear();
+        layout_ = TaskSystemLayout::Plan(config_, CpuTopology::Query());
 
-    SystemStatus TaskSystem::Update(const double) {
-        for (ThreadPtr& thread : taskThreads_) {
-            if (thread->Idle()) {
-                thread->Dispatch();
-            }
+        running_.store(true);
+
+        for (size_t i = 0; i < layout_.workers.size(); ++i) {
+            auto worker = std::make_unique<TaskWorker_>(this, i, layout_.workers[i]);
+            TaskWorker_ * ptr = worker.get();
+            ptr->randomState = 0x9E3779B97F4A7C15ull * (i + 1);
+            // Functions queued onto the worker's thread (such as Async callbacks) are picked up
+            // by that worker's loop, so only it needs to be woken
+            ptr->thread = ThreadPtr(new Thread("TaskThread#" + std::to_string(i + 1), false, [ptr]() {
+                ptr->dispatchPending.store(true);
+                ptr->wake.NotifyOne();
+            }));
+            workers_.push_back(std::move(worker));
         }
 
-        auto ul = std::unique_lock<std::mutex>(m_);
-        if (waiting_.size() == 0) return SystemStatus::SYSTEM_CONTINUE;
+        // Start only after all workers exist since they will immediately try to steal from each other
+        for (auto& worker : workers_) {
+            TaskWorker_ * ptr = worker.get();
+            ptr->context = std::thread([this, ptr]() {
+                SetCurrentThreadOsName(ptr->thread->Name());
+                if (ptr->placement.cores.size() > 0 && !SetCurrentThreadAffinity(ptr->placement.cores)) {
+                    STRATUS_WARN << "Unable to set affinity for " << ptr->thread->Name() << std::endl;
+                }
 
-        std::vector<TaskWait_ *> waiting;
-        for (TaskWait_* wait : waiting_) {
-            if (wait->CheckForCompletion()) {
-                delete wait;
-            }
-            else {
-                waiting.push_back(wait);
-            }
+                ptr->scratch = MakeUnsafe<StackAllocator>(config_.scratchBytesPerThread);
+
+                ptr->thread->RunInContext([this, ptr]() {
+                    WorkerLoop_(ptr);
+                });
+            });
         }
 
-        waiting_ = std::move(waiting);
-        
+        STRATUS_LOG << "Started " << Name() << " with " << workers_.size() << " threads across " << layout_.numNumaNodes
+                    << " NUMA node(s) and " << layout_.reservedCores.size() << " reserved core(s)" << std::endl;
+
+        return true;
+    }
+
+    SystemStatus TaskSystem::Update(const double) {
+        // Tasks and their continuations run as soon as they are able to so there is nothing to do here
         return SystemStatus::SYSTEM_CONTINUE;
     }
 
     void TaskSystem::Shutdown() {
-        bool allIdle = false;
         size_t updateCount = 0;
         size_t messageCount = 1;
         
-        while (!allIdle) {
+        while (outstanding_.load() > 0) {
             if (updateCount % 1000 == 0) {
                 STRATUS_LOG << "[" << messageCount << "] Waiting on task threads to shutdown ..." << std::endl;
                 ++messageCount;
@@ -65,24 +149,254 @@ namespace stratus {
 
             ++updateCount;
 
-            allIdle = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        running_.store(false);
+        for (auto& worker : workers_) {
+            worker->wake.NotifyAll();
+        }
+
+        for (auto& worker : workers_) {
+            worker->context.join();
+        }
+
+        workers_.clear();
+    }
+
+    UnsafePtr<StackAllocator> TaskSystem::CurrentScratch() {
+        TaskWorker_ * current = CurrentWorker_();
+        if (current != nullptr) return current->scratch;
+
+        static thread_local UnsafePtr<StackAllocator> scratch;
+        if (scratch == nullptr) {
+            TaskSystem * tasks = TaskSystem::Instance();
+            const size_t bytes = tasks != nullptr ? tasks->config_.scratchBytesPerThread : TaskSystemConfig().scratchBytesPerThread;
+            scratch = MakeUnsafe<StackAllocator>(bytes);
+        }
+        return scratch;
+    }
+
+    TaskPriority TaskSystem::CurrentPriority() {
+        TaskWorker_ * current = CurrentWorker_();
+        return current != nullptr ? current->currentPriority : TaskPriority::NORMAL;
+    }
+
+    void TaskSystem::Submit_(TaskFunction_ * task, const TaskPriority priority) {
+        outstanding_.fetch_add(1);
+        queued_.fetch_add(1);
+
+        const size_t index = size_t(priority);
+        TaskWorker_ * current = CurrentWorker_();
+        if (current != nullptr && current->owner == this) {
+            current->tasks[index].Push(task);
+        }
+        else {
+            auto ul = std::unique_lock<std::mutex>(sharedTasksMutex_);
+            sharedTasks_[index].push_back(task);
+        }
+
+        WakeOne_();
+    }
+
+    void TaskSystem::AddSleeper_(TaskWorker_ * worker) {
+        auto ul = std::unique_lock<std::mutex>(sleepersMutex_);
+        if (worker->sleeping) return;
+        worker->sleeping = true;
+        sleepers_.push_back(worker);
+    }
+
+    void TaskSystem::RemoveSleeper_(TaskWorker_ * worker) {
+        auto ul = std::unique_lock<std::mutex>(sleepersMutex_);
+        if (!worker->sleeping) return;
+        worker->sleeping = false;
+        sleepers_.erase(std::find(sleepers_.begin(), sleepers_.end(), worker));
+    }
+
+    void TaskSystem::WakeOne_() {
+        TaskWorker_ * worker = nullptr;
+        {
+            auto ul = std::unique_lock<std::mutex>(sleepersMutex_);
+            if (sleepers_.size() == 0) return;
+            // Most recently parked first since its cache is most likely to still be warm
+            worker = sleepers_.back();
+            sleepers_.pop_back();
+            worker->sleeping = false;
+        }
+        worker->wake.NotifyOne();
+    }
+
+    TaskSystem::TaskFunction_ * TaskSystem::FindTask_(TaskWorker_ * worker, TaskPriority& priority) {
+        TaskFunction_ * task = nullptr;
+        const size_t numWorkers = workers_.size();
+
+        for (size_t index = 0; index < NUM_TASK_PRIORITIES; ++index) {
+            priority = TaskPriority(index);
+
+            // Newest local work first since it is most likely to still be in cache
+            if (worker->tasks[index].Pop(task)) return task;
+
+            {
+                auto ul = std::unique_lock<std::mutex>(sharedTasksMutex_);
+                if (sharedTasks_[index].size() > 0) {
+                    task = sharedTasks_[index].front();
+                    sharedTasks_[index].pop_front();
+                    return task;
+                }
+            }
 
-            for (auto& thread : taskThreads_) {
-                if (!thread->Idle()) {
-                    allIdle = false;
-                    break;
+            // Start at a random victim and then try everyone else. With more than one NUMA node, workers
+            // on the same node are tried first since their data is more likely to be local.
+            const size_t start = size_t(NextRandom(worker->randomState) % numWorkers);
+            const size_t numPasses = layout_.numNumaNodes > 1 ? 2 : 1;
+            for (size_t pass = 0; pass < numPasses; ++pass) {
+                for (size_t i = 0; i < numWorkers; ++i) {
+                    TaskWorker_ * victim = workers_[(start + i) % numWorkers].get();
+                    if (victim == worker) continue;
+                    const bool sameNode = victim->placement.numaNode == worker->placement.numaNode;
+                    if (numPasses > 1 && sameNode != (pass == 0)) continue;
+                    if (victim->tasks[index].Steal(task)) return task;
                 }
             }
+        }
+
+        return nullptr;
+    }
+
+    void TaskSystem::ExecuteTask_(TaskWorker_ * worker, TaskFunction_ * task, const TaskPriority priority) {
+        queued_.fetch_sub(1);
+        // Restored afterwards since this can be called while waiting inside of another task
+        const TaskPriority previous = worker->currentPriority;
+        worker->currentPriority = priority;
+        {
+            StackAllocatorScope scratch(worker->scratch);
+            (*task)();
+            delete task;
+        }
+        worker->currentPriority = previous;
+        outstanding_.fetch_sub(1);
+    }
+
+    void TaskSystem::WorkerLoop_(TaskWorker_ * worker) {
+        CurrentWorker_() = worker;
+
+        while (true) {
+            if (worker->dispatchPending.exchange(false)) {
+                worker->thread->Dispatch();
+            }
+
+            TaskPriority priority;
+            TaskFunction_ * task = FindTask_(worker, priority);
+            if (task != nullptr) {
+                ExecuteTask_(worker, task, priority);
+                continue;
+            }
+
+            // Nothing to do so get ready to sleep, but check one last time in case something was
+            // submitted before we registered as a sleeper. Submit_ increments queued_ before looking
+            // for a sleeper, so either it finds us or we see its task here.
+            const auto key = worker->wake.PrepareWait();
+            AddSleeper_(worker);
+            if (!running_.load()) {
+                RemoveSleeper_(worker);
+                worker->wake.CancelWait();
+                break;
+            }
+
+            if (queued_.load() > 0 || worker->dispatchPending.load()) {
+                RemoveSleeper_(worker);
+                worker->wake.CancelWait();
+                continue;
+            }
+
+            worker->wake.Wait(key);
+            // Still registered if we were woken for our own thread's queue rather than by WakeOne_
+            RemoveSleeper_(worker);
+        }
+
+        CurrentWorker_() = nullptr;
+    }
 
-            if (!allIdle) {
-                for (auto& thread : taskThreads_) {
-                    thread->Dispatch();
+    void TaskSystem::RunParallelForChunks_(ParallelForState_& state) {
+        while (true) {
+            const size_t chunk = state.nextChunk.fetch_add(1);
+            if (chunk >= state.numChunks) break;
+
+            if (!state.failed.load()) {
+                const size_t first = state.begin + chunk * state.chunkSize;
+                const size_t last = std::min(state.end, first + state.chunkSize);
+                try {
+                    StackAllocatorScope scratch(CurrentScratch());
+                    (*state.fn)(first, last);
+                }
+                catch (...) {
+                    auto ul = std::unique_lock<std::mutex>(state.exceptionMutex);
+                    if (!state.failed.load()) {
+                        state.exception = std::current_exception();
+                        state.failed.store(true);
+                    }
                 }
+            }
+
+            state.completedChunks.fetch_add(1);
+        }
+    }
 
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    size_t TaskSystem::ChunkSize_(const size_t count, const size_t grain) const {
+        if (grain > 0) return grain;
+        // A few chunks per thread gives some room for load balancing without too much overhead
+        const size_t targetChunks = std::max<size_t>(workers_.size(), 1) * 4;
+        return std::max<size_t>((count + targetChunks - 1) / targetChunks, 1);
+    }
+
+    void TaskSystem::ParallelFor(const size_t begin, const size_t end, const size_t grain, const std::function<void (size_t, size_t)>& fn) {
+        if (end <= begin) return;
+
+        const size_t count = end - begin;
+        const size_t chunkSize = ChunkSize_(count, grain);
+        const size_t numChunks = (count + chunkSize - 1) / chunkSize;
+
+        // Not worth involving any other threads
+        if (numChunks == 1) {
+            fn(begin, end);
+            return;
+        }
+
+        auto state = std::make_shared<ParallelForState_>();
+        state->begin = begin;
+        state->end = end;
+        state->chunkSize = chunkSize;
+        state->numChunks = numChunks;
+        state->fn = &fn;
+
+        // The calling thread counts as one of the participants
+        const TaskPriority priority = CurrentPriority();
+        const size_t numHelpers = std::min(numChunks - 1, workers_.size());
+        for (size_t i = 0; i < numHelpers; ++i) {
+            Submit_(new TaskFunction_([state]() { RunParallelForChunks_(*state); }), priority);
+        }
+
+        RunParallelForChunks_(*state);
+
+        // All chunks have been claimed but some may still be running on other threads. If we are a worker
+        // we keep executing other tasks in the meantime so that nested calls can't starve the pool.
+        TaskWorker_ * worker = CurrentWorker_();
+        if (worker != nullptr && worker->owner != this) worker = nullptr;
+
+        while (state->completedChunks.load() < numChunks) {
+            if (worker != nullptr) {
+                TaskPriority taskPriority;
+                TaskFunction_ * task = FindTask_(worker, taskPriority);
+                if (task != nullptr) {
+                    ExecuteTask_(worker, task, taskPriority);
+                    continue;
+                }
             }
+            std::this_thread::yield();
         }
 
-        taskThreads_.clear();
+        if (state->exception) {
+            std::rethrow_exception(state->exception);
+        }
     }
 }
\ No newline at end of file
@@ -3,49 +3,108 @@
 #include "StratusSystemModule.h"
 #include "StratusThread.h"
 #include "StratusAsync.h"
+#include "StratusWorkStealingDeque.h"
+#include "StratusEventCount.h"
+#include "StratusCpuTopology.h"
+#include "StratusStackAllocator.h"
 
 #include <mutex>
+#include <memory>
+#include <atomic>
+#include <stdexcept>
 #include <vector>
+#include <deque>
 #include <cmath>
 #include <unordered_map>
 #include <algorithm>
 
 namespace stratus { 
-    // Allows groups of async processes to be waited on in an async manner
-    struct TaskWait_ {
-        virtual ~TaskWait_() = default;
-        virtual bool CheckForCompletion() const = 0;
+    // Workers always pick up the highest priority task available anywhere in the pool before
+    // looking at lower priorities, so background work only runs when nothing else is waiting.
+    enum class TaskPriority : int {
+        CRITICAL,
+        NORMAL,
+        BACKGROUND
     };
 
-    template<typename E>
-    struct TaskWaitImpl_ : public TaskWait_ {
-        TaskWaitImpl_(const std::function<void(const std::vector<Async<E>>&)>& callback, const std::vector<Async<E>>& group)
-            : callback(callback), group(group) {
-            thread = &Thread::Current();
+    static constexpr size_t NUM_TASK_PRIORITIES = 3;
+
+    // Cooperative cancellation. Copies share the same state, so one copy can be handed to a task while
+    // another is kept around to cancel it later. A task which is cancelled before it starts never runs
+    // and its Async fails with "Task cancelled". Long running tasks can poll IsCancelled or call
+    // ThrowIfCancelled at convenient points to stop early.
+    //
+    // Default constructed tokens can never be cancelled. Use CancellationToken::Create() for one that can.
+    class CancellationToken {
+    public:
+        CancellationToken() = default;
+
+        static CancellationToken Create() {
+            CancellationToken token;
+            token.cancelled_ = std::make_shared<std::atomic<bool>>(false);
+            return token;
         }
 
-        virtual bool CheckForCompletion() const override {
-            for (const auto& as : group) {
-                if (!as.Completed()) {
-                    return false;
-                }
-            }
+        void Cancel() const {
+            if (cancelled_ != nullptr) cancelled_->store(true);
+        }
 
-            std::function<void(const std::vector<Async<E>>&)> c = callback;
-            std::vector<Async<E>> g = group;
-            thread->Queue([c, g]() {
-                c(g);
-            });
-            return true;
+        bool CanBeCancelled() const {
+            return cancelled_ != nullptr;
         }
 
-        Thread* thread;
-        std::function<void(const std::vector<Async<E>>&)> callback;
-        std::vector<Async<E>> group;
+        bool IsCancelled() const {
+            return cancelled_ != nullptr && cancelled_->load(std::memory_order_acquire);
+        }
+
+        void ThrowIfCancelled() const {
+            if (IsCancelled()) throw std::runtime_error("Task cancelled");
+        }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> cancelled_;
+    };
+
+    struct TaskSystemConfig {
+        // 0 means one worker per available core that isn't reserved. There are always at least 2 workers.
+        uint32_t numWorkers = 0;
+        // Cores which are kept free of workers so that the application thread (which owns the graphics
+        // context) doesn't get preempted by task threads
+        uint32_t numReservedCores = 1;
+        // Pins each worker to its own core when there are enough cores to go around
+        bool pinWorkers = false;
+        // Pins the application thread to the reserved cores. Workers are then kept off of those cores.
+        bool pinApplicationThread = false;
+        // When there is more than one NUMA node, workers are kept on their node's cores and prefer to steal
+        // from other workers on the same node
+        bool numaAware = true;
+        // Size of each task thread's scratch memory (see TaskSystem::CurrentScratch)
+        size_t scratchBytesPerThread = 32 * 1024 * 1024;
+    };
+
+    // Where a single worker runs
+    struct TaskWorkerPlacement {
+        uint32_t numaNode = 0;
+        // Empty means the worker is free to run anywhere
+        std::vector<uint32_t> cores;
+    };
+
+    // Decides how many workers there are and where each of them runs. Kept separate from TaskSystem
+    // so that it can be checked against arbitrary topologies.
+    struct TaskSystemLayout {
+        std::vector<uint32_t> reservedCores;
+        std::vector<TaskWorkerPlacement> workers;
+        size_t numNumaNodes = 1;
+
+        static TaskSystemLayout Plan(const TaskSystemConfig&, const CpuTopology&);
     };
 
     // Enables easy access to asynchronous processing by providing its own Task
     // Threads which are used under the hood to support Async<E>.
+    //
+    // Scheduled tasks begin executing immediately. Each task thread owns a work stealing
+    // deque, and when a thread runs out of work it will attempt to steal from a random
+    // victim before going to sleep. Every worker has one deque per TaskPriority.
     SYSTEM_MODULE_CLASS(TaskSystem)
         TaskSystem(const TaskSystem&) = delete;
         TaskSystem(TaskSystem&&) = delete;
@@ -55,118 +114,183 @@ namespace stratus {
         virtual ~TaskSystem() {}
 
     private:
+        TaskSystem(const TaskSystemConfig&);
+
         virtual bool Initialize();
         virtual SystemStatus Update(const double);
         virtual void Shutdown();
 
     private:
-        template<typename E, typename T>
-        Async<E> CreateAsyncTask_(const T& process, const size_t index) {
-            // Increment the working #
-            threadsWorking_[index]->fetch_add(1);
-
-            const auto processWithHook = [this, index, process]() {
-                auto result = process();
-                // Decrement working counter
-                threadsWorking_[index]->fetch_sub(1);
-                return result;
-            };
-
-            auto as = Async<E>(*taskThreads_[index].get(), processWithHook);
-            return as;
-        }
-
-        Async<void> CreateAsyncVoidTask_(const std::function<void (void)>& process, const size_t index) {
-            // Increment the working #
-            threadsWorking_[index]->fetch_add(1);
-
-            const auto processWithHook = [this, index, process]() {
-                process();
-                // Decrement working counter
-                threadsWorking_[index]->fetch_sub(1);
-            };
-
-            auto as = Async<void>(*taskThreads_[index].get(), processWithHook);
-            return as;
-        }
-
-        size_t GetNextThreadIndexForTask_() {
-            if (taskThreads_.size() == 0) throw std::runtime_error("Task threads size equal to 0");
-
-            // Enter the threads with their current number of work items in a list
-            bool found = false;
-            const auto currentId = Thread::Current().Id();
-            std::vector<std::pair<ThreadHandle, size_t>> currentWorkLoads;
-            currentWorkLoads.reserve(threadToIndexMap_.size());
-            for (const auto& entry : threadToIndexMap_) {
-                if (entry.first == currentId) continue;
-                currentWorkLoads.push_back(std::make_pair(entry.first, threadsWorking_[entry.second]->load()));
-            }
-
-            const auto comparison = [](const std::pair<ThreadHandle, size_t>& a, const std::pair<ThreadHandle, size_t>& b) {
-                return a.second < b.second;
-            };
-
-            // Sort the threads based on how much work they currently have
-            std::sort(currentWorkLoads.begin(), currentWorkLoads.end(), comparison);
-            
-            // Choose the first which should have the least work items
-            return threadToIndexMap_.find(currentWorkLoads[0].first)->second;
-        }
+        typedef UniqueFunction<void(void)> TaskFunction_;
+
+        // Each worker owns a deque which it pushes/pops from and which all other
+        // workers are able to steal from when they run out of work
+        struct TaskWorker_ {
+            TaskWorker_(TaskSystem * owner, const size_t index, const TaskWorkerPlacement& placement)
+                : owner(owner), index(index), placement(placement) {}
+
+            TaskSystem * owner;
+            const size_t index;
+            const TaskWorkerPlacement placement;
+            // Functions queued onto this thread (e.g. Async callbacks) are serviced by the worker loop
+            ThreadPtr thread;
+            std::thread context;
+            // One per TaskPriority
+            WorkStealingDeque<TaskFunction_ *> tasks[NUM_TASK_PRIORITIES];
+            // Priority of the task currently being executed
+            TaskPriority currentPriority = TaskPriority::NORMAL;
+            // Allocated by the worker itself so that it ends up local to the worker's NUMA node
+            UnsafePtr<StackAllocator> scratch;
+            // Set when something was queued onto thread and needs a call to Dispatch
+            std::atomic<bool> dispatchPending{false};
+            // The worker sleeps on its own event count so that it can be woken without waking anyone else
+            EventCount wake;
+            // Guarded by sleepersMutex_
+            bool sleeping = false;
+            // Used for choosing random victims to steal from
+            uint64_t randomState;
+        };
 
         template<typename E, typename T>
-        Async<E> ScheduleTask_(const T& process) {
-            auto ul = std::unique_lock<std::mutex>(m_);
-
-            const auto index = GetNextThreadIndexForTask_();
-
-            return CreateAsyncTask_<E, T>(process, index);
+        Async<E> ScheduleTask_(const T& process, const TaskPriority priority, const CancellationToken& token) {
+            std::shared_ptr<AsyncImpl_<E>> impl;
+            if (token.CanBeCancelled()) {
+                impl = std::make_shared<AsyncImpl_<E>>(T([process, token]() {
+                    token.ThrowIfCancelled();
+                    return process();
+                }));
+            }
+            else {
+                impl = std::make_shared<AsyncImpl_<E>>(process);
+            }
+            Submit_(new TaskFunction_([impl]() { impl->Run(); }), priority);
+            return Async<E>::FromImpl_(impl);
         }
 
-        Async<void> ScheduleVoidTask_(const std::function<void (void)>& process) {
-            auto ul = std::unique_lock<std::mutex>(m_);
-
-            const auto index = GetNextThreadIndexForTask_();
-
-            return CreateAsyncVoidTask_(process, index);
-        }
+        // Pushes onto the current worker's deque if called from a worker, otherwise onto
+        // the shared queue for the given priority
+        void Submit_(TaskFunction_ *, const TaskPriority);
+        void WorkerLoop_(TaskWorker_ *);
+        // Checks the local deque, shared queue and then every other worker for each priority in turn
+        TaskFunction_ * FindTask_(TaskWorker_ *, TaskPriority&);
+        void ExecuteTask_(TaskWorker_ *, TaskFunction_ *, const TaskPriority);
+        void AddSleeper_(TaskWorker_ *);
+        void RemoveSleeper_(TaskWorker_ *);
+        // Wakes one sleeping worker (if there are any)
+        void WakeOne_();
+        // Worker which owns the calling thread (nullptr if not a worker)
+        static TaskWorker_ *& CurrentWorker_();
+
+        // Shared between a call to ParallelFor and its helper tasks
+        struct ParallelForState_;
+        static void RunParallelForChunks_(ParallelForState_&);
+        size_t ChunkSize_(const size_t count, const size_t grain) const;
 
     public:
         template<typename E>
-        Async<E> ScheduleTask(const std::function<std::shared_ptr<E> (void)>& process) {
-            return ScheduleTask_<E>(process);
+        Async<E> ScheduleTask(const std::function<std::shared_ptr<E> (void)>& process,
+                              const TaskPriority priority = TaskPriority::NORMAL,
+                              const CancellationToken& token = CancellationToken()) {
+            return ScheduleTask_<E>(process, priority, token);
         }
 
         template<typename E>
-        Async<E> ScheduleTask(const std::function<E * (void)>& process) {
-            return ScheduleTask_<E>(process);
+        Async<E> ScheduleTask(const std::function<E * (void)>& process,
+                              const TaskPriority priority = TaskPriority::NORMAL,
+                              const CancellationToken& token = CancellationToken()) {
+            return ScheduleTask_<E>(process, priority, token);
         }
 
-        Async<void> ScheduleTask(const std::function<void (void)>& process) {
-            return ScheduleVoidTask_(process);
+        Async<void> ScheduleTask(const std::function<void (void)>& process,
+                                 const TaskPriority priority = TaskPriority::NORMAL,
+                                 const CancellationToken& token = CancellationToken()) {
+            return ScheduleTask_<void>(process, priority, token);
         }
 
+        // Priority of the task running on the calling thread, or NORMAL if the calling thread is not
+        // one of the task threads. Useful for scheduling follow-up work at the same priority.
+        static TaskPriority CurrentPriority();
+
+        // Scratch memory belonging to the calling thread, meant for large temporaries which would otherwise
+        // go through the heap. Works with StackBasedPoolAllocator, for example:
+        //
+        //      std::vector<uint32_t, StackBasedPoolAllocator<uint32_t>> indices(
+        //          StackBasedPoolAllocator<uint32_t>(TaskSystem::CurrentScratch()));
+        //
+        // Anything allocated by a task is released once the task returns and anything allocated by a
+        // ParallelFor chunk is released once the chunk returns, so none of it can outlive those. Other
+        // threads get their own scratch memory the first time they call this and are responsible for
+        // releasing it (see StackAllocatorScope). Running out of scratch memory throws std::bad_alloc, so
+        // check Remaining() first if the size of the data isn't bounded.
+        static UnsafePtr<StackAllocator> CurrentScratch();
+
+        // Callback is run on the calling thread once every task in the group has completed
         template<typename E>
         void AddTaskGroupCallback(const std::function<void (const std::vector<Async<E>>&)>& callback, const std::vector<Async<E>>& group) {
-            auto ul = std::unique_lock<std::mutex>(m_);
-            waiting_.push_back(new TaskWaitImpl_<E>(callback, group));
+            WhenAll(group).AddCallback([callback](Async<std::vector<Async<E>>> as) {
+                callback(as.Get());
+            });
+        }
+
+        // Splits [begin, end) into chunks of at most grain elements and calls fn(chunkBegin, chunkEnd) for each
+        // of them across the task threads. The calling thread takes part in the work and this does not return
+        // until every chunk has finished. If grain is 0 a chunk size is chosen automatically. Helper tasks
+        // inherit the priority of the calling task.
+        //
+        // Safe to call from inside of a task (including from inside another ParallelFor). If fn throws, remaining
+        // chunks are skipped and the first exception is rethrown on the calling thread.
+        void ParallelFor(const size_t begin, const size_t end, const size_t grain, const std::function<void (size_t, size_t)>& fn);
+
+        // Same as ParallelFor except each chunk returns a partial result via fn(chunkBegin, chunkEnd). Partial
+        // results are combined in chunk order with reduce(T, T) starting from identity, so for a fixed grain the
+        // result is deterministic even for non-associative types such as float.
+        template<typename T, typename F, typename R>
+        T ParallelReduce(const size_t begin, const size_t end, const size_t grain, const T& identity, const F& fn, const R& reduce) {
+            if (end <= begin) return identity;
+
+            // Wrapped so that std::vector<bool> does not pack partials together
+            struct Partial_ { T value; };
+
+            const size_t chunkSize = ChunkSize_(end - begin, grain);
+            std::vector<Partial_> partials((end - begin + chunkSize - 1) / chunkSize, Partial_{identity});
+            ParallelFor(begin, end, chunkSize, [&](const size_t first, const size_t last) {
+                partials[(first - begin) / chunkSize].value = fn(first, last);
+            });
+
+            T result = identity;
+            for (const Partial_& partial : partials) {
+                result = reduce(result, partial.value);
+            }
+            return result;
         }
 
         size_t Size() const {
-            return taskThreads_.size();
+            return workers_.size();
+        }
+
+        const TaskSystemConfig& Config() const {
+            return config_;
+        }
+
+        const TaskSystemLayout& Layout() const {
+            return layout_;
         }
 
     private:
-        mutable std::mutex m_;
-        // The size of the following vectors/maps are immutable after initializing
-        std::vector<ThreadPtr> taskThreads_;
-        std::unordered_map<ThreadHandle, size_t> threadToIndexMap_;
-        // Measures # of work items per thread
-        std::vector<std::unique_ptr<std::atomic<size_t>>> threadsWorking_;
-        
-        // This changes with every call to wait on task group
-        //std::vector<std::pair<Thread *, std::vector<
-        std::vector<TaskWait_ *> waiting_;
-        size_t nextTaskThread_;
+        TaskSystemConfig config_;
+        TaskSystemLayout layout_;
+        // The size of this is immutable after initializing
+        std::vector<std::unique_ptr<TaskWorker_>> workers_;
+        // Tasks submitted from threads which are not workers (one per TaskPriority)
+        std::deque<TaskFunction_ *> sharedTasks_[NUM_TASK_PRIORITIES];
+        mutable std::mutex sharedTasksMutex_;
+        // Workers which are asleep (or about to be) waiting for new work to be submitted
+        std::vector<TaskWorker_ *> sleepers_;
+        std::mutex sleepersMutex_;
+        // Number of tasks submitted but not yet picked up by a worker
+        std::atomic<size_t> queued_{0};
+        // Number of tasks submitted but not yet completed
+        std::atomic<size_t> outstanding_{0};
+        std::atomic<bool> running_{false};
     };
 }
\ No newline at end of file
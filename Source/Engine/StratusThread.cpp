@@ -1,4 +1,5 @@
 #include "StratusThread.h"
+#include "StratusCpuTopology.h"
 #include <chrono>
 #include <string>
 
@@ -36,13 +37,18 @@ namespace stratus {
     Thread::Thread(bool ownsExecutionContext) : Thread(NextThreadName(), ownsExecutionContext) {}
 
     Thread::Thread(const std::string& name, bool ownsExecutionContext)
+        : Thread(name, ownsExecutionContext, ThreadFunction()) {}
+
+    Thread::Thread(const std::string& name, bool ownsExecutionContext, const ThreadFunction& onQueue)
         : name_(name),
           ownsExecutionContext_(ownsExecutionContext),
-          id_(ThreadHandle::NextHandle()) {
+          id_(ThreadHandle::NextHandle()),
+          onQueue_(onQueue) {
 
         if (ownsExecutionContext) {
             context_ = std::thread([this]() {
                 SetCurrentThread(this);
+                SetCurrentThreadOsName(name_);
                 while (this->running_.load()) {
                     this->ProcessNext_();
                 }
@@ -52,6 +58,16 @@ namespace stratus {
 
     Thread::~Thread() {
         Dispose();
+        DeleteTasks_(backQueue_);
+        DeleteTasks_(frontQueue_.PopAll());
+    }
+
+    void Thread::DeleteTasks_(Task_ * task) {
+        while (task != nullptr) {
+            Task_ * next = task->next;
+            delete task;
+            task = next;
+        }
     }
 
     void Thread::Dispatch() {
@@ -62,24 +78,47 @@ namespace stratus {
             if (processing_.load()) return;
             
             // If nothing to process, return early
-            if (frontQueue_.size() == 0) return;
+            if (frontQueue_.Empty()) return;
 
-            // Copy contents of front buffer to back buffer for processing
-            for (const auto & func : frontQueue_) backQueue_.push_back(func);
-            frontQueue_.clear();
+            // Take everything from the front buffer for processing
+            backQueue_ = frontQueue_.PopAll();
 
             // Signal ready for processing
             processing_.store(true);
         }
 
+        processingChanged_.notify_all();
+
         // If we don't own the context, use the current thread
         if (!ownsExecutionContext_) {
+            // Already running inside of RunInContext
+            if (*GetCurrentThreadPtr() == this) {
+                ProcessNext_();
+                return;
+            }
+
             SetCurrentThread(this);
             ProcessNext_();
             NullifyCurrentThread();
         }
     }
 
+    void Thread::RunInContext(const ThreadFunction& function) {
+        if (ownsExecutionContext_) {
+            throw std::runtime_error("Thread::RunInContext called on a thread which owns its execution context");
+        }
+
+        SetCurrentThread(this);
+        try {
+            function();
+        }
+        catch (...) {
+            NullifyCurrentThread();
+            throw;
+        }
+        NullifyCurrentThread();
+    }
+
     void Thread::DispatchAndSynchronize() {
         Dispatch();
         Synchronize();
@@ -90,24 +129,60 @@ namespace stratus {
     }
 
     void Thread::Dispose() {
-        running_.store(false);
-        if (ownsExecutionContext_) context_.join();
+        {
+            std::unique_lock<std::mutex> ul(mutex_);
+            running_.store(false);
+        }
+        processingChanged_.notify_all();
+        if (ownsExecutionContext_ && context_.joinable()) context_.join();
+    }
+
+    void Thread::SetSpinCount(const size_t count) {
+        spinCount_.store(count);
+    }
+
+    size_t Thread::GetSpinCount() const {
+        return spinCount_.load();
     }
 
     void Thread::Synchronize() const {
         // Wait until processing is complete
-        while (processing_.load()) std::this_thread::sleep_for(std::chrono::nanoseconds(1));
+        WaitForProcessing_(false);
+    }
+
+    void Thread::WaitForProcessing_(const bool value) const {
+        const size_t spinCount = spinCount_.load();
+        for (size_t i = 0; i < spinCount; ++i) {
+            if (processing_.load() == value || !running_.load()) return;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> ul(mutex_);
+        processingChanged_.wait(ul, [this, value]() {
+            return processing_.load() == value || !running_.load();
+        });
     }
 
     void Thread::ProcessNext_() {
-        if (processing_.load()) {
-            for (const ThreadFunction & func : backQueue_) func();
-            backQueue_.clear();
-            processing_.store(false); // Signal completion
+        // Only the private context needs to wait - otherwise Dispatch already checked processing_
+        if (ownsExecutionContext_) {
+            WaitForProcessing_(true);
         }
-        else {
-            // Sleep a bit to prevent hogging CPU core
-            std::this_thread::sleep_for(std::chrono::nanoseconds(1));
+
+        if (processing_.load()) {
+            Task_ * task = backQueue_;
+            backQueue_ = nullptr;
+            while (task != nullptr) {
+                task->function();
+                Task_ * next = task->next;
+                delete task;
+                task = next;
+            }
+            {
+                std::unique_lock<std::mutex> ul(mutex_);
+                processing_.store(false); // Signal completion
+            }
+            processingChanged_.notify_all();
         }
     }
 
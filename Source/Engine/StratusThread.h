@@ -5,11 +5,14 @@
 #include <atomic>
 #include <mutex>
 #include <shared_mutex>
+#include <condition_variable>
 #include <functional>
 #include <vector>
 #include <unordered_map>
 #include "StratusHandle.h"
 #include "StratusCommon.h"
+#include "StratusUniqueFunction.h"
+#include "StratusMpscQueue.h"
 
 namespace stratus {
     class Thread;
@@ -24,7 +27,21 @@ namespace stratus {
     // To use it, functions are pushed onto the queue using Queue. These are stored
     // until the next call to Dispatch, which happens from outside the thread. This is useful
     // in the sense that the main game loop can keep all thread in-sync to some extent.
+    //
+    // Queue is lock-free and can be called from any thread. Each queued function is moved into
+    // a single allocation and is never copied after that. Dispatch should only be called by one
+    // thread at a time.
     class Thread {
+        // Intrusive node for the lock-free queue
+        struct Task_ {
+            template<typename F>
+            Task_(F&& function)
+                : function(std::forward<F>(function)) {}
+
+            UniqueFunction<void(void)> function;
+            Task_ * next = nullptr;
+        };
+
     public:
         typedef std::function<void(void)> ThreadFunction;
 
@@ -33,6 +50,9 @@ namespace stratus {
         // perform each function.
         Thread(bool ownsExecutionContext);
         Thread(const std::string & name, bool ownsExecutionContext);
+        // onQueue is called each time new functions are queued which allows whoever is responsible
+        // for calling Dispatch to be woken up (see TaskSystem)
+        Thread(const std::string & name, bool ownsExecutionContext, const ThreadFunction& onQueue);
         ~Thread();
 
         Thread(const Thread&) = delete;
@@ -40,14 +60,34 @@ namespace stratus {
         Thread& operator=(const Thread&) = delete;
         Thread& operator=(Thread&&) = delete;
 
+        // If functions is an rvalue its elements will be moved rather than copied
         template<typename E>
-        void QueueMany(const E& functions) {
-            std::unique_lock<std::mutex> ul(mutex_);
-            for (auto & func : functions) frontQueue_.push_back(func);
+        void QueueMany(E&& functions) {
+            // Link newest to oldest so the whole batch can be pushed at once
+            Task_ * first = nullptr;
+            Task_ * last = nullptr;
+            for (auto & func : functions) {
+                Task_ * task;
+                if constexpr (std::is_rvalue_reference<E&&>::value) {
+                    task = new Task_(std::move(func));
+                }
+                else {
+                    task = new Task_(func);
+                }
+                task->next = first;
+                first = task;
+                if (last == nullptr) last = task;
+            }
+
+            if (first == nullptr) return;
+            frontQueue_.PushMany(first, last);
+            if (onQueue_) onQueue_();
         }
 
-        void Queue(const ThreadFunction& function) {
-            QueueMany(std::vector<ThreadFunction>{function});
+        template<typename F>
+        void Queue(F&& function) {
+            frontQueue_.Push(new Task_(std::forward<F>(function)));
+            if (onQueue_) onQueue_();
         }
 
         // Two modes of operation: if ownsExecutionContext was true, functions will be pulled
@@ -55,6 +95,10 @@ namespace stratus {
         // will be used as the context.
         void Dispatch();
         void DispatchAndSynchronize();
+        // Runs the function on the calling thread with this Thread set as Thread::Current() for the duration
+        // of the call. Only valid if ownsExecutionContext was false. This allows for custom worker loops
+        // which still call Dispatch from time to time to service their queue.
+        void RunInContext(const ThreadFunction&);
         // Blocks the calling function until all functions from the previous call to Dispatch are complete
         void Synchronize() const;
         // Checks if the thread is ready for the next call to Dispatch meaning it is sitting idle (note that
@@ -62,6 +106,11 @@ namespace stratus {
         bool Idle() const;
         // Tells the thread to quit after it finishes executing the last call to Dispatch
         void Dispose();
+        // Number of times the thread will check for new work (or Synchronize will check for completion)
+        // before going to sleep. Higher values reduce wake up latency at the cost of burning CPU time
+        // while idle. Default is 0 which means always sleep right away.
+        void SetSpinCount(const size_t);
+        size_t GetSpinCount() const;
         // Gets thread name set in constructor (note: not required to be unique)
         const std::string& Name() const;
         // Returns the unique id for this thread
@@ -75,6 +124,9 @@ namespace stratus {
 
     private:
         void ProcessNext_();
+        static void DeleteTasks_(Task_ *);
+        // Spins for up to spinCount_ iterations waiting for processing_ == value, then blocks
+        void WaitForProcessing_(const bool value) const;
 
     private:
         // May be empty if ownsExecutionContext is false
@@ -85,14 +137,20 @@ namespace stratus {
         const bool ownsExecutionContext_;
         // Uniquely identifies the thread
         const ThreadHandle id_;
+        // Optional notification for when functions are queued
+        const ThreadFunction onQueue_;
         // While true the thread can continue servicing calls to Dispatch
         std::atomic<bool> running_{true};
         // List of functions to execute on next call to Dispatch
-        std::vector<ThreadFunction> frontQueue_;
-        std::vector<ThreadFunction> backQueue_;
-        // Protects critical section
+        MpscQueue<Task_> frontQueue_;
+        // Functions being executed for the current call to Dispatch
+        Task_ * backQueue_ = nullptr;
+        // Protects dispatch state
         mutable std::mutex mutex_;
         // When true it signals to the dispatch thread that it should begin its next batch of work
         std::atomic<bool> processing_{false};
+        // Signaled whenever processing_ changes or the thread is told to quit
+        mutable std::condition_variable processingChanged_;
+        std::atomic<size_t> spinCount_{0};
     };
 }
\ No newline at end of file
@@ -1,6 +1,37 @@
 #include "StratusTransformComponent.h"
+#include "StratusPoolAllocator.h"
+#include "StratusTaskSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
 
 namespace stratus {
+    // Local transforms which changed since TransformProcess last ran. Only the pointer value is
+    // used (as a key into TransformProcess::localRows_) so it is fine if the component has been
+    // destroyed by the time it is processed.
+    struct LocalTransformChange_ {
+        const LocalTransformComponent * component;
+        LocalTransformChange_ * next = nullptr;
+
+        LocalTransformChange_(const LocalTransformComponent * component)
+            : component(component) {}
+    };
+
+    typedef ThreadCachedPoolAllocator<LocalTransformChange_> LocalTransformChangeAllocator_;
+
+    // The only TransformProcess allowed to exist (nullptr if there isn't one)
+    static std::atomic<TransformProcess *> currentTransformProcess_(nullptr);
+
+    // Generations are unique across TransformProcess instances so that a component which was queued on a
+    // previous one is still queued on the next
+    static uint64_t NextChangeGeneration_() {
+        static std::atomic<uint64_t> next(1);
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Below this many dirty rows it is not worth going wide
+    static constexpr size_t MinRowsForParallelUpdate_ = 2048;
+
     EntityPtr CreateTransformEntity() {
         auto ptr = Entity::Create();
         InitializeTransformEntity(ptr);
@@ -57,20 +88,16 @@ namespace stratus {
 
     void LocalTransformComponent::MarkChangedAndRecalculate_() {
         this->MarkChanged();
-        auto S = glm::mat4(1.0f);
-        matScale(S, scale_);
-        auto R = glm::mat4(1.0f);
-        matInset(R, rotation_); 
-        auto T = glm::mat4(1.0f);
-        matTranslate(T, position_);
-        transform_ = T * R * S;
-        /*
-        glm::mat3 RS = _rotation;
-        matScale(RS, _scale);
-        _transform = glm::mat4(1.0f);
-        matTranslate(_transform, _position);
-        matInset(_transform, RS);
-        */
+
+        // With no TransformProcess there is nothing to drain the change. Once one is registered it
+        // updates every row on its first Process anyway.
+        TransformProcess * process = currentTransformProcess_.load(std::memory_order_acquire);
+        if (process != nullptr) process->QueueChange_(this);
+
+        // Same result as T * R * S without the two full mat4 products
+        AffineTransform transform;
+        ComposeAffineTransforms(1, &scale_, &rotation_, &position_, &transform);
+        transform_ = transform.ToMat4();
     }
 
     const glm::mat4& GlobalTransformComponent::GetGlobalTransform() const {
@@ -82,105 +109,235 @@ namespace stratus {
         transform_ = m;
     }
 
-    TransformProcess::~TransformProcess() {}
+    TransformProcess::TransformProcess()
+        : generation_(NextChangeGeneration_()) {
 
-    void TransformProcess::Process(const double deltaSeconds) {
-        for (auto root : rootNodes_) {
-            ProcessNode_(root);
+        TransformProcess * expected = nullptr;
+        if (!currentTransformProcess_.compare_exchange_strong(expected, this)) {
+            throw std::runtime_error("Only one TransformProcess can exist at a time");
         }
     }
 
-    void TransformProcess::EntitiesAdded(const std::unordered_set<stratus::EntityPtr>& entities) {
-        for (auto ptr : entities) {
-            if (IsEntityRelevant_(ptr)) {
-                std::vector<EntityComponent *> components{
-                    ptr->Components().GetComponent<LocalTransformComponent>().component,
-                    ptr->Components().GetComponent<GlobalTransformComponent>().component
-                };
-                
-                components_.insert(std::make_pair(ptr, std::move(components)));
+    TransformProcess::~TransformProcess() {
+        currentTransformProcess_.store(nullptr, std::memory_order_release);
 
-                if (ptr->GetParentNode() == nullptr) {
-                    rootNodes_.insert(ptr);
-                    ProcessNode_(ptr);
-                }
-            }
+        LocalTransformChange_ * changes = changes_.PopAll();
+        while (changes != nullptr) {
+            LocalTransformChange_ * next = changes->next;
+            LocalTransformChangeAllocator_::DestroyDeallocate(changes);
+            changes = next;
         }
     }
 
-    void TransformProcess::EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>& entities) {
-        for (auto ptr : entities) {
-            rootNodes_.erase(ptr);
-            components_.erase(ptr);
+    void TransformProcess::QueueChange_(LocalTransformComponent * component) {
+        const uint64_t generation = generation_.load(std::memory_order_relaxed);
+        if (component->queuedGeneration_ != generation) {
+            component->queuedGeneration_ = generation;
+            changes_.Push(LocalTransformChangeAllocator_::AllocateConstruct(component));
         }
     }
 
-    void TransformProcess::EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent *>>& entities) {
-        std::unordered_set<EntityPtr> added;
-        for (auto p : entities) {
-            if (IsEntityRelevant_(p.first)) {
-                added.insert(p.first);
-            }
+    EntityComponentSignature TransformProcess::RequiredComponents() const {
+        return MakeEntityComponentSignature<LocalTransformComponent, GlobalTransformComponent>();
+    }
+
+    EntityProcessAccess TransformProcess::ComponentAccess() const {
+        return EntityProcessAccess(
+            MakeEntityComponentSignature<LocalTransformComponent>(),
+            MakeEntityComponentSignature<GlobalTransformComponent>()
+        );
+    }
+
+    void TransformProcess::Process(const double deltaSeconds) {
+        if (hierarchyDirty_) {
+            RebuildHierarchy_();
+            // Rows moved around so recompute everything once. This also takes care of new entities.
+            UpdateRanges_({std::make_pair(size_t(0), transforms_.Size())});
+        }
+
+        UpdateDirtyRows_();
+    }
+
+    void TransformProcess::EntitiesAdded(const EntityList& entities) {
+        for (const auto& ptr : entities) {
+            if (transforms_.Add(ptr)) hierarchyDirty_ = true;
         }
+    }
 
-        EntitiesAdded(added);
+    void TransformProcess::EntitiesRemoved(const EntityList& entities) {
+        for (const auto& ptr : entities) {
+            if (transforms_.Remove(ptr)) hierarchyDirty_ = true;
+        }
     }
 
-    void TransformProcess::EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>& entities) {
-        std::unordered_set<EntityPtr> added;
-        std::unordered_set<EntityPtr> removed;
-        for (auto ptr : entities) {
-            if (IsEntityRelevant_(ptr)) {
-                added.insert(ptr);
+    void TransformProcess::EntityComponentsAdded(const EntityComponentsAddedList& entities) {
+        for (const auto& entry : entities) {
+            if (transforms_.Add(entry.entity)) hierarchyDirty_ = true;
+        }
+    }
+
+    void TransformProcess::EntityComponentsEnabledDisabled(const EntityList& entities) {
+        for (const auto& ptr : entities) {
+            transforms_.Refresh(ptr);
+        }
+        hierarchyDirty_ = true;
+    }
+
+    void TransformProcess::RebuildHierarchy_() {
+        hierarchyDirty_ = false;
+
+        // Find the top of every tree with at least one entity in the query
+        std::vector<EntityPtr> roots;
+        std::unordered_set<const Entity *> seen;
+        const EntityPtr * entities = transforms_.Entities();
+        for (size_t row = 0; row < transforms_.Size(); ++row) {
+            EntityPtr root = entities[row];
+            for (auto parent = root->GetParentNode(); parent != nullptr; parent = parent->GetParentNode()) {
+                root = parent;
             }
-            else {
-                removed.insert(ptr);
+            if (seen.insert(root.get()).second) roots.push_back(root);
+        }
+
+        // Number the rows in depth-first order. Entities which are not part of the query are still
+        // walked through so that all of their descendants stay inside of the subtree range.
+        std::unordered_map<const Entity *, std::pair<size_t, size_t>> order;
+        size_t next = 0;
+        std::vector<std::pair<EntityPtr, bool>> stack;
+        for (const EntityPtr& root : roots) {
+            stack.push_back(std::make_pair(root, false));
+            while (stack.size() > 0) {
+                auto [e, finished] = stack.back();
+                stack.pop_back();
+                const bool member = transforms_.Contains(e);
+                if (finished) {
+                    if (member) order[e.get()].second = next;
+                    continue;
+                }
+
+                if (member) order[e.get()] = std::make_pair(next++, size_t(0));
+                stack.push_back(std::make_pair(e, true));
+                const auto& children = e->GetChildNodes();
+                for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                    stack.push_back(std::make_pair(*it, false));
+                }
             }
         }
 
-        EntitiesAdded(added);
-        EntitiesRemoved(removed);
+        transforms_.SortBy([&order](const EntityPtr& e) {
+            return order.find(e.get())->second.first;
+        });
+
+        const size_t size = transforms_.Size();
+        entities = transforms_.Entities();
+        auto locals = transforms_.Column<LocalTransformComponent>();
+        parentRows_.resize(size);
+        subtreeEnds_.resize(size);
+        localRows_.clear();
+        for (size_t row = 0; row < size; ++row) {
+            auto parent = entities[row]->GetParentNode();
+            parentRows_[row] = parent != nullptr ? transforms_.RowOf(parent) : transforms_.NullRow;
+            subtreeEnds_[row] = order.find(entities[row].get())->second.second;
+            localRows_.insert(std::make_pair(locals[row], row));
+        }
     }
 
-    bool TransformProcess::IsEntityRelevant_(const EntityPtr& e) {
-        auto& components = e->Components();
-        auto local = components.GetComponent<LocalTransformComponent>();
-        auto global = components.GetComponent<GlobalTransformComponent>();
-        if (local.component == nullptr || global.component == nullptr) return false;
-        return local.status == EntityComponentStatus::COMPONENT_ENABLED &&
-            global.status == EntityComponentStatus::COMPONENT_ENABLED;
+    void TransformProcess::UpdateDirtyRows_() {
+        LocalTransformChange_ * changes = changes_.PopAll();
+        generation_.store(NextChangeGeneration_(), std::memory_order_relaxed);
+        if (changes == nullptr) return;
+
+        std::vector<size_t> dirty;
+        while (changes != nullptr) {
+            LocalTransformChange_ * next = changes->next;
+            auto it = localRows_.find(changes->component);
+            if (it != localRows_.end()) dirty.push_back(it->second);
+            LocalTransformChangeAllocator_::DestroyDeallocate(changes);
+            changes = next;
+        }
+
+        // Changing a node invalidates its whole subtree. Any dirty row which falls inside of an
+        // earlier dirty row's subtree is already covered.
+        std::sort(dirty.begin(), dirty.end());
+        std::vector<std::pair<size_t, size_t>> ranges;
+        for (const size_t row : dirty) {
+            if (ranges.size() > 0 && row < ranges.back().second) continue;
+            ranges.push_back(std::make_pair(row, subtreeEnds_[row]));
+        }
+
+        UpdateRanges_(ranges);
     }
 
-    void TransformProcess::ProcessNode_(const EntityPtr& p) {
-        auto it = components_.find(p);
-        if (it == components_.end()) return;
+    void TransformProcess::UpdateRanges_(const std::vector<std::pair<size_t, size_t>>& dirty) {
+        size_t numRows = 0;
+        for (const auto& range : dirty) numRows += range.second - range.first;
 
-        bool parentChanged = false;
-        auto parent = p->GetParentNode();
-        GlobalTransformComponent * parentGlobal = nullptr;
-        if (parent != nullptr) {
-            auto itparent = components_.find(parent);
-            if (itparent != components_.end()) {
-                auto local = (LocalTransformComponent *)itparent->second[0];
-                auto global = (GlobalTransformComponent *)itparent->second[1];
-                parentChanged = local->ChangedLastFrame() || global->ChangedThisFrame();
-                parentGlobal = global;
-            }
+        TaskSystem * tasks = INSTANCE(TaskSystem);
+        if (tasks == nullptr || numRows < MinRowsForParallelUpdate_) {
+            for (const auto& range : dirty) UpdateRange_(range.first, range.second);
+            return;
         }
 
-        auto local = (LocalTransformComponent *)it->second[0];
-        auto global = (GlobalTransformComponent *)it->second[1];
+        // Independent subtrees can be updated in parallel. If there are too few of them to keep
+        // every thread busy, split the largest ones by updating their root first and then treating
+        // each of its child subtrees separately.
+        std::vector<std::pair<size_t, size_t>> ranges = dirty;
+        const size_t targetRanges = 4 * (tasks->Size() + 1);
+        const size_t minRangeSize = numRows / targetRanges + 1;
+        for (size_t split = 0; split < 4 && ranges.size() < targetRanges; ++split) {
+            std::vector<std::pair<size_t, size_t>> refined;
+            for (const auto& range : ranges) {
+                if (range.second - range.first <= minRangeSize) {
+                    refined.push_back(range);
+                    continue;
+                }
 
-        // See if local or parent changed requiring recompute of global transform
-        if (parentChanged || local->ChangedLastFrame()) {
-            global->SetGlobalTransform_(
-                (parentGlobal ? parentGlobal->GetGlobalTransform() : glm::mat4(1.0f)) * local->GetLocalTransform()
-            );
+                UpdateRange_(range.first, range.first + 1);
+                for (size_t child = range.first + 1; child < range.second; child = subtreeEnds_[child]) {
+                    refined.push_back(std::make_pair(child, subtreeEnds_[child]));
+                }
+            }
+            ranges = std::move(refined);
         }
 
-        // Process each child node recursively
-        for (auto c : p->GetChildNodes()) {
-            ProcessNode_(c);
+        tasks->ParallelFor(0, ranges.size(), 1, [this, &ranges](const size_t first, const size_t last) {
+            for (size_t i = first; i < last; ++i) UpdateRange_(ranges[i].first, ranges[i].second);
+        });
+    }
+
+    void TransformProcess::UpdateRange_(const size_t begin, const size_t end) {
+        auto locals = transforms_.Column<LocalTransformComponent>();
+        auto globals = transforms_.Column<GlobalTransformComponent>();
+
+        // Rows are gathered into contiguous batches for MultiplyAffineTransforms. A batch is cut short when
+        // a row's parent is part of it since the parent's global transform has to be written back first.
+        // Siblings (and especially leaves) usually end up in the same batch.
+        constexpr size_t batchSize = 64;
+        AffineTransform parentTransforms[batchSize];
+        AffineTransform localTransforms[batchSize];
+        AffineTransform results[batchSize];
+        size_t batchBegin = begin;
+        size_t batchCount = 0;
+
+        const auto flush = [&]() {
+            MultiplyAffineTransforms(batchCount, parentTransforms, localTransforms, results);
+            for (size_t i = 0; i < batchCount; ++i) {
+                globals[batchBegin + i]->SetGlobalTransform_(results[i].ToMat4());
+            }
+            batchBegin += batchCount;
+            batchCount = 0;
+        };
+
+        for (size_t row = begin; row < end; ++row) {
+            const size_t parent = parentRows_[row];
+            if (batchCount == batchSize || (parent != transforms_.NullRow && parent >= batchBegin)) flush();
+
+            parentTransforms[batchCount] = parent != transforms_.NullRow
+                ? AffineTransform(globals[parent]->GetGlobalTransform())
+                : AffineTransform();
+            localTransforms[batchCount] = AffineTransform(locals[row]->GetLocalTransform());
+            ++batchCount;
         }
+
+        if (batchCount > 0) flush();
     }
 }
\ No newline at end of file
@@ -3,13 +3,17 @@
 #include "StratusEntity.h"
 #include "StratusEntityCommon.h"
 #include "StratusEntityProcess.h"
+#include "StratusEntityQuery.h"
 #include "StratusUtils.h"
 #include "StratusMath.h"
+#include "StratusAffineTransform.h"
+#include "StratusMpscQueue.h"
 
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <mutex>
+#include <atomic>
 
 namespace stratus {
     // Convenience functions for creating a new entity or initializing existing entity
@@ -19,6 +23,8 @@ namespace stratus {
 
     // Contains scale, rotate, translate for local coordinate system
     ENTITY_COMPONENT_STRUCT(LocalTransformComponent)
+        friend class TransformProcess;
+
         LocalTransformComponent() = default;
         LocalTransformComponent(const LocalTransformComponent&) = default;
 
@@ -45,6 +51,8 @@ namespace stratus {
         glm::mat3 rotation_ = glm::mat3(1.0f);
         glm::vec3 position_ = glm::vec3(0.0f);
         glm::mat4 transform_ = glm::mat4(1.0f);
+        // Used by TransformProcess to only queue each component once between updates
+        uint64_t queuedGeneration_ = 0;
     };
 
     ENTITY_COMPONENT_STRUCT(GlobalTransformComponent)
@@ -67,27 +75,55 @@ namespace stratus {
         MeshWorldTransforms() = default;
         MeshWorldTransforms(const MeshWorldTransforms&) = default;
 
-        std::vector<glm::mat4> transforms;
+        // Compact 3x4 form which is uploaded to the GPU as-is
+        std::vector<AffineTransform> transforms;
     };
 
+    struct LocalTransformChange_;
+
+    // Computes every GlobalTransformComponent from the entity hierarchy. LocalTransformComponent queues its
+    // changes on the current TransformProcess so only one can exist at a time (EntityManager registers it
+    // during Initialize). Constructing a second one throws std::runtime_error.
     class TransformProcess : public EntityProcess {
-        virtual ~TransformProcess();
+        friend struct LocalTransformComponent;
 
-        void Process(const double deltaSeconds) override;
-        void EntitiesAdded(const std::unordered_set<stratus::EntityPtr>&) override;
-        void EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>&) override;
-        void EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent *>>&) override;
-        void EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>&) override;
+    public:
+        TransformProcess();
 
     private:
-        static bool IsEntityRelevant_(const EntityPtr&);
+        virtual ~TransformProcess();
+
+        EntityComponentSignature RequiredComponents() const override;
+        EntityProcessAccess ComponentAccess() const override;
+        void Process(const double deltaSeconds) override;
+        void EntitiesAdded(const EntityList&) override;
+        void EntitiesRemoved(const EntityList&) override;
+        void EntityComponentsAdded(const EntityComponentsAddedList&) override;
+        void EntityComponentsEnabledDisabled(const EntityList&) override;
 
     private:
-        void ProcessNode_(const EntityPtr& p);
+        void QueueChange_(LocalTransformComponent *);
+        void RebuildHierarchy_();
+        void UpdateDirtyRows_();
+        void UpdateRanges_(const std::vector<std::pair<size_t, size_t>>&);
+        void UpdateRange_(const size_t begin, const size_t end);
 
     private:
-        std::unordered_set<EntityPtr> rootNodes_;
-        // For quick access without needing to query the entity
-        std::unordered_map<EntityPtr, std::vector<EntityComponent *>> components_;
+        // Rows are in depth-first order so parents always come before their children and
+        // every subtree occupies a contiguous range of rows
+        EntityQuery<LocalTransformComponent, GlobalTransformComponent> transforms_;
+        // Row of each entity's parent within transforms_ (NullRow for roots)
+        std::vector<size_t> parentRows_;
+        // The entity at row r and all of its descendants occupy [r, subtreeEnds_[r])
+        std::vector<size_t> subtreeEnds_;
+        // Maps changed local transforms back to their row
+        std::unordered_map<const LocalTransformComponent *, size_t> localRows_;
+        // Set whenever rows are added or removed
+        bool hierarchyDirty_ = false;
+        // Local transforms which changed since UpdateDirtyRows_ last drained it
+        MpscQueue<LocalTransformChange_> changes_;
+        // Components queue themselves at most once per generation. A new one starts every time
+        // changes_ is drained.
+        std::atomic<uint64_t> generation_;
     };
 }
\ No newline at end of file
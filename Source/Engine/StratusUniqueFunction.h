@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+namespace stratus {
+    template<typename Signature, size_t InlineBytes = 48>
+    class UniqueFunction;
+
+    // Move-only replacement for std::function. Callables which fit inside of InlineBytes (and which
+    // can be moved without throwing) are stored inline so that no heap allocation is needed. Larger
+    // callables are heap allocated once and then only their pointer is moved around.
+    //
+    // Since copying is not supported, it can also hold move-only callables such as lambdas which
+    // capture a std::unique_ptr.
+    template<typename R, typename ... Args, size_t InlineBytes>
+    class UniqueFunction<R(Args...), InlineBytes> {
+        static_assert(InlineBytes >= sizeof(void *));
+
+        struct Ops_ {
+            R (*invoke)(void *, Args&&...);
+            void (*move)(void * dst, void * src);
+            void (*destroy)(void *);
+        };
+
+        template<typename F>
+        static constexpr bool StoreInline_ = sizeof(F) <= InlineBytes &&
+                                             alignof(F) <= alignof(std::max_align_t) &&
+                                             std::is_nothrow_move_constructible<F>::value;
+
+        template<typename F>
+        static F * Get_(void * storage) {
+            if constexpr (StoreInline_<F>) {
+                return std::launder(reinterpret_cast<F *>(storage));
+            }
+            else {
+                return *reinterpret_cast<F **>(storage);
+            }
+        }
+
+        template<typename F>
+        static const Ops_ * OpsFor_() {
+            static const Ops_ ops = {
+                [](void * storage, Args&&... args) -> R {
+                    return (*Get_<F>(storage))(std::forward<Args>(args)...);
+                },
+                [](void * dst, void * src) {
+                    if constexpr (StoreInline_<F>) {
+                        F * f = Get_<F>(src);
+                        ::new (dst) F(std::move(*f));
+                        f->~F();
+                    }
+                    else {
+                        *reinterpret_cast<F **>(dst) = *reinterpret_cast<F **>(src);
+                    }
+                },
+                [](void * storage) {
+                    if constexpr (StoreInline_<F>) {
+                        Get_<F>(storage)->~F();
+                    }
+                    else {
+                        delete Get_<F>(storage);
+                    }
+                }
+            };
+            return &ops;
+        }
+
+    public:
+        UniqueFunction() = default;
+        UniqueFunction(std::nullptr_t) {}
+
+        template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, UniqueFunction>::value>>
+        UniqueFunction(F&& function) {
+            typedef std::decay_t<F> Callable;
+            if constexpr (StoreInline_<Callable>) {
+                ::new (static_cast<void *>(storage_)) Callable(std::forward<F>(function));
+            }
+            else {
+                *reinterpret_cast<Callable **>(storage_) = new Callable(std::forward<F>(function));
+            }
+            ops_ = OpsFor_<Callable>();
+        }
+
+        UniqueFunction(UniqueFunction&& other) noexcept {
+            MoveFrom_(other);
+        }
+
+        UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+            if (this != &other) {
+                Reset_();
+                MoveFrom_(other);
+            }
+            return *this;
+        }
+
+        UniqueFunction(const UniqueFunction&) = delete;
+        UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+        ~UniqueFunction() {
+            Reset_();
+        }
+
+        R operator()(Args... args) {
+            if (ops_ == nullptr) throw std::bad_function_call();
+            return ops_->invoke(static_cast<void *>(storage_), std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const noexcept {
+            return ops_ != nullptr;
+        }
+
+        // True if a callable of type F would be stored without a heap allocation
+        template<typename F>
+        static constexpr bool StoresInline() {
+            return StoreInline_<std::decay_t<F>>;
+        }
+
+    private:
+        void MoveFrom_(UniqueFunction& other) noexcept {
+            if (other.ops_ == nullptr) return;
+            other.ops_->move(static_cast<void *>(storage_), static_cast<void *>(other.storage_));
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+
+        void Reset_() noexcept {
+            if (ops_ == nullptr) return;
+            ops_->destroy(static_cast<void *>(storage_));
+            ops_ = nullptr;
+        }
+
+    private:
+        alignas(std::max_align_t) unsigned char storage_[InlineBytes];
+        const Ops_ * ops_ = nullptr;
+    };
+}
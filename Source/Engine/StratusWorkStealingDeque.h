@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+// See "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli)
+// for the algorithm this is based on
+
+namespace stratus {
+    // Chase-Lev work stealing deque. One thread (the owner) is allowed to call Push and Pop which
+    // operate on the bottom of the deque in LIFO order. Any number of other threads are allowed to call
+    // Steal which removes from the top in FIFO order.
+    //
+    // E must be trivially copyable (generally this will be a pointer).
+    template<typename E>
+    class WorkStealingDeque {
+        static_assert(std::is_trivially_copyable<E>::value);
+
+        struct Buffer_ {
+            Buffer_(const int64_t capacity)
+                : capacity(capacity),
+                  mask(capacity - 1),
+                  elements(new std::atomic<E>[capacity]) {}
+
+            E Get(const int64_t index) const {
+                return elements[index & mask].load(std::memory_order_relaxed);
+            }
+
+            void Put(const int64_t index, const E& elem) {
+                elements[index & mask].store(elem, std::memory_order_relaxed);
+            }
+
+            const int64_t capacity;
+            const int64_t mask;
+            std::unique_ptr<std::atomic<E>[]> elements;
+        };
+
+    public:
+        // Initial capacity is rounded up to the next power of 2 and grows as needed
+        WorkStealingDeque(const int64_t capacity = 1024) {
+            int64_t pow2 = 1;
+            while (pow2 < capacity) pow2 <<= 1;
+            buffers_.push_back(std::make_unique<Buffer_>(pow2));
+            buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque(WorkStealingDeque&&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+        ~WorkStealingDeque() = default;
+
+        // Owner thread only
+        void Push(const E& elem) {
+            const int64_t b = bottom_.load(std::memory_order_relaxed);
+            const int64_t t = top_.load(std::memory_order_acquire);
+            Buffer_ * buffer = buffer_.load(std::memory_order_relaxed);
+            if (b - t > buffer->capacity - 1) {
+                buffer = Grow_(buffer, b, t);
+            }
+            buffer->Put(b, elem);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+
+        // Owner thread only - returns false if empty
+        bool Pop(E& out) {
+            const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+            Buffer_ * buffer = buffer_.load(std::memory_order_relaxed);
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top_.load(std::memory_order_relaxed);
+
+            bool success = true;
+            if (t <= b) {
+                out = buffer->Get(b);
+                // Last element - race against thieves for it
+                if (t == b) {
+                    success = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    bottom_.store(b + 1, std::memory_order_relaxed);
+                }
+            }
+            else {
+                success = false;
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+
+            return success;
+        }
+
+        // Any thread - returns false if empty or if it lost a race with another thread
+        bool Steal(E& out) {
+            int64_t t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t b = bottom_.load(std::memory_order_acquire);
+
+            if (t < b) {
+                Buffer_ * buffer = buffer_.load(std::memory_order_acquire);
+                E elem = buffer->Get(t);
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return false;
+                }
+                out = elem;
+                return true;
+            }
+
+            return false;
+        }
+
+        // Approximate since other threads may be modifying the deque
+        int64_t Size() const {
+            const int64_t b = bottom_.load(std::memory_order_relaxed);
+            const int64_t t = top_.load(std::memory_order_relaxed);
+            return b >= t ? b - t : 0;
+        }
+
+        bool Empty() const {
+            return Size() == 0;
+        }
+
+    private:
+        Buffer_ * Grow_(Buffer_ * buffer, const int64_t bottom, const int64_t top) {
+            auto grown = std::make_unique<Buffer_>(buffer->capacity * 2);
+            for (int64_t i = top; i < bottom; ++i) {
+                grown->Put(i, buffer->Get(i));
+            }
+            Buffer_ * ptr = grown.get();
+            // Thieves may still be reading from the old buffer so it is kept alive
+            // until the deque is destroyed
+            buffers_.push_back(std::move(grown));
+            buffer_.store(ptr, std::memory_order_release);
+            return ptr;
+        }
+
+    private:
+        alignas(64) std::atomic<int64_t> top_{0};
+        alignas(64) std::atomic<int64_t> bottom_{0};
+        std::atomic<Buffer_ *> buffer_{nullptr};
+        // All buffers ever allocated (only modified by owner thread)
+        std::vector<std::unique_ptr<Buffer_>> buffers_;
+    };
+}
@@ -4,9 +4,10 @@ STRATUS_GLSL_VERSION
 
 #include "aabb.glsl"
 #include "mesh_data.glsl"
+#include "model_transform.glsl"
 
 layout (std430, binding = 13) readonly buffer SSBO3 {
-    mat4 modelMatrices[];
+    mat3x4 modelMatrices[];
 };
 
 layout (std430, binding = 14) readonly buffer inputBlock3 {
@@ -17,7 +18,7 @@ uniform mat4 projectionView;
 uniform int modelIndex;
 
 void main() {
-    AABB aabb = transformAabb(aabbs[modelIndex], modelMatrices[modelIndex]);
+    AABB aabb = transformAabb(aabbs[modelIndex], decodeModelTransform(modelMatrices[modelIndex]));
     vec4 corners[8] = computeCornersWithTransform(aabb, projectionView);
     vec4 vertices[24] = convertCornersToLineVertices(corners);
 
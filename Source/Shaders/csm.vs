@@ -12,10 +12,11 @@ STRATUS_GLSL_VERSION
 #extension GL_ARB_shader_viewport_layer_array : require
 
 #include "mesh_data.glsl"
+#include "model_transform.glsl"
 #include "common.glsl"
 
 layout (std430, binding = 13) readonly buffer SSBO3 {
-    mat4 modelMatrices[];
+    mat3x4 modelMatrices[];
 };
 
 uniform mat4 shadowMatrix;
@@ -37,5 +38,5 @@ void main () {
 	// Since dot(l, n) = cos(theta) when both are normalized, below should compute tan theta
 	//fsTanTheta = 3.0 * tan(acos(dot(normalize(lightDir), getNormal(gl_VertexID))));
 	vec3 position = getPosition(gl_VertexID);
-	gl_Position = shadowMatrix * modelMatrices[gl_DrawID] * vec4(position, 1.0);
+	gl_Position = shadowMatrix * decodeModelTransform(modelMatrices[gl_DrawID]) * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -3,13 +3,14 @@ STRATUS_GLSL_VERSION
 #extension GL_ARB_bindless_texture : require
 
 #include "mesh_data.glsl"
+#include "model_transform.glsl"
 
 layout (std430, binding = 13) readonly buffer SSBO3 {
-    mat4 modelMatrices[];
+    mat3x4 modelMatrices[];
 };
 
 uniform mat4 projectionView;
 
 void main() {
-    gl_Position = projectionView * modelMatrices[gl_DrawID] * vec4(getPosition(gl_VertexID), 1.0);
+    gl_Position = projectionView * decodeModelTransform(modelMatrices[gl_DrawID]) * vec4(getPosition(gl_VertexID), 1.0);
 }
\ No newline at end of file
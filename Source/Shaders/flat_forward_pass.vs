@@ -3,13 +3,14 @@ STRATUS_GLSL_VERSION
 #extension GL_ARB_bindless_texture : require
 
 #include "mesh_data.glsl"
+#include "model_transform.glsl"
 
 layout (std430, binding = 13) readonly buffer SSBO3 {
-    mat4 modelMatrices[];
+    mat3x4 modelMatrices[];
 };
 
 layout (std430, binding = 14) readonly buffer SSBO4 {
-    mat4 prevModelMatrices[];
+    mat3x4 prevModelMatrices[];
 };
 
 uniform mat4 projectionView;
@@ -29,14 +30,14 @@ out vec4 fsCurrentClipPos;
 out vec4 fsPrevClipPos;
 
 void main() {
-    vec4 pos = modelMatrices[gl_DrawID] * vec4(getPosition(gl_VertexID), 1.0);
+    vec4 pos = decodeModelTransform(modelMatrices[gl_DrawID]) * vec4(getPosition(gl_VertexID), 1.0);
     vec4 clip = projectionView * pos;
     //clip.xy += jitter * clip.w;
     
     fsTexCoords = getTexCoord(gl_VertexID);
     fsDrawID = gl_DrawID;
 
-    fsPrevClipPos = prevProjectionView * prevModelMatrices[gl_DrawID] * vec4(getPosition(gl_VertexID), 1.0);
+    fsPrevClipPos = prevProjectionView * decodeModelTransform(prevModelMatrices[gl_DrawID]) * vec4(getPosition(gl_VertexID), 1.0);
     fsCurrentClipPos = clip;
 
     clip = jitterProjectionView * pos;
@@ -0,0 +1,12 @@
+STRATUS_GLSL_VERSION
+
+// Matches AffineTransform in StratusAffineTransform.h
+//
+// Model transforms are stored as the top 3 rows of the matrix since the bottom row is
+// always (0, 0, 0, 1). This makes them 48 bytes each instead of 64. Under std430 a mat3x4 is
+// 3 vec4 columns with no padding, so column i of the mat3x4 holds row i of the transform.
+
+mat4 decodeModelTransform(in mat3x4 transform) {
+    // transpose() gives a mat4x3 and the mat4 constructor fills in the missing row from the identity
+    return mat4(transpose(transform));
+}
@@ -3,14 +3,15 @@ STRATUS_GLSL_VERSION
 #extension GL_ARB_bindless_texture : require
 
 #include "mesh_data.glsl"
+#include "model_transform.glsl"
 #include "common.glsl"
 
 layout (std430, binding = 13) readonly buffer SSBO3 {
-    mat4 modelMatrices[];
+    mat3x4 modelMatrices[];
 };
 
 layout (std430, binding = 14) readonly buffer SSBO4 {
-    mat4 prevModelMatrices[];
+    mat3x4 prevModelMatrices[];
 };
 
 uniform mat4 projectionView;
@@ -59,7 +60,8 @@ void main() {
     fsEmissiveMapped = int(bitwiseAndBool(flags, GPU_EMISSIVE_MAPPED));
 
     //mat4 model = modelMats[gl_InstanceID];
-    vec4 pos = modelMatrices[gl_DrawID] * vec4(getPosition(gl_VertexID), 1.0);
+    mat4 model = decodeModelTransform(modelMatrices[gl_DrawID]);
+    vec4 pos = model * vec4(getPosition(gl_VertexID), 1.0);
     //vec4 pos = vec4(getPosition(gl_VertexID), 1.0);
 
     //vec4 viewSpacePos = view * pos;
@@ -67,13 +69,13 @@ void main() {
     //fsViewSpacePos = viewSpacePos.xyz;
     fsTexCoords = getTexCoord(gl_VertexID);
 
-    fsModelNoTranslate = mat3(modelMatrices[gl_DrawID]);
+    fsModelNoTranslate = mat3(model);
     fsNormal = normalize(fsModelNoTranslate * getNormal(gl_VertexID));
 
     // @see https://learnopengl.com/Advanced-Lighting/Normal-Mapping
     // Also see the tangent space and bump mapping section in "Foundations of Game Engine Development: Rendering"
     // tbn matrix transforms from normal map space to world space
-    mat3 normalMatrix = mat3(modelMatrices[gl_DrawID]);
+    mat3 normalMatrix = mat3(model);
     vec3 n = getNormal(gl_VertexID); //normalize(normalMatrix * getNormal(gl_VertexID));
     vec3 t = getTangent(gl_VertexID); //normalize(normalMatrix * getTangent(gl_VertexID));
 
@@ -87,11 +89,11 @@ void main() {
     b = normalize(b - dot(b, n) * n - dot(b, t) * t);
     fsTbnMatrix = fsModelNoTranslate * mat3(t, b, n);
 
-    fsModel = modelMatrices[gl_DrawID];
+    fsModel = model;
 
     fsDrawID = gl_DrawID;
     
-    fsPrevClipPos = prevProjectionView * prevModelMatrices[gl_DrawID] * vec4(getPosition(gl_VertexID), 1.0);
+    fsPrevClipPos = prevProjectionView * decodeModelTransform(prevModelMatrices[gl_DrawID]) * vec4(getPosition(gl_VertexID), 1.0);
     vec4 clip = projectionView * pos;
     fsCurrentClipPos = clip;
 
@@ -6,13 +6,14 @@ STRATUS_GLSL_VERSION
 #extension GL_ARB_shader_viewport_layer_array : require
 
 #include "mesh_data.glsl"
+#include "model_transform.glsl"
 
 uniform mat4 shadowMatrix;
 
 uniform int layer;
 
 layout (std430, binding = 13) readonly buffer SSBO3 {
-    mat4 modelMatrices[];
+    mat3x4 modelMatrices[];
 };
 
 smooth out vec4 fsPosition;
@@ -27,7 +28,7 @@ void main() {
 
     fsDrawID = gl_DrawID;
     fsTexCoords = getTexCoord(gl_VertexID);
-    fsPosition = modelMatrices[gl_DrawID] * vec4(getPosition(gl_VertexID), 1.0);
+    fsPosition = decodeModelTransform(modelMatrices[gl_DrawID]) * vec4(getPosition(gl_VertexID), 1.0);
 
     gl_Position = shadowMatrix * fsPosition;
 }
\ No newline at end of file
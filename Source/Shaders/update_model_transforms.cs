@@ -10,28 +10,31 @@ STRATUS_GLSL_VERSION
 layout (local_size_x = 96, local_size_y = 1, local_size_z = 1) in;
 
 // Each one specifies a different culling mode which has its own commands + model matrices
+//
+// Model matrices use the compact 3x4 layout from model_transform.glsl. They are only copied here so
+// there is no need to decode them.
 layout (std430, binding = 0) buffer ssbo1 {
-    mat4 cull0PrevFrameModelMatrices[];
+    mat3x4 cull0PrevFrameModelMatrices[];
 };
 
 layout (std430, binding = 1) readonly buffer ssbo2 {
-    mat4 cull0ModelMatrices[];
+    mat3x4 cull0ModelMatrices[];
 };
 
 layout (std430, binding = 2) buffer ssbo3 {
-    mat4 cull1PrevFrameModelMatrices[];
+    mat3x4 cull1PrevFrameModelMatrices[];
 };
 
 layout (std430, binding = 3) readonly buffer ssbo4 {
-    mat4 cull1ModelMatrices[];
+    mat3x4 cull1ModelMatrices[];
 };
 
 layout (std430, binding = 4) buffer ssbo5 {
-    mat4 cull2PrevFrameModelMatrices[];
+    mat3x4 cull2PrevFrameModelMatrices[];
 };
 
 layout (std430, binding = 5) readonly buffer ssbo6 {
-    mat4 cull2ModelMatrices[];
+    mat3x4 cull2ModelMatrices[];
 };
 
 uniform int cull0NumMatrices;
@@ -6,12 +6,13 @@ layout (local_size_x = 1024, local_size_y = 1, local_size_z = 1) in;
 
 #include "common.glsl"
 #include "aabb.glsl"
+#include "model_transform.glsl"
 
 uniform uint numDrawCalls;
 uniform mat4 cascadeViewProj[4];
 
 layout (std430, binding = 2) readonly buffer inputBlock3 {
-    mat4 modelTransforms[];
+    mat3x4 modelTransforms[];
 };
 
 layout (std430, binding = 3) readonly buffer inputBlock4 {
@@ -82,7 +83,7 @@ void main() {
     out[index] = draw;
    
     for (uint i = gl_LocalInvocationIndex; i < numDrawCalls; i += localWorkGroupSize) {
-        AABB aabb = transformAabb(aabbs[i], modelTransforms[i]);
+        AABB aabb = transformAabb(aabbs[i], decodeModelTransform(modelTransforms[i]));
 
         // Cascades 0, 1
         DrawElementsIndirectCommand draw = cascade01DrawCalls[i];
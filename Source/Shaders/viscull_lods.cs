@@ -6,12 +6,13 @@ layout (local_size_x = 1024, local_size_y = 1, local_size_z = 1) in;
 
 #include "common.glsl"
 #include "aabb.glsl"
+#include "model_transform.glsl"
 
 uniform vec4 frustumPlanes[6];
 uniform float zfar;
 
 layout (std430, binding = 2) readonly buffer inputBlock2 {
-    mat4 modelTransforms[];
+    mat3x4 modelTransforms[];
 };
 
 layout (std430, binding = 3) readonly buffer inputBlock4 {
@@ -75,7 +76,7 @@ void main() {
     uint localWorkGroupSize = gl_WorkGroupSize.x * gl_WorkGroupSize.y;
    
     for (uint i = gl_LocalInvocationIndex; i < numDrawCalls; i += localWorkGroupSize) {
-        AABB aabb = transformAabb(aabbs[i], modelTransforms[i]);
+        AABB aabb = transformAabb(aabbs[i], decodeModelTransform(modelTransforms[i]));
         // World space center
         //vec3 center = (aabb.vmin.xyz + aabb.vmax.xyz) * 0.5;
         // Defines a ray originating from the camera moving towards the center of the AABB
@@ -6,13 +6,14 @@ layout (local_size_x = 1024, local_size_y = 1, local_size_z = 1) in;
 
 #include "common.glsl"
 #include "aabb.glsl"
+#include "model_transform.glsl"
 
 uniform uint numDrawCalls;
 
 uniform mat4 viewProj[6];
 
 layout (std430, binding = 2) readonly buffer inputBlock4 {
-    mat4 modelTransforms[];
+    mat3x4 modelTransforms[];
 };
 
 layout (std430, binding = 3) readonly buffer inputBlock7 {
@@ -91,7 +92,7 @@ void main() {
    
     // First face
     for (uint i = gl_LocalInvocationIndex; i < numDrawCalls; i += localWorkGroupSize) {
-        AABB aabb = transformAabb(aabbs[i], modelTransforms[i]);
+        AABB aabb = transformAabb(aabbs[i], decodeModelTransform(modelTransforms[i]));
         DrawElementsIndirectCommand draw = inDrawCalls[i];
 
         PERFORM_VISCULL_FOR_DIRECTION(i, frustumPlanes0, aabb, draw, outDrawCalls0);
@@ -77,7 +77,7 @@ TEST_CASE("Stratus Entity Test", "[stratus_entity_test]") {
             STRATUS_LOG << "Process " << deltaSeconds << std::endl;
         }
 
-        void EntitiesAdded(const std::unordered_set<stratus::EntityPtr>& e) override {
+        void EntitiesAdded(const stratus::EntityList& e) override {
             numEntitiesAdded += e.size();
             for (stratus::EntityPtr ptr : e) {
                 ptrs.push_back(ptr);
@@ -100,20 +100,20 @@ TEST_CASE("Stratus Entity Test", "[stratus_entity_test]") {
             }
         }
 
-        void EntitiesRemoved(const std::unordered_set<stratus::EntityPtr>& e) override {
+        void EntitiesRemoved(const stratus::EntityList& e) override {
             numEntitiesRemoved += e.size();
         }
 
-        void EntityComponentsAdded(const std::unordered_map<stratus::EntityPtr, std::vector<stratus::EntityComponent*>>& added) override {
-            for (auto entry : added) {
+        void EntityComponentsAdded(const stratus::EntityComponentsAddedList& added) override {
+            for (auto& entry : added) {
                 // Don't process if we've handled it before
-                if (seen.find(entry.first) != seen.end()) continue;
-                seen.insert(entry.first);
-                auto components = entry.second;
+                if (seen.find(entry.entity) != seen.end()) continue;
+                seen.insert(entry.entity);
+                auto components = entry.components;
                 // If it doesn't have our component then don't process
-                if (!entry.first->Components().ContainsComponent<ExampleComponent>()) continue;
+                if (!entry.entity->Components().ContainsComponent<ExampleComponent>()) continue;
                 // If the ptr we set is invalid then don't process
-                if (entry.first->Components().GetComponent<ExampleComponent>().component->ptr != (const void *)this) continue;
+                if (entry.entity->Components().GetComponent<ExampleComponent>().component->ptr != (const void *)this) continue;
                 // Make sure the component we added actually shows up in the array
                 for (stratus::EntityComponent * c : components) {
                     if (c->TypeName() == ExampleComponent::STypeName()) {
@@ -123,7 +123,7 @@ TEST_CASE("Stratus Entity Test", "[stratus_entity_test]") {
             }
         }
 
-        void EntityComponentsEnabledDisabled(const std::unordered_set<stratus::EntityPtr>& changed) override {
+        void EntityComponentsEnabledDisabled(const stratus::EntityList& changed) override {
             componentsEnabledDisabledCalled = true;
             for (auto ptr : changed) {
                 if (ptr != disabledComponent || 
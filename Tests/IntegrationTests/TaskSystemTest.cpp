@@ -0,0 +1,361 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <stdexcept>
+
+#include "StratusEngine.h"
+#include "StratusApplication.h"
+#include "StratusApplicationThread.h"
+#include "StratusLog.h"
+#include "StratusCommon.h"
+#include "StratusTaskSystem.h"
+#include "IntegrationMain.h"
+
+TEST_CASE( "Stratus Task System Test", "[stratus_task_system_test]" ) {
+    static constexpr size_t numTasks = 10000;
+    static constexpr size_t numNestedTasks = 64;
+    static std::atomic<size_t> counter;
+    static std::atomic<size_t> nestedCounter;
+    static bool callbackCalled;
+    static bool groupCallbackCalled;
+    static bool failed;
+
+    counter.store(0);
+    nestedCounter.store(0);
+    callbackCalled = false;
+    groupCallbackCalled = false;
+    failed = false;
+
+    class TaskSystemTest : public stratus::Application {
+    public:
+        virtual ~TaskSystemTest() = default;
+
+        const char * GetAppName() const override {
+            return "TaskSystemTest";
+        }
+
+        bool Initialize() override {
+            for (size_t i = 0; i < numTasks; ++i) {
+                tasks.push_back(INSTANCE(TaskSystem)->ScheduleTask([]() {
+                    counter.fetch_add(1);
+                }));
+            }
+
+            // Tasks which schedule more tasks from inside a task thread
+            for (size_t i = 0; i < numNestedTasks; ++i) {
+                tasks.push_back(INSTANCE(TaskSystem)->ScheduleTask([]() {
+                    for (size_t j = 0; j < numNestedTasks; ++j) {
+                        INSTANCE(TaskSystem)->ScheduleTask([]() {
+                            nestedCounter.fetch_add(1);
+                        });
+                    }
+                }));
+            }
+
+            // Callbacks should come back to the thread which registered them
+            result = INSTANCE(TaskSystem)->ScheduleTask<size_t>([]() {
+                return new size_t(42);
+            });
+            result.AddCallback([](stratus::Async<size_t> as) {
+                if (!stratus::ApplicationThread::Instance()->CurrentIsApplicationThread()) failed = true;
+                if (!as.CompleteAndValid() || as.Get() != 42) failed = true;
+                callbackCalled = true;
+            });
+
+            // Group callbacks should also come back to the registering thread
+            INSTANCE(TaskSystem)->AddTaskGroupCallback<void>([](const std::vector<stratus::Async<void>>& group) {
+                if (!stratus::ApplicationThread::Instance()->CurrentIsApplicationThread()) failed = true;
+                for (const auto& as : group) {
+                    if (!as.Completed()) failed = true;
+                }
+                groupCallbackCalled = true;
+            }, tasks);
+
+            return true; // success
+        }
+
+        stratus::SystemStatus Update(const double deltaSeconds) override {
+            bool allComplete = true;
+            for (const auto& task : tasks) {
+                if (!task.Completed()) {
+                    allComplete = false;
+                    break;
+                }
+            }
+
+            if (allComplete && 
+                callbackCalled && 
+                groupCallbackCalled && 
+                counter.load() == numTasks && 
+                nestedCounter.load() == numNestedTasks * numNestedTasks) {
+
+                return stratus::SystemStatus::SYSTEM_SHUTDOWN;
+            }
+
+            // Tasks do not wait on frame boundaries so this should be more than enough
+            if (INSTANCE(Engine)->FrameCount() > 10000) {
+                failed = true;
+                return stratus::SystemStatus::SYSTEM_SHUTDOWN;
+            }
+
+            return stratus::SystemStatus::SYSTEM_CONTINUE;
+        }
+
+        void Shutdown() override {
+        }
+
+        std::vector<stratus::Async<void>> tasks;
+        stratus::Async<size_t> result;
+    };
+
+    STRATUS_INLINE_ENTRY_POINT(TaskSystemTest, numArgs, argList);
+
+    REQUIRE_FALSE(failed);
+    REQUIRE(callbackCalled);
+    REQUIRE(groupCallbackCalled);
+    REQUIRE(counter.load() == numTasks);
+    REQUIRE(nestedCounter.load() == numNestedTasks * numNestedTasks);
+}
+
+TEST_CASE( "Stratus Task System Parallel For Test", "[stratus_task_system_parallel_for_test]" ) {
+    static constexpr size_t numElements = 100000;
+    static constexpr size_t numNested = 64;
+    static bool failed;
+    static bool finished;
+
+    failed = false;
+    finished = false;
+
+    class TaskSystemParallelForTest : public stratus::Application {
+    public:
+        virtual ~TaskSystemParallelForTest() = default;
+
+        const char * GetAppName() const override {
+            return "TaskSystemParallelForTest";
+        }
+
+        bool Initialize() override {
+            // Called from the application thread which is not one of the task threads
+            std::vector<size_t> values(numElements, 0);
+            INSTANCE(TaskSystem)->ParallelFor(0, numElements, 0, [&values](const size_t first, const size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    values[i] += i;
+                }
+            });
+
+            for (size_t i = 0; i < numElements; ++i) {
+                if (values[i] != i) {
+                    failed = true;
+                    break;
+                }
+            }
+
+            const size_t sum = INSTANCE(TaskSystem)->ParallelReduce(size_t(0), numElements, 1000, size_t(0),
+                [](const size_t first, const size_t last) {
+                    size_t partial = 0;
+                    for (size_t i = first; i < last; ++i) partial += i;
+                    return partial;
+                },
+                [](const size_t a, const size_t b) { return a + b; }
+            );
+            if (sum != numElements * (numElements - 1) / 2) failed = true;
+
+            // Exceptions should make it back to the caller
+            bool caught = false;
+            try {
+                INSTANCE(TaskSystem)->ParallelFor(0, numElements, 1, [](const size_t first, const size_t) {
+                    if (first == numElements / 2) throw std::runtime_error("ParallelFor exception");
+                });
+            }
+            catch (const std::runtime_error&) {
+                caught = true;
+            }
+            if (!caught) failed = true;
+
+            // Scratch memory used by each chunk is released once the chunk is done
+            const size_t remaining = stratus::TaskSystem::CurrentScratch()->Remaining();
+            std::atomic<bool> wrongCapacity(false);
+            INSTANCE(TaskSystem)->ParallelFor(0, numElements, 1000, [&wrongCapacity](const size_t first, const size_t last) {
+                auto scratch = stratus::TaskSystem::CurrentScratch();
+                if (scratch->Capacity() != INSTANCE(TaskSystem)->Config().scratchBytesPerThread) wrongCapacity.store(true);
+                auto indices = std::vector<size_t, stratus::StackBasedPoolAllocator<size_t>>(stratus::StackBasedPoolAllocator<size_t>(scratch));
+                for (size_t i = first; i < last; ++i) indices.push_back(i);
+            });
+            if (wrongCapacity.load() || stratus::TaskSystem::CurrentScratch()->Remaining() != remaining) failed = true;
+
+            // Nested parallel for loops from inside of a task
+            task = INSTANCE(TaskSystem)->ScheduleTask<size_t>([]() {
+                const size_t remaining = stratus::TaskSystem::CurrentScratch()->Remaining();
+                std::atomic<size_t> count(0);
+                INSTANCE(TaskSystem)->ParallelFor(0, numNested, 1, [&count](const size_t first, const size_t last) {
+                    for (size_t i = first; i < last; ++i) {
+                        INSTANCE(TaskSystem)->ParallelFor(0, numNested, 1, [&count](const size_t first, const size_t last) {
+                            count.fetch_add(last - first);
+                        });
+                    }
+                });
+                if (stratus::TaskSystem::CurrentScratch()->Remaining() != remaining) return new size_t(0);
+                return new size_t(count.load());
+            });
+
+            task.AddCallback([](stratus::Async<size_t> as) {
+                if (!as.CompleteAndValid() || as.Get() != numNested * numNested) failed = true;
+                finished = true;
+            });
+
+            return true; // success
+        }
+
+        stratus::SystemStatus Update(const double deltaSeconds) override {
+            if (finished) {
+                return stratus::SystemStatus::SYSTEM_SHUTDOWN;
+            }
+
+            if (INSTANCE(Engine)->FrameCount() > 10000) {
+                failed = true;
+                return stratus::SystemStatus::SYSTEM_SHUTDOWN;
+            }
+
+            return stratus::SystemStatus::SYSTEM_CONTINUE;
+        }
+
+        void Shutdown() override {
+        }
+
+        stratus::Async<size_t> task;
+    };
+
+    STRATUS_INLINE_ENTRY_POINT(TaskSystemParallelForTest, numArgs, argList);
+
+    REQUIRE_FALSE(failed);
+    REQUIRE(finished);
+}
+
+TEST_CASE( "Stratus Task System Priority Test", "[stratus_task_system_priority_test]" ) {
+    static constexpr size_t numTasks = 256;
+    static std::atomic<size_t> criticalStarted;
+    static std::atomic<size_t> backgroundStarted;
+    static std::atomic<bool> cancelledTaskRan;
+    static std::atomic<bool> priorityInverted;
+    static bool failed;
+
+    criticalStarted.store(0);
+    backgroundStarted.store(0);
+    cancelledTaskRan.store(false);
+    priorityInverted.store(false);
+    failed = false;
+
+    class TaskSystemPriorityTest : public stratus::Application {
+    public:
+        virtual ~TaskSystemPriorityTest() = default;
+
+        const char * GetAppName() const override {
+            return "TaskSystemPriorityTest";
+        }
+
+        bool Initialize() override {
+            using namespace stratus;
+            TaskSystem * tasks = INSTANCE(TaskSystem);
+
+            // Keep every task thread busy so that everything below is queued up before any of it runs
+            std::atomic<size_t> blocked(0);
+            std::atomic<bool> release(false);
+            std::vector<Async<void>> blockers;
+            for (size_t i = 0; i < tasks->Size(); ++i) {
+                blockers.push_back(tasks->ScheduleTask([&blocked, &release]() {
+                    blocked.fetch_add(1);
+                    while (!release.load()) std::this_thread::yield();
+                }));
+            }
+            while (blocked.load() < tasks->Size()) std::this_thread::yield();
+
+            // Background work is queued first but should only start once all critical work has been picked up
+            const size_t numWorkers = tasks->Size();
+            for (size_t i = 0; i < numTasks; ++i) {
+                group.push_back(tasks->ScheduleTask([numWorkers]() {
+                    // Other workers may have picked up a critical task without having started it yet
+                    if (criticalStarted.load() + numWorkers - 1 < numTasks) priorityInverted.store(true);
+                    backgroundStarted.fetch_add(1);
+                }, TaskPriority::BACKGROUND));
+            }
+
+            for (size_t i = 0; i < numTasks; ++i) {
+                group.push_back(tasks->ScheduleTask([]() {
+                    criticalStarted.fetch_add(1);
+                }, TaskPriority::CRITICAL));
+            }
+
+            // Cancelled before it had a chance to start
+            CancellationToken token = CancellationToken::Create();
+            cancelled = tasks->ScheduleTask<size_t>([]() {
+                cancelledTaskRan.store(true);
+                return new size_t(0);
+            }, TaskPriority::NORMAL, token);
+            token.Cancel();
+
+            release.store(true);
+            for (auto& blocker : blockers) {
+                while (!blocker.Completed()) std::this_thread::yield();
+            }
+
+            // Cancelled while running
+            CancellationToken cooperative = CancellationToken::Create();
+            started = std::make_shared<std::atomic<bool>>(false);
+            auto startedPtr = started;
+            group.push_back(tasks->ScheduleTask([cooperative, startedPtr]() {
+                startedPtr->store(true);
+                while (true) {
+                    cooperative.ThrowIfCancelled();
+                    std::this_thread::yield();
+                }
+            }, TaskPriority::NORMAL, cooperative));
+            cooperativeToken = cooperative;
+
+            return true; // success
+        }
+
+        stratus::SystemStatus Update(const double deltaSeconds) override {
+            if (started->load()) cooperativeToken.Cancel();
+
+            bool allComplete = cancelled.Completed();
+            for (const auto& task : group) {
+                if (!task.Completed()) {
+                    allComplete = false;
+                    break;
+                }
+            }
+
+            if (allComplete) {
+                if (!cancelled.Failed() || cancelled.ExceptionMessage() != "Task cancelled") failed = true;
+                if (!group.back().Failed() || group.back().ExceptionMessage() != "Task cancelled") failed = true;
+                return stratus::SystemStatus::SYSTEM_SHUTDOWN;
+            }
+
+            if (INSTANCE(Engine)->FrameCount() > 10000) {
+                failed = true;
+                return stratus::SystemStatus::SYSTEM_SHUTDOWN;
+            }
+
+            return stratus::SystemStatus::SYSTEM_CONTINUE;
+        }
+
+        void Shutdown() override {
+        }
+
+        std::vector<stratus::Async<void>> group;
+        stratus::Async<size_t> cancelled;
+        std::shared_ptr<std::atomic<bool>> started;
+        stratus::CancellationToken cooperativeToken;
+    };
+
+    STRATUS_INLINE_ENTRY_POINT(TaskSystemPriorityTest, numArgs, argList);
+
+    REQUIRE_FALSE(failed);
+    REQUIRE_FALSE(priorityInverted.load());
+    REQUIRE_FALSE(cancelledTaskRan.load());
+    REQUIRE(criticalStarted.load() == numTasks);
+    REQUIRE(backgroundStarted.load() == numTasks);
+}
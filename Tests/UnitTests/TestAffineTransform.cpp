@@ -0,0 +1,86 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "StratusAffineTransform.h"
+#include "StratusMath.h"
+
+static bool ApproxEqual_(const glm::mat4& a, const glm::mat4& b) {
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            const float tolerance = 1e-5f * std::max(1.0f, std::fabs(b[c][r]));
+            if (std::fabs(a[c][r] - b[c][r]) > tolerance) return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE( "Stratus Affine Transform Test", "[stratus_affine_transform_test]" ) {
+    std::cout << "Beginning stratus::AffineTransform test (" << stratus::AffineTransformKernelName() << ")" << std::endl;
+
+    using namespace stratus;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> scaleDist(0.1f, 4.0f);
+
+    // Odd count so that the wide kernels have a tail to handle
+    const size_t count = 37;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat3> rotations;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::mat4> expected;
+    for (size_t i = 0; i < count; ++i) {
+        scales.push_back(glm::vec3(scaleDist(rng), scaleDist(rng), scaleDist(rng)));
+        const glm::vec3 axis = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)) + glm::vec3(0.01f));
+        rotations.push_back(glm::mat3(glm::rotate(glm::mat4(1.0f), dist(rng), axis)));
+        positions.push_back(glm::vec3(dist(rng), dist(rng), dist(rng)));
+
+        auto S = glm::mat4(1.0f);
+        matScale(S, scales[i]);
+        auto R = glm::mat4(1.0f);
+        matInset(R, rotations[i]);
+        auto T = glm::mat4(1.0f);
+        matTranslate(T, positions[i]);
+        expected.push_back(T * R * S);
+    }
+
+    // Round trip through mat4
+    REQUIRE(AffineTransform(expected[0]).ToMat4() == expected[0]);
+    REQUIRE(AffineTransform().ToMat4() == glm::mat4(1.0f));
+    REQUIRE(AffineTransform(expected[0]).GetTranslate() == positions[0]);
+
+    std::vector<AffineTransform> composed(count);
+    ComposeAffineTransforms(count, scales.data(), rotations.data(), positions.data(), composed.data());
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(ApproxEqual_(composed[i].ToMat4(), expected[i]));
+    }
+
+    // Every count up to a few full batches
+    for (size_t n = 0; n <= 8; ++n) {
+        std::vector<AffineTransform> parents(composed.begin(), composed.begin() + n);
+        std::vector<AffineTransform> locals(composed.rbegin(), composed.rbegin() + n);
+        std::vector<AffineTransform> out(n);
+        MultiplyAffineTransforms(n, parents.data(), locals.data(), out.data());
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(ApproxEqual_(out[i].ToMat4(), parents[i].ToMat4() * locals[i].ToMat4()));
+        }
+    }
+
+    // Output aliasing an input
+    std::vector<AffineTransform> parents(composed.begin(), composed.end());
+    std::vector<AffineTransform> locals(composed.rbegin(), composed.rend());
+    std::vector<AffineTransform> inPlace = locals;
+    MultiplyAffineTransforms(count, parents.data(), inPlace.data(), inPlace.data());
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(ApproxEqual_(inPlace[i].ToMat4(), parents[i].ToMat4() * locals[i].ToMat4()));
+    }
+
+    inPlace = parents;
+    MultiplyAffineTransforms(count, inPlace.data(), locals.data(), inPlace.data());
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(ApproxEqual_(inPlace[i].ToMat4(), parents[i].ToMat4() * locals[i].ToMat4()));
+    }
+}
@@ -0,0 +1,201 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+#include "StratusBvh.h"
+
+static stratus::GpuAABB MakeAabb_(const glm::vec3& center, const glm::vec3& halfSize) {
+    stratus::GpuAABB aabb;
+    aabb.vmin = glm::vec4(center - halfSize, 1.0f);
+    aabb.vmax = glm::vec4(center + halfSize, 1.0f);
+    return aabb;
+}
+
+static glm::vec3 Min_(const stratus::GpuAABB& aabb) { return glm::vec3(aabb.vmin.ToVec4()); }
+static glm::vec3 Max_(const stratus::GpuAABB& aabb) { return glm::vec3(aabb.vmax.ToVec4()); }
+
+static std::vector<stratus::BvhProxy> Sorted_(std::vector<stratus::BvhProxy> v) {
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+// Runs every query type against the tree and against a brute force loop over boxes
+static void ValidateQueries_(const stratus::Bvh& bvh, const std::unordered_map<stratus::BvhProxy, stratus::GpuAABB>& boxes, std::mt19937& rng) {
+    using namespace stratus;
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(1.0f, 30.0f);
+
+    REQUIRE(bvh.Size() == boxes.size());
+
+    for (int query = 0; query < 20; ++query) {
+        const glm::vec3 center(position(rng), position(rng), position(rng));
+        const float radius = size(rng);
+
+        std::vector<BvhProxy> expectedAabb, expectedSphere, expectedRay;
+        const GpuAABB queryBox = MakeAabb_(center, glm::vec3(radius));
+        const glm::vec3 rayDir = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)));
+        const float rayLength = 2.0f * radius;
+
+        for (const auto& [proxy, box] : boxes) {
+            const glm::vec3 vmin = Min_(box);
+            const glm::vec3 vmax = Max_(box);
+
+            if (glm::all(glm::lessThanEqual(vmin, Max_(queryBox))) && glm::all(glm::lessThanEqual(Min_(queryBox), vmax))) {
+                expectedAabb.push_back(proxy);
+            }
+
+            const glm::vec3 closest = glm::clamp(center, vmin, vmax);
+            if (glm::distance(closest, center) <= radius) expectedSphere.push_back(proxy);
+
+            // Clip the segment against each slab in turn
+            double tmin = 0.0, tmax = double(rayLength);
+            for (int axis = 0; axis < 3 && tmin <= tmax; ++axis) {
+                if (rayDir[axis] == 0.0f) {
+                    if (center[axis] < vmin[axis] || center[axis] > vmax[axis]) tmax = -1.0;
+                    continue;
+                }
+                double t1 = (double(vmin[axis]) - center[axis]) / rayDir[axis];
+                double t2 = (double(vmax[axis]) - center[axis]) / rayDir[axis];
+                if (t1 > t2) std::swap(t1, t2);
+                tmin = std::max(tmin, t1);
+                tmax = std::min(tmax, t2);
+            }
+            if (tmin <= tmax) expectedRay.push_back(proxy);
+        }
+
+        std::vector<BvhProxy> result;
+        bvh.QueryAabb(queryBox, result);
+        REQUIRE(Sorted_(result) == Sorted_(expectedAabb));
+
+        result.clear();
+        bvh.QuerySphere(center, radius, result);
+        REQUIRE(Sorted_(result) == Sorted_(expectedSphere));
+
+        result.clear();
+        bvh.QueryRay(center, rayDir, rayLength, result);
+        REQUIRE(Sorted_(result) == Sorted_(expectedRay));
+    }
+}
+
+TEST_CASE( "Stratus Bvh Test", "[stratus_bvh_test]" ) {
+    std::cout << "Beginning stratus::Bvh test" << std::endl;
+
+    using namespace stratus;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+
+    Bvh bvh(0.5f);
+    REQUIRE(bvh.Size() == 0);
+    REQUIRE(bvh.Height() == -1);
+    REQUIRE_FALSE(bvh.Remove(0));
+
+    std::unordered_map<BvhProxy, GpuAABB> boxes;
+    const size_t numBoxes = 2000;
+    for (size_t i = 0; i < numBoxes; ++i) {
+        const GpuAABB box = MakeAabb_(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(size(rng), size(rng), size(rng)));
+        const BvhProxy proxy = bvh.Insert(box, i);
+        REQUIRE(bvh.Contains(proxy));
+        REQUIRE(bvh.GetUserData(proxy) == i);
+        boxes.insert(std::make_pair(proxy, box));
+    }
+
+    // Rotations should keep the tree close to log2(n) deep
+    REQUIRE(bvh.Height() < 4 * int32_t(std::log2(double(numBoxes))));
+    ValidateQueries_(bvh, boxes, rng);
+
+    // Small moves stay inside the fattened bounds and don't touch the tree
+    {
+        const BvhProxy proxy = boxes.begin()->first;
+        GpuAABB moved = boxes.begin()->second;
+        moved.vmin = glm::vec4(Min_(moved) + glm::vec3(0.25f), 1.0f);
+        moved.vmax = glm::vec4(Max_(moved) + glm::vec3(0.25f), 1.0f);
+        REQUIRE_FALSE(bvh.Update(proxy, moved));
+        REQUIRE(Min_(bvh.GetAABB(proxy)) == Min_(moved));
+        boxes[proxy] = moved;
+    }
+
+    // Move everything a few times
+    for (int frame = 0; frame < 10; ++frame) {
+        for (auto& [proxy, box] : boxes) {
+            const glm::vec3 offset(step(rng), step(rng), step(rng));
+            box.vmin = glm::vec4(Min_(box) + offset, 1.0f);
+            box.vmax = glm::vec4(Max_(box) + offset, 1.0f);
+            bvh.Update(proxy, box);
+        }
+    }
+    REQUIRE(bvh.Height() < 4 * int32_t(std::log2(double(numBoxes))));
+    ValidateQueries_(bvh, boxes, rng);
+
+    // Remove half and make sure proxies are reused
+    std::vector<BvhProxy> removed;
+    for (auto it = boxes.begin(); it != boxes.end();) {
+        if (it->first % 2 == 0) {
+            REQUIRE(bvh.Remove(it->first));
+            REQUIRE_FALSE(bvh.Contains(it->first));
+            removed.push_back(it->first);
+            it = boxes.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    REQUIRE_FALSE(bvh.Remove(removed[0]));
+    REQUIRE_THROWS(bvh.Update(removed[0], GpuAABB()));
+    ValidateQueries_(bvh, boxes, rng);
+
+    const GpuAABB reinserted = MakeAabb_(glm::vec3(0.0f), glm::vec3(1.0f));
+    const BvhProxy reused = bvh.Insert(reinserted);
+    REQUIRE(std::find(removed.begin(), removed.end(), reused) != removed.end());
+    boxes.insert(std::make_pair(reused, reinserted));
+    ValidateQueries_(bvh, boxes, rng);
+
+    bvh.Clear();
+    REQUIRE(bvh.Size() == 0);
+    std::vector<BvhProxy> result;
+    bvh.QuerySphere(glm::vec3(0.0f), 1000.0f, result);
+    REQUIRE(result.size() == 0);
+}
+
+TEST_CASE( "Stratus Bvh Frustum Test", "[stratus_bvh_frustum_test]" ) {
+    std::cout << "Beginning stratus::Bvh frustum test" << std::endl;
+
+    using namespace stratus;
+
+    // Row of unit boxes along +x, one every 10 units
+    Bvh bvh;
+    std::vector<BvhProxy> proxies;
+    for (int i = 0; i < 20; ++i) {
+        proxies.push_back(bvh.Insert(MakeAabb_(glm::vec3(float(i) * 10.0f, 0.0f, 0.0f), glm::vec3(0.5f))));
+    }
+
+    // Box shaped "frustum" covering x in [15, 55], y and z in [-1, 1]
+    const glm::vec4 planes[6] = {
+        glm::vec4( 1.0f,  0.0f,  0.0f, -15.0f),
+        glm::vec4(-1.0f,  0.0f,  0.0f,  55.0f),
+        glm::vec4( 0.0f,  1.0f,  0.0f,   1.0f),
+        glm::vec4( 0.0f, -1.0f,  0.0f,   1.0f),
+        glm::vec4( 0.0f,  0.0f,  1.0f,   1.0f),
+        glm::vec4( 0.0f,  0.0f, -1.0f,   1.0f)
+    };
+
+    std::vector<BvhProxy> result;
+    bvh.QueryFrustum(planes, result);
+    REQUIRE(Sorted_(result) == std::vector<BvhProxy>{proxies[2], proxies[3], proxies[4], proxies[5]});
+
+    // Ray down the row stops at maxDistance
+    result.clear();
+    bvh.QueryRay(glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 30.0f, result);
+    REQUIRE(Sorted_(result) == std::vector<BvhProxy>{proxies[0], proxies[1], proxies[2]});
+
+    // Ray pointing away hits nothing
+    result.clear();
+    bvh.QueryRay(glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), 1000.0f, result);
+    REQUIRE(result.size() == 0);
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+
+#include "StratusCoroutine.h"
+
+// Built as C++20 by the StratusEngineCoroutineUnitTests target
+#ifdef STRATUS_COROUTINES_ENABLED
+
+static stratus::Task<int> AddOne(stratus::Async<int> input) {
+    stratus::Async<int> result = co_await input;
+    co_return new int(result.Get() + 1);
+}
+
+static stratus::Task<int> Pipeline(stratus::Thread& decodeThread, stratus::Thread& uploadThread, std::vector<stratus::Thread *>& visited) {
+    co_await stratus::ResumeOn(decodeThread);
+    visited.push_back(&stratus::Thread::Current());
+
+    // Awaiting another task
+    stratus::Async<int> decoded = co_await AddOne(stratus::Async<int>(std::make_shared<int>(1)));
+
+    co_await stratus::ResumeOn(uploadThread);
+    visited.push_back(&stratus::Thread::Current());
+
+    co_return std::make_shared<int>(decoded.Get() * 10);
+}
+
+static stratus::Task<void> Throws(stratus::Thread& thread) {
+    co_await stratus::ResumeOn(thread);
+    throw std::runtime_error("Coroutine failure");
+}
+
+TEST_CASE( "Stratus Coroutine Test", "[stratus_coroutine_test]" ) {
+    std::cout << "Beginning stratus::Task coroutine test" << std::endl;
+
+    stratus::Thread decodeThread("Decode", true);
+    stratus::Thread uploadThread("Upload", true);
+
+    // Resumes once the awaited Async completes
+    stratus::Async<int> input(decodeThread, []() { return new int(41); });
+    stratus::Task<int> addOne = AddOne(input);
+    REQUIRE_FALSE(addOne.Completed());
+    decodeThread.DispatchAndSynchronize();
+    REQUIRE(addOne.GetAsync().CompleteAndValid());
+    REQUIRE(addOne.GetAsync().Get() == 42);
+
+    // Hops between threads
+    std::vector<stratus::Thread *> visited;
+    stratus::Async<int> pipeline = Pipeline(decodeThread, uploadThread, visited);
+    REQUIRE_FALSE(pipeline.Completed());
+    decodeThread.DispatchAndSynchronize();
+    REQUIRE_FALSE(pipeline.Completed());
+    uploadThread.DispatchAndSynchronize();
+    REQUIRE(pipeline.CompleteAndValid());
+    REQUIRE(pipeline.Get() == 20);
+    REQUIRE(visited.size() == 2);
+    REQUIRE(visited[0] == &decodeThread);
+    REQUIRE(visited[1] == &uploadThread);
+
+    // Exceptions fail the task
+    stratus::Task<void> throws = Throws(decodeThread);
+    decodeThread.DispatchAndSynchronize();
+    REQUIRE(throws.GetAsync().CompleteAndInvalid());
+    REQUIRE(throws.GetAsync().ExceptionMessage() == "Coroutine failure");
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+
+#include "StratusCpuTopology.h"
+#include "StratusTaskSystem.h"
+
+TEST_CASE( "Stratus Cpu Topology Test", "[stratus_cpu_topology_test]" ) {
+    std::cout << "Beginning stratus::CpuTopology test" << std::endl;
+
+    using namespace stratus;
+
+    REQUIRE(CpuTopology::ParseCpuList("") == std::vector<uint32_t>{});
+    REQUIRE(CpuTopology::ParseCpuList("0\n") == std::vector<uint32_t>{0});
+    REQUIRE(CpuTopology::ParseCpuList("0-3,8,10-11") == std::vector<uint32_t>{0, 1, 2, 3, 8, 10, 11});
+    REQUIRE(CpuTopology::ParseCpuList("4-5, 2,5") == std::vector<uint32_t>{2, 4, 5});
+    REQUIRE(CpuTopology::ParseCpuList("x,1") == std::vector<uint32_t>{1});
+
+    // Whatever the platform reports there should be at least one usable core
+    const CpuTopology current = CpuTopology::Query();
+    REQUIRE(current.nodes.size() >= 1);
+    REQUIRE(current.NumCores() >= 1);
+}
+
+TEST_CASE( "Stratus Task System Layout Test", "[stratus_task_system_layout_test]" ) {
+    std::cout << "Beginning stratus::TaskSystemLayout test" << std::endl;
+
+    using namespace stratus;
+
+    CpuTopology single;
+    single.nodes = {{0, 1, 2, 3, 4, 5, 6, 7}};
+
+    CpuTopology dual;
+    dual.nodes = {{0, 1, 2, 3}, {4, 5, 6, 7}};
+
+    // Defaults leave one core for the application thread and don't restrict a single node
+    TaskSystemConfig config;
+    TaskSystemLayout layout = TaskSystemLayout::Plan(config, single);
+    REQUIRE(layout.reservedCores == std::vector<uint32_t>{0});
+    REQUIRE(layout.workers.size() == 7);
+    for (const auto& worker : layout.workers) {
+        REQUIRE(worker.numaNode == 0);
+        REQUIRE(worker.cores.size() == 0);
+    }
+
+    // Pinned workers each get their own core, none of which are reserved
+    config.pinWorkers = true;
+    config.numReservedCores = 2;
+    layout = TaskSystemLayout::Plan(config, single);
+    REQUIRE(layout.reservedCores == std::vector<uint32_t>{0, 1});
+    REQUIRE(layout.workers.size() == 6);
+    for (size_t i = 0; i < layout.workers.size(); ++i) {
+        REQUIRE(layout.workers[i].cores == std::vector<uint32_t>{uint32_t(i + 2)});
+    }
+
+    // More workers than cores can't be pinned one to one but still stay off the reserved cores
+    config.numWorkers = 12;
+    config.pinApplicationThread = true;
+    layout = TaskSystemLayout::Plan(config, single);
+    REQUIRE(layout.workers.size() == 12);
+    for (const auto& worker : layout.workers) {
+        REQUIRE(worker.cores == std::vector<uint32_t>{2, 3, 4, 5, 6, 7});
+    }
+
+    // NUMA aware workers are restricted to their node
+    config = TaskSystemConfig();
+    layout = TaskSystemLayout::Plan(config, dual);
+    REQUIRE(layout.numNumaNodes == 2);
+    REQUIRE(layout.reservedCores == std::vector<uint32_t>{0});
+    REQUIRE(layout.workers.size() == 7);
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(layout.workers[i].numaNode == 0);
+        REQUIRE(layout.workers[i].cores == std::vector<uint32_t>{1, 2, 3});
+    }
+    for (size_t i = 3; i < 7; ++i) {
+        REQUIRE(layout.workers[i].numaNode == 1);
+        REQUIRE(layout.workers[i].cores == std::vector<uint32_t>{4, 5, 6, 7});
+    }
+
+    config.numaAware = false;
+    layout = TaskSystemLayout::Plan(config, dual);
+    REQUIRE(layout.workers[0].cores.size() == 0);
+
+    // Always at least 2 workers and at least 1 core left over for them
+    config = TaskSystemConfig();
+    config.numReservedCores = 100;
+    CpuTopology tiny;
+    tiny.nodes = {{0}};
+    layout = TaskSystemLayout::Plan(config, tiny);
+    REQUIRE(layout.reservedCores.size() == 0);
+    REQUIRE(layout.workers.size() == 2);
+
+    layout = TaskSystemLayout::Plan(config, single);
+    REQUIRE(layout.reservedCores.size() == 7);
+    REQUIRE(layout.workers.size() == 2);
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <thread>
+
+#include "StratusEntityPrefab.h"
+#include "StratusTransformComponent.h"
+#include "StratusRenderComponents.h"
+
+ENTITY_COMPONENT_STRUCT(PrefabTestComponent)
+    int value = 0;
+
+    PrefabTestComponent() = default;
+    PrefabTestComponent(const PrefabTestComponent&) = default;
+};
+
+static void ValidateTree_(const stratus::EntityPtr& instance, const stratus::EntityPtr& source) {
+    using namespace stratus;
+    REQUIRE(instance != source);
+    REQUIRE(instance->Components().Signature() == source->Components().Signature());
+    REQUIRE(GetComponent<PrefabTestComponent>(instance)->value == GetComponent<PrefabTestComponent>(source)->value);
+    // Components are never shared between entities
+    REQUIRE(GetComponent<LocalTransformComponent>(instance) != GetComponent<LocalTransformComponent>(source));
+
+    REQUIRE(instance->GetChildNodes().size() == source->GetChildNodes().size());
+    for (size_t i = 0; i < instance->GetChildNodes().size(); ++i) {
+        REQUIRE(instance->GetChildNodes()[i]->GetParentNode() == instance);
+        ValidateTree_(instance->GetChildNodes()[i], source->GetChildNodes()[i]);
+    }
+}
+
+TEST_CASE( "Stratus Entity Prefab Test", "[stratus_entity_prefab_test]" ) {
+    std::cout << "Beginning stratus::EntityPrefab test" << std::endl;
+
+    using namespace stratus;
+
+    // root
+    //   a
+    //     c
+    //     d
+    //   b
+    std::vector<EntityPtr> nodes;
+    for (int i = 0; i < 5; ++i) {
+        auto e = CreateTransformEntity();
+        e->Components().AttachComponent<PrefabTestComponent>();
+        GetComponent<PrefabTestComponent>(e)->value = i;
+        nodes.push_back(e);
+    }
+    nodes[0]->AttachChildNode(nodes[1]);
+    nodes[0]->AttachChildNode(nodes[2]);
+    nodes[1]->AttachChildNode(nodes[3]);
+    nodes[1]->AttachChildNode(nodes[4]);
+
+    auto prefab = EntityPrefab::Create(nodes[0]);
+    REQUIRE(prefab->NumNodes() == nodes.size());
+
+    // The prefab is a snapshot
+    GetComponent<PrefabTestComponent>(nodes[3])->value = 100;
+    auto instance = prefab->Instantiate();
+    REQUIRE(GetComponent<PrefabTestComponent>(instance->GetChildNodes()[0]->GetChildNodes()[0])->value == 3);
+    GetComponent<PrefabTestComponent>(nodes[3])->value = 3;
+    ValidateTree_(instance, nodes[0]);
+    REQUIRE(instance->GetParentNode() == nullptr);
+
+    // Instances don't affect each other
+    auto other = prefab->Instantiate();
+    GetComponent<PrefabTestComponent>(instance)->value = 50;
+    GetComponent<LocalTransformComponent>(instance)->SetLocalPosition(glm::vec3(1.0f));
+    REQUIRE(GetComponent<PrefabTestComponent>(other)->value == 0);
+    REQUIRE(GetComponent<LocalTransformComponent>(other)->GetLocalPosition() == glm::vec3(0.0f));
+    REQUIRE(GetComponent<PrefabTestComponent>(prefab->Instantiate())->value == 0);
+
+    std::vector<EntityPtr> many;
+    many.push_back(other);
+    prefab->Instantiate(100, many);
+    REQUIRE(many.size() == 101);
+    for (const auto& e : many) ValidateTree_(e, nodes[0]);
+
+    // Instantiating from several threads at once
+    std::vector<std::vector<EntityPtr>> perThread(4);
+    std::vector<std::thread> threads;
+    for (auto& out : perThread) {
+        threads.push_back(std::thread([&prefab, &out]() {
+            prefab->Instantiate(100, out);
+        }));
+    }
+    for (auto& thread : threads) thread.join();
+    for (const auto& out : perThread) {
+        REQUIRE(out.size() == 100);
+        for (const auto& e : out) ValidateTree_(e, nodes[0]);
+    }
+
+    // Single entity prefab
+    auto single = EntityPrefab::Create(nodes[2]);
+    REQUIRE(single->NumNodes() == 1);
+    auto singleInstance = single->Instantiate();
+    REQUIRE(GetComponent<PrefabTestComponent>(singleInstance)->value == 2);
+    REQUIRE(singleInstance->GetChildNodes().size() == 0);
+
+    REQUIRE_THROWS(EntityPrefab::Create(nullptr));
+}
+
+TEST_CASE( "Stratus Render Component Copy On Write Test", "[stratus_render_component_cow_test]" ) {
+    std::cout << "Beginning stratus::RenderComponent copy on write test" << std::endl;
+
+    using namespace stratus;
+
+    auto source = Entity::Create();
+    source->Components().AttachComponent<RenderComponent>();
+    auto rc = GetComponent<RenderComponent>(source);
+    rc->AddMaterial(nullptr);
+    rc->AddMaterial(nullptr);
+
+    auto prefab = EntityPrefab::Create(source);
+    auto a = prefab->Instantiate();
+    auto b = prefab->Instantiate();
+    auto rcA = GetComponent<RenderComponent>(a);
+    auto rcB = GetComponent<RenderComponent>(b);
+
+    // Instances share meshes and materials with the template
+    REQUIRE(rcA->meshes == rc->meshes);
+    REQUIRE(rcB->meshes == rc->meshes);
+    REQUIRE(&rcA->GetAllMaterials() == &rcB->GetAllMaterials());
+    REQUIRE(rcA->GetMaterialCount() == 2);
+
+    // Until one of them changes its materials
+    // Non-owning (aliasing constructor) since it is only compared, never dereferenced
+    static int markerStorage;
+    const MaterialPtr marker(MaterialPtr(), reinterpret_cast<Material *>(&markerStorage));
+    rcA->SetMaterialAt(marker, 1);
+    REQUIRE(&rcA->GetAllMaterials() != &rcB->GetAllMaterials());
+    REQUIRE(rcA->GetMaterialAt(1) == marker);
+    REQUIRE(rcB->GetMaterialAt(1) == nullptr);
+    REQUIRE(rc->GetMaterialAt(1) == nullptr);
+    REQUIRE(rcA->meshes == rcB->meshes);
+
+    rcB->AddMaterial(marker);
+    REQUIRE(rcB->GetMaterialCount() == 3);
+    REQUIRE(rcA->GetMaterialCount() == 2);
+    REQUIRE(prefab->Instantiate()->Components().GetComponent<RenderComponent>().component->GetMaterialCount() == 2);
+
+    // The source's own list is shared with copies too
+    auto copy = source->Copy();
+    REQUIRE(&GetComponent<RenderComponent>(copy)->GetAllMaterials() == &rc->GetAllMaterials());
+}
@@ -0,0 +1,274 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+#include "StratusEngineModuleInit.h"
+#include "StratusTaskSystem.h"
+#include "StratusEntityManager.h"
+#include "StratusTransformComponent.h"
+
+// Stands up a Log and TaskSystem for as long as it is in scope
+struct TaskSystemScope_ {
+    TaskSystemScope_() {
+        stratus::TaskSystemConfig config;
+        config.numWorkers = 4;
+        stratus::EngineModuleInit::CreateEngineModule<stratus::Log>(false);
+        stratus::EngineModuleInit::CreateEngineModule<stratus::TaskSystem>(false, config);
+    }
+
+    ~TaskSystemScope_() {
+        stratus::EngineModuleInit::DestroyEngineModule<stratus::TaskSystem>();
+        stratus::EngineModuleInit::DestroyEngineModule<stratus::Log>();
+    }
+};
+
+// Runs the test on a stratus::Thread context with a TaskSystem so that ANY_THREAD jobs and
+// ParallelFor actually run on the task threads
+template<typename F>
+static void RunWithTaskSystem_(const F& test) {
+    stratus::Thread context("EntityProcessTest", false);
+    context.RunInContext([&test]() {
+        TaskSystemScope_ scope;
+        test();
+    });
+}
+
+// Records when each process starts and finishes
+struct ProcessEventLog_ {
+    void Record(const size_t process, const bool start) {
+        std::unique_lock<std::mutex> ul(m);
+        events.push_back(std::make_pair(process, start));
+    }
+
+    // Index of the process' start or end event
+    size_t Find(const size_t process, const bool start) const {
+        for (size_t i = 0; i < events.size(); ++i) {
+            if (events[i] == std::make_pair(process, start)) return i;
+        }
+        return events.size();
+    }
+
+    bool FinishedBefore(const size_t first, const size_t second) const {
+        return Find(first, false) < Find(second, true);
+    }
+
+    std::mutex m;
+    std::vector<std::pair<size_t, bool>> events;
+    std::vector<std::thread::id> threads;
+};
+
+struct RecordingProcess_ : public stratus::EntityProcess {
+    RecordingProcess_(const size_t index, ProcessEventLog_& log, const stratus::EntityProcessAccess& access)
+        : index(index), log(log), access(access) {}
+
+    stratus::EntityProcessAccess ComponentAccess() const override {
+        return access;
+    }
+
+    void Process(const double deltaSeconds) override {
+        log.Record(index, true);
+        // Long enough that anything allowed to overlap has a chance to
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        {
+            std::unique_lock<std::mutex> ul(log.m);
+            log.threads[index] = std::this_thread::get_id();
+        }
+        log.Record(index, false);
+    }
+
+    void EntitiesAdded(const stratus::EntityList&) override {}
+    void EntitiesRemoved(const stratus::EntityList&) override {}
+    void EntityComponentsAdded(const stratus::EntityComponentsAddedList&) override {}
+    void EntityComponentsEnabledDisabled(const stratus::EntityList&) override {}
+
+    const size_t index;
+    ProcessEventLog_& log;
+    const stratus::EntityProcessAccess access;
+};
+
+TEST_CASE( "Stratus Entity Process Graph Test", "[stratus_entity_process_graph_test]" ) {
+    std::cout << "Beginning stratus::EntityProcess graph test" << std::endl;
+
+    using namespace stratus;
+
+    RunWithTaskSystem_([&]() {
+        const auto local = MakeEntityComponentSignature<LocalTransformComponent>();
+        const auto global = MakeEntityComponentSignature<GlobalTransformComponent>();
+        const auto mesh = MakeEntityComponentSignature<MeshWorldTransforms>();
+        const auto none = EntityComponentSignature();
+
+        // In registration order
+        const std::vector<EntityProcessAccess> accesses = {
+            EntityProcessAccess(none, local),       // 0: writes local
+            EntityProcessAccess(local, none),       // 1: reads what 0 writes
+            EntityProcessAccess(none, global),      // 2: independent of 0 and 1
+            EntityProcessAccess(),                  // 3: undeclared
+            EntityProcessAccess(none, local),       // 4: writes local
+            EntityProcessAccess(none, local),       // 5: writes what 4 writes
+            EntityProcessAccess(mesh, none)         // 6: independent of 4 and 5
+        };
+
+        ProcessEventLog_ log;
+        log.threads.resize(accesses.size());
+
+        FrameGraph graph;
+        for (size_t i = 0; i < accesses.size(); ++i) {
+            AddEntityProcessJob(graph, EntityProcessPtr(new RecordingProcess_(i, log, accesses[i])), accesses[i]);
+        }
+        REQUIRE(graph.Size() == accesses.size());
+
+        const auto dependsOn = [&graph](const size_t job, const size_t dependency) {
+            const auto& deps = graph.JobDependencies(job);
+            return std::find(deps.begin(), deps.end(), dependency) != deps.end();
+        };
+
+        // Declared processes only wait on conflicting processes registered before them
+        REQUIRE(graph.JobDependencies(0).size() == 0);
+        REQUIRE(dependsOn(1, 0));
+        REQUIRE(graph.JobDependencies(2).size() == 0);
+        REQUIRE(dependsOn(5, 4));
+        REQUIRE_FALSE(dependsOn(6, 4));
+        REQUIRE_FALSE(dependsOn(6, 5));
+
+        // The undeclared process is ordered against everything
+        for (size_t before = 0; before < 3; ++before) REQUIRE(dependsOn(3, before));
+        for (size_t after = 4; after < accesses.size(); ++after) REQUIRE(dependsOn(after, 3));
+
+        // Run it a few times since the task threads are free to pick up jobs in any order
+        for (int frame = 0; frame < 5; ++frame) {
+            log.events.clear();
+            REQUIRE(graph.Execute(0.0) == SystemStatus::SYSTEM_CONTINUE);
+            REQUIRE(log.events.size() == 2 * accesses.size());
+
+            REQUIRE(log.FinishedBefore(0, 1));
+            for (size_t before = 0; before < 3; ++before) REQUIRE(log.FinishedBefore(before, 3));
+            for (size_t after = 4; after < accesses.size(); ++after) REQUIRE(log.FinishedBefore(3, after));
+            REQUIRE(log.FinishedBefore(4, 5));
+
+            // Undeclared access means the application thread
+            REQUIRE(log.threads[3] == std::this_thread::get_id());
+        }
+    });
+}
+
+// Reference for what TransformProcess should have computed
+static glm::mat4 ExpectedGlobalTransform_(const stratus::EntityPtr& e) {
+    const glm::mat4& local = stratus::GetComponent<stratus::LocalTransformComponent>(e)->GetLocalTransform();
+    const auto parent = e->GetParentNode();
+    return parent == nullptr ? local : ExpectedGlobalTransform_(parent) * local;
+}
+
+TEST_CASE( "Stratus Transform Process Parallel Update Test", "[stratus_transform_process_parallel_update_test]" ) {
+    std::cout << "Beginning stratus::TransformProcess parallel update test" << std::endl;
+
+    using namespace stratus;
+
+    RunWithTaskSystem_([&]() {
+        // 8 trees of root -> 4 children -> 80 leaves each. Every update below touches more than the
+        // 2048 rows TransformProcess needs before it splits the work across the task threads.
+        const size_t numRoots = 8;
+        const size_t numChildren = 4;
+        const size_t numLeaves = 80;
+
+        std::vector<EntityPtr> roots;
+        std::vector<EntityPtr> children;
+        std::vector<EntityPtr> all;
+        for (size_t r = 0; r < numRoots; ++r) {
+            auto root = CreateTransformEntity();
+            roots.push_back(root);
+            all.push_back(root);
+            for (size_t c = 0; c < numChildren; ++c) {
+                auto child = CreateTransformEntity();
+                root->AttachChildNode(child);
+                children.push_back(child);
+                all.push_back(child);
+                for (size_t l = 0; l < numLeaves; ++l) {
+                    auto leaf = CreateTransformEntity();
+                    child->AttachChildNode(leaf);
+                    all.push_back(leaf);
+                    GetComponent<LocalTransformComponent>(leaf)->SetLocalPosition(glm::vec3(float(l), 0.0f, 0.0f));
+                }
+            }
+        }
+        REQUIRE(all.size() >= 2048);
+
+        const auto validate = [&all]() {
+            for (const EntityPtr& e : all) {
+                const glm::mat4 expected = ExpectedGlobalTransform_(e);
+                const glm::mat4& actual = GetComponent<GlobalTransformComponent>(e)->GetGlobalTransform();
+                for (int col = 0; col < 4; ++col) {
+                    for (int row = 0; row < 4; ++row) {
+                        REQUIRE(std::fabs(actual[col][row] - expected[col][row]) < 1e-3f);
+                    }
+                }
+            }
+        };
+
+        // Owned through the base class the same way EntityManager::RegisterEntityProcess does
+        EntityProcessPtr process(static_cast<EntityProcess *>(new TransformProcess()));
+        process->EntitiesAdded(EntityList(all.data(), all.size()));
+
+        // First update covers every row
+        process->Process(0.0);
+        validate();
+
+        for (int frame = 0; frame < 3; ++frame) {
+            const float offset = float(frame + 1);
+
+            // Whole trees except for the last one (7 * 325 rows)
+            for (size_t r = 0; r + 1 < numRoots; ++r) {
+                GetComponent<LocalTransformComponent>(roots[r])->SetLocalPosition(glm::vec3(offset, float(r), 0.0f));
+            }
+            // A child inside of a tree which is already dirty is covered by its root
+            GetComponent<LocalTransformComponent>(children[1])->SetLocalScale(glm::vec3(offset));
+            // Part of the last tree: one of its subtrees and a single leaf of another. Its root and the
+            // rest of its subtrees stay as they were.
+            const size_t lastTree = (numRoots - 1) * numChildren;
+            GetComponent<LocalTransformComponent>(children[lastTree])->SetLocalRotation(
+                Rotation(Degrees(10.0f * offset), Degrees(0.0f), Degrees(0.0f)));
+            GetComponent<LocalTransformComponent>(children[lastTree + 2]->GetChildNodes()[5])->SetLocalPosition(glm::vec3(0.0f, offset, 0.0f));
+
+            process->Process(0.0);
+            validate();
+        }
+    });
+}
+
+TEST_CASE( "Stratus Transform Process Single Instance Test", "[stratus_transform_process_single_instance_test]" ) {
+    std::cout << "Beginning stratus::TransformProcess single instance test" << std::endl;
+
+    using namespace stratus;
+
+    auto parent = CreateTransformEntity();
+    auto child = CreateTransformEntity();
+    parent->AttachChildNode(child);
+    std::vector<EntityPtr> all = { parent, child };
+
+    // Changes made with no TransformProcess around are covered by the first update of the next one
+    GetComponent<LocalTransformComponent>(parent)->SetLocalPosition(glm::vec3(1.0f, 0.0f, 0.0f));
+
+    for (int round = 0; round < 2; ++round) {
+        EntityProcessPtr process(static_cast<EntityProcess *>(new TransformProcess()));
+        REQUIRE_THROWS(new TransformProcess());
+
+        process->EntitiesAdded(EntityList(all.data(), all.size()));
+        process->Process(0.0);
+        REQUIRE(GetComponent<GlobalTransformComponent>(child)->GetGlobalTransform() == ExpectedGlobalTransform_(child));
+
+        // Queued on this process and then either drained by it or thrown away with it
+        const float offset = float(round + 2);
+        GetComponent<LocalTransformComponent>(parent)->SetLocalPosition(glm::vec3(offset, 0.0f, 0.0f));
+        if (round == 0) {
+            process->Process(0.0);
+            REQUIRE(GetComponent<GlobalTransformComponent>(child)->GetGlobalTransform() == ExpectedGlobalTransform_(child));
+            // Left in the queue when the process is destroyed
+            GetComponent<LocalTransformComponent>(child)->SetLocalScale(glm::vec3(offset));
+        }
+    }
+}
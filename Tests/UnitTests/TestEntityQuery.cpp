@@ -0,0 +1,139 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+
+#include "StratusEntityQuery.h"
+#include "StratusTransformComponent.h"
+
+TEST_CASE( "Stratus Entity Query Test", "[stratus_entity_query_test]" ) {
+    std::cout << "Beginning stratus::EntityQuery test" << std::endl;
+
+    using namespace stratus;
+
+    typedef EntityQuery<LocalTransformComponent, GlobalTransformComponent> TransformQuery;
+
+    std::vector<EntityPtr> transforms;
+    for (size_t i = 0; i < 10; ++i) transforms.push_back(CreateTransformEntity());
+
+    auto localOnly = Entity::Create();
+    localOnly->Components().AttachComponent<LocalTransformComponent>();
+
+    auto disabled = CreateTransformEntity();
+    disabled->Components().DisableComponent<GlobalTransformComponent>();
+
+    REQUIRE(TransformQuery::Matches(transforms[0]));
+    REQUIRE_FALSE(TransformQuery::Matches(localOnly));
+    REQUIRE_FALSE(TransformQuery::Matches(disabled));
+
+    TransformQuery query;
+    for (auto& e : transforms) REQUIRE(query.Add(e));
+    REQUIRE_FALSE(query.Add(transforms[0]));
+    REQUIRE_FALSE(query.Add(localOnly));
+    REQUIRE_FALSE(query.Add(disabled));
+    REQUIRE_FALSE(query.Add(nullptr));
+    REQUIRE(query.Size() == transforms.size());
+
+    const auto validate = [&query]() {
+        const EntityPtr * entities = query.Entities();
+        auto locals = query.Column<LocalTransformComponent>();
+        auto globals = query.Column<GlobalTransformComponent>();
+        for (size_t row = 0; row < query.Size(); ++row) {
+            REQUIRE(query.RowOf(entities[row]) == row);
+            REQUIRE(locals[row] == GetComponent<LocalTransformComponent>(entities[row]));
+            REQUIRE(globals[row] == GetComponent<GlobalTransformComponent>(entities[row]));
+        }
+    };
+    validate();
+
+    // Removal swaps the last row into the hole
+    REQUIRE(query.Remove(transforms[2]));
+    REQUIRE_FALSE(query.Remove(transforms[2]));
+    REQUIRE_FALSE(query.Contains(transforms[2]));
+    REQUIRE(query.RowOf(transforms[2]) == TransformQuery::NullRow);
+    REQUIRE(query.Size() == transforms.size() - 1);
+    REQUIRE(query.Entities()[2] == transforms.back());
+    validate();
+
+    // Sorting keeps every column in sync
+    query.SortBy([](const EntityPtr& e) {
+        return -int64_t(e->GetHandle().Integer());
+    });
+    for (size_t row = 1; row < query.Size(); ++row) {
+        REQUIRE(query.Entities()[row - 1]->GetHandle().Integer() > query.Entities()[row]->GetHandle().Integer());
+    }
+    validate();
+
+    size_t visited = 0;
+    query.ForEach([&visited, &query](const EntityPtr& e, LocalTransformComponent * local, GlobalTransformComponent * global) {
+        REQUIRE(query.Entities()[visited] == e);
+        REQUIRE(local == GetComponent<LocalTransformComponent>(e));
+        REQUIRE(global == GetComponent<GlobalTransformComponent>(e));
+        ++visited;
+    });
+    REQUIRE(visited == query.Size());
+
+    // Refresh picks up enabled/disabled changes
+    transforms[0]->Components().DisableComponent<LocalTransformComponent>();
+    REQUIRE_FALSE(query.Refresh(transforms[0]));
+    REQUIRE_FALSE(query.Contains(transforms[0]));
+    disabled->Components().EnableComponent<GlobalTransformComponent>();
+    REQUIRE(query.Refresh(disabled));
+    REQUIRE(query.Contains(disabled));
+    validate();
+
+    query.Clear();
+    REQUIRE(query.Size() == 0);
+    REQUIRE_FALSE(query.Contains(disabled));
+}
+
+TEST_CASE( "Stratus Entity Component Id Test", "[stratus_entity_component_id_test]" ) {
+    std::cout << "Beginning stratus::EntityComponentId test" << std::endl;
+
+    using namespace stratus;
+
+    const EntityComponentId local = LocalTransformComponent::SComponentId();
+    const EntityComponentId global = GlobalTransformComponent::SComponentId();
+    const EntityComponentId mesh = MeshWorldTransforms::SComponentId();
+
+    // Stable, unique and dense
+    REQUIRE(local == LocalTransformComponent::SComponentId());
+    REQUIRE(local != global);
+    REQUIRE(local != mesh);
+    REQUIRE(global != mesh);
+    REQUIRE(local < MaxEntityComponentTypes);
+    REQUIRE(global < MaxEntityComponentTypes);
+    REQUIRE(mesh < MaxEntityComponentTypes);
+
+    auto e = CreateTransformEntity();
+    auto& components = e->Components();
+    REQUIRE(components.GetComponent<LocalTransformComponent>().component->ComponentId() == local);
+
+    REQUIRE(components.Signature().test(local));
+    REQUIRE(components.Signature().test(global));
+    REQUIRE_FALSE(components.Signature().test(mesh));
+    REQUIRE(components.Signature() == components.EnabledSignature());
+    REQUIRE_FALSE(components.ContainsComponent<MeshWorldTransforms>());
+    REQUIRE(components.GetComponent<MeshWorldTransforms>().component == nullptr);
+
+    components.AttachComponent<MeshWorldTransforms>();
+    REQUIRE(components.ContainsComponent<MeshWorldTransforms>());
+    REQUIRE(components.Signature().test(mesh));
+    REQUIRE(components.GetComponent<MeshWorldTransforms>().status == EntityComponentStatus::COMPONENT_ENABLED);
+
+    components.DisableComponent<GlobalTransformComponent>();
+    REQUIRE(components.Signature().test(global));
+    REQUIRE_FALSE(components.EnabledSignature().test(global));
+    REQUIRE(components.GetComponent<GlobalTransformComponent>().status == EntityComponentStatus::COMPONENT_DISABLED);
+    REQUIRE(components.GetComponent<GlobalTransformComponent>().component != nullptr);
+
+    // Lookup by name still works
+    auto byName = components.GetComponentByName(LocalTransformComponent::STypeName());
+    REQUIRE(byName.component == components.GetComponent<LocalTransformComponent>().component);
+    REQUIRE(components.GetComponentByName("NotAComponent").component == nullptr);
+    REQUIRE(components.GetAllComponents().size() == 3);
+
+    // Copies get their own components with the same signature
+    auto copy = e->Copy();
+    REQUIRE(copy->Components().Signature() == components.Signature());
+    REQUIRE(copy->Components().GetComponent<LocalTransformComponent>().component != components.GetComponent<LocalTransformComponent>().component);
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <unordered_set>
+
+#include "StratusEntity.h"
+#include "StratusEntitySet.h"
+#include "StratusEntityTable.h"
+
+TEST_CASE( "Stratus Entity Table Test", "[stratus_entity_table_test]" ) {
+    std::cout << "Beginning stratus::EntityTable test" << std::endl;
+
+    using namespace stratus;
+
+    auto& table = EntityTable::Instance();
+
+    REQUIRE_FALSE(EntityHandle::Null());
+    REQUIRE(table.Resolve(EntityHandle::Null()) == nullptr);
+    REQUIRE(table.Lock(EntityHandle::Null()) == nullptr);
+
+    std::vector<EntityPtr> entities;
+    std::unordered_set<EntityHandle> handles;
+    for (size_t i = 0; i < 100; ++i) {
+        entities.push_back(Entity::Create());
+        const EntityHandle handle = entities.back()->GetHandle();
+        REQUIRE(handle);
+        REQUIRE(handle.Index() < table.NumSlots());
+        handles.insert(handle);
+    }
+    REQUIRE(handles.size() == entities.size());
+
+    for (const auto& e : entities) {
+        REQUIRE(table.Resolve(e->GetHandle()) == e.get());
+        REQUIRE(table.Lock(e->GetHandle()) == e);
+    }
+
+    // Copies are new entities
+    auto copy = entities[0]->Copy();
+    REQUIRE(copy->GetHandle() != entities[0]->GetHandle());
+
+    // Destroyed entities no longer resolve even after their slot is reused
+    const EntityHandle stale = entities.back()->GetHandle();
+    entities.pop_back();
+    REQUIRE(table.Resolve(stale) == nullptr);
+
+    auto reused = Entity::Create();
+    REQUIRE(reused->GetHandle() != stale);
+    REQUIRE(table.Resolve(stale) == nullptr);
+    REQUIRE(table.Resolve(reused->GetHandle()) == reused.get());
+    if (reused->GetHandle().Index() == stale.Index()) {
+        REQUIRE(reused->GetHandle().Generation() != stale.Generation());
+    }
+
+    // Create, resolve and destroy from multiple threads at once
+    const size_t numThreads = 4;
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t) {
+        threads.push_back(std::thread([&]() {
+            for (size_t iteration = 0; iteration < 100; ++iteration) {
+                std::vector<EntityPtr> local;
+                for (size_t i = 0; i < 50; ++i) local.push_back(Entity::Create());
+                for (const auto& e : local) {
+                    if (table.Resolve(e->GetHandle()) != e.get()) failed = true;
+                }
+                // Everything created on the main thread is still alive
+                for (const auto& e : entities) {
+                    if (table.Resolve(e->GetHandle()) != e.get()) failed = true;
+                }
+                std::vector<EntityHandle> localHandles;
+                for (const auto& e : local) localHandles.push_back(e->GetHandle());
+                local.clear();
+                for (const auto& handle : localHandles) {
+                    if (table.Resolve(handle) != nullptr) failed = true;
+                }
+            }
+        }));
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE_FALSE(failed);
+}
+
+TEST_CASE( "Stratus Entity Table Concurrent Lock Test", "[stratus_entity_table_concurrent_lock_test]" ) {
+    std::cout << "Beginning stratus::EntityTable concurrent Lock test" << std::endl;
+
+    using namespace stratus;
+
+    // Lock races against the last reference being dropped. It must either hand back the same entity
+    // or nothing, never a destroyed or recycled one.
+    for (int round = 0; round < 200; ++round) {
+        EntityPtr e = Entity::Create();
+        const EntityHandle handle = e->GetHandle();
+
+        std::atomic<bool> go(false);
+        std::atomic<size_t> wrongEntity(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.push_back(std::thread([&]() {
+                while (!go.load()) std::this_thread::yield();
+                for (;;) {
+                    EntityPtr locked = EntityTable::Instance().Lock(handle);
+                    if (locked == nullptr) break;
+                    if (locked->GetHandle() != handle) ++wrongEntity;
+                }
+            }));
+        }
+
+        go.store(true);
+        std::this_thread::yield();
+        e.reset();
+        // Keep the slot busy so that any stale access would see a different entity
+        auto replacement = Entity::Create();
+
+        for (auto& thread : threads) thread.join();
+        REQUIRE(wrongEntity.load() == 0);
+        REQUIRE(EntityTable::Instance().Lock(handle) == nullptr);
+    }
+}
+
+TEST_CASE( "Stratus Entity Set Test", "[stratus_entity_set_test]" ) {
+    std::cout << "Beginning stratus::EntitySet test" << std::endl;
+
+    using namespace stratus;
+
+    std::vector<EntityPtr> entities;
+    for (size_t i = 0; i < 20; ++i) entities.push_back(Entity::Create());
+
+    EntitySet set;
+    REQUIRE(set.Empty());
+    for (const auto& e : entities) REQUIRE(set.Insert(e));
+    REQUIRE_FALSE(set.Insert(entities[0]));
+    REQUIRE_FALSE(set.Insert(nullptr));
+    REQUIRE(set.Size() == entities.size());
+    for (const auto& e : entities) {
+        REQUIRE(set.Contains(e));
+        REQUIRE(set.Contains(e->GetHandle()));
+    }
+
+    REQUIRE(set.Erase(entities[3]));
+    REQUIRE_FALSE(set.Erase(entities[3]));
+    REQUIRE_FALSE(set.Contains(entities[3]));
+    REQUIRE(set.Size() == entities.size() - 1);
+
+    // Every remaining entity shows up exactly once when iterating
+    std::unordered_set<Entity *> seen;
+    for (const auto& e : set) {
+        REQUIRE(e != entities[3]);
+        REQUIRE(seen.insert(e.get()).second);
+    }
+    REQUIRE(seen.size() == set.Size());
+
+    // A handle whose slot was reused by a different entity is not a member
+    const EntityHandle stale = entities[3]->GetHandle();
+    entities[3].reset();
+    auto other = Entity::Create();
+    REQUIRE(set.Insert(other));
+    REQUIRE_FALSE(set.Contains(stale));
+    REQUIRE(set.Contains(other));
+
+    set.Clear();
+    REQUIRE(set.Size() == 0);
+    REQUIRE_FALSE(set.Contains(entities[0]));
+    REQUIRE(set.Insert(entities[0]));
+}
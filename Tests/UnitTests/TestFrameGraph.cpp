@@ -0,0 +1,130 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "StratusFrameGraph.h"
+
+static bool ContainsDependency(const stratus::FrameGraph& graph, const size_t job, const size_t dependency) {
+    const auto& deps = graph.JobDependencies(job);
+    return std::find(deps.begin(), deps.end(), dependency) != deps.end();
+}
+
+TEST_CASE( "Stratus Frame Graph Dependencies Test", "[stratus_frame_graph_dependencies_test]" ) {
+    std::cout << "Beginning stratus::FrameGraph dependencies test" << std::endl;
+
+    using namespace stratus;
+
+    const auto any = FrameJobAffinity::ANY_THREAD;
+    const auto noop = [](const double) { return SystemStatus::SYSTEM_CONTINUE; };
+
+    FrameGraph graph;
+    const size_t writeA  = graph.AddJob("WriteA",  any, {},         {"A"},      noop);
+    const size_t writeB  = graph.AddJob("WriteB",  any, {},         {"B"},      noop);
+    const size_t readA1  = graph.AddJob("ReadA1",  any, {"A"},      {},         noop);
+    const size_t readA2  = graph.AddJob("ReadA2",  any, {"A"},      {"C"},      noop);
+    const size_t writeA2 = graph.AddJob("WriteA2", any, {"B"},      {"A"},      noop);
+    const size_t readAll = graph.AddJob("ReadAll", any, {"A", "B", "C"}, {},    noop);
+
+    REQUIRE(graph.Size() == 6);
+    REQUIRE(graph.JobName(readA2) == "ReadA2");
+
+    // Independent writers
+    REQUIRE(graph.JobDependencies(writeA).size() == 0);
+    REQUIRE(graph.JobDependencies(writeB).size() == 0);
+
+    // Read after write
+    REQUIRE(graph.JobDependencies(readA1).size() == 1);
+    REQUIRE(ContainsDependency(graph, readA1, writeA));
+    REQUIRE(graph.JobDependencies(readA2).size() == 1);
+    REQUIRE(ContainsDependency(graph, readA2, writeA));
+
+    // Write after write + write after read
+    REQUIRE(ContainsDependency(graph, writeA2, writeA));
+    REQUIRE(ContainsDependency(graph, writeA2, readA1));
+    REQUIRE(ContainsDependency(graph, writeA2, readA2));
+    REQUIRE(ContainsDependency(graph, writeA2, writeB));
+
+    // Only the most recent writer matters
+    REQUIRE(ContainsDependency(graph, readAll, writeA2));
+    REQUIRE_FALSE(ContainsDependency(graph, readAll, writeA));
+    REQUIRE(ContainsDependency(graph, readAll, writeB));
+    REQUIRE(ContainsDependency(graph, readAll, readA2));
+
+    // A job which reads and writes the same resource should not depend on itself
+    const size_t readWriteA = graph.AddJob("ReadWriteA", any, {"A"}, {"A"}, noop);
+    REQUIRE_FALSE(ContainsDependency(graph, readWriteA, readWriteA));
+    REQUIRE(ContainsDependency(graph, readWriteA, writeA2));
+    REQUIRE(ContainsDependency(graph, readWriteA, readAll));
+
+    graph.Clear();
+    REQUIRE(graph.Size() == 0);
+}
+
+TEST_CASE( "Stratus Frame Graph Execute Test", "[stratus_frame_graph_execute_test]" ) {
+    std::cout << "Beginning stratus::FrameGraph execute test" << std::endl;
+
+    using namespace stratus;
+
+    // Without a TaskSystem every job runs on the calling thread, which keeps this deterministic
+    const auto any = FrameJobAffinity::ANY_THREAD;
+    const auto app = FrameJobAffinity::APPLICATION_THREAD;
+
+    std::vector<std::string> order;
+    const auto record = [&order](const std::string& name) {
+        return [&order, name](const double) {
+            order.push_back(name);
+            return SystemStatus::SYSTEM_CONTINUE;
+        };
+    };
+
+    FrameGraph graph;
+    graph.AddJob("Audio",     any, {},                      {"Audio"},      record("Audio"));
+    graph.AddJob("Input",     app, {},                      {"Input"},      record("Input"));
+    graph.AddJob("Physics",   any, {"Input"},               {"Transforms"}, record("Physics"));
+    graph.AddJob("Render",    app, {"Transforms", "Audio"}, {"Frame"},      record("Render"));
+
+    const auto position = [&order](const std::string& name) {
+        return size_t(std::find(order.begin(), order.end(), name) - order.begin());
+    };
+
+    for (size_t frame = 0; frame < 3; ++frame) {
+        order.clear();
+        REQUIRE(graph.Execute(1.0 / 60.0) == SystemStatus::SYSTEM_CONTINUE);
+        REQUIRE(order.size() == 4);
+        REQUIRE(position("Input") < position("Physics"));
+        REQUIRE(position("Render") == 3);
+    }
+
+    // Any status other than continue stops jobs which have not started yet
+    FrameGraph stopping;
+    size_t count = 0;
+    stopping.AddJob("First", app, {}, {"A"}, [&count](const double) {
+        ++count;
+        return SystemStatus::SYSTEM_SHUTDOWN;
+    });
+    stopping.AddJob("Second", app, {"A"}, {}, [&count](const double) {
+        ++count;
+        return SystemStatus::SYSTEM_CONTINUE;
+    });
+    REQUIRE(stopping.Execute(0.0) == SystemStatus::SYSTEM_SHUTDOWN);
+    REQUIRE(count == 1);
+
+    // Exceptions make it back to the caller
+    FrameGraph throwing;
+    throwing.AddJob("Throw", any, {}, {"A"}, [](const double) -> SystemStatus {
+        throw std::runtime_error("FrameGraph exception");
+    });
+    throwing.AddJob("After", any, {"A"}, {}, [&count](const double) {
+        ++count;
+        return SystemStatus::SYSTEM_CONTINUE;
+    });
+    REQUIRE_THROWS_AS(throwing.Execute(0.0), std::runtime_error);
+    REQUIRE(count == 1);
+
+    // Graph can be executed again after a failure
+    count = 0;
+    REQUIRE(stopping.Execute(0.0) == SystemStatus::SYSTEM_SHUTDOWN);
+    REQUIRE(count == 1);
+}
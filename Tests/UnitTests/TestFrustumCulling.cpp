@@ -0,0 +1,168 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "StratusFrustumCulling.h"
+#include "StratusMath.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+// Slow reference: outside if all 8 corners are behind some plane. Returns -1 if any plane is too close
+// to a corner for float rounding to be ignored.
+static int ReferenceVisible_(const stratus::GpuAABB& aabb, const glm::vec4 * planes) {
+    const glm::dvec3 vmin = glm::dvec3(glm::vec3(aabb.vmin.ToVec4()));
+    const glm::dvec3 vmax = glm::dvec3(glm::vec3(aabb.vmax.ToVec4()));
+    bool visible = true;
+    for (int p = 0; p < 6; ++p) {
+        const glm::dvec4 g(planes[p]);
+        const double scale = glm::length(glm::dvec3(g));
+        bool allBehind = true;
+        for (int c = 0; c < 8; ++c) {
+            const glm::dvec3 corner((c & 1) ? vmax.x : vmin.x, (c & 2) ? vmax.y : vmin.y, (c & 4) ? vmax.z : vmin.z);
+            const double distance = glm::dot(glm::dvec3(g), corner) + g.w;
+            if (std::fabs(distance) < 1e-3 * scale) return -1;
+            allBehind = allBehind && distance < 0.0;
+        }
+        if (allBehind) visible = false;
+    }
+    return visible ? 1 : 0;
+}
+
+static stratus::GpuAABB RandomAabb_(std::mt19937& rng) {
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> size(0.1f, 20.0f);
+    const glm::vec3 center(position(rng), position(rng), position(rng));
+    const glm::vec3 extent(size(rng), size(rng), size(rng));
+    stratus::GpuAABB aabb;
+    aabb.vmin = glm::vec4(center - extent, 1.0f);
+    aabb.vmax = glm::vec4(center + extent, 1.0f);
+    return aabb;
+}
+
+static glm::mat4 RandomProjectionView_(std::mt19937& rng) {
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> fov(30.0f, 100.0f);
+    const glm::vec3 eye(position(rng), position(rng), position(rng));
+    const glm::vec3 target(position(rng), position(rng), position(rng));
+    const glm::mat4 projection = glm::perspective(glm::radians(fov(rng)), 16.0f / 9.0f, 0.5f, 250.0f);
+    return projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+TEST_CASE( "Stratus Frustum Culling Test", "[stratus_frustum_culling_test]" ) {
+    std::cout << "Beginning stratus::CullAabbs test (" << stratus::FrustumCullingKernelName() << ")" << std::endl;
+
+    using namespace stratus;
+
+    std::mt19937 rng(1234);
+
+    // Not a multiple of the SIMD width so the kernels have a partial register at the end
+    const size_t count = 1003;
+    std::vector<GpuAABB> boxes;
+    SoaAabbs soa;
+    soa.Resize(count);
+    REQUIRE(soa.Size() == count);
+    REQUIRE(soa.PaddedSize() % SoaAabbs::Width == 0);
+    for (size_t i = 0; i < count; ++i) {
+        boxes.push_back(RandomAabb_(rng));
+        soa.Set(i, boxes[i]);
+    }
+
+    std::vector<uint8_t> visible(count);
+    size_t numVisible = 0;
+    size_t numCulled = 0;
+    for (int frustum = 0; frustum < 20; ++frustum) {
+        glm::vec4 planes[6];
+        ExtractFrustumPlanes(RandomProjectionView_(rng), planes);
+
+        const size_t result = CullAabbs(soa, planes, visible.data());
+        size_t expectedCount = 0;
+        for (size_t i = 0; i < count; ++i) {
+            // Same arithmetic as the kernels so this has to match exactly
+            REQUIRE(visible[i] == (IsAabbInFrustum(boxes[i], planes) ? 1 : 0));
+            expectedCount += visible[i];
+
+            const int reference = ReferenceVisible_(boxes[i], planes);
+            if (reference < 0) continue;
+            REQUIRE(visible[i] == reference);
+            numVisible += reference;
+            numCulled += 1 - reference;
+        }
+        REQUIRE(result == expectedCount);
+    }
+    // Make sure the test actually exercised both outcomes
+    REQUIRE(numVisible > 0);
+    REQUIRE(numCulled > 0);
+
+    // Several frusta at once (e.g. CSM cascades) match culling one at a time
+    const size_t numFrusta = 4;
+    std::vector<glm::vec4> cascadePlanes(6 * numFrusta);
+    for (size_t k = 0; k < numFrusta; ++k) {
+        ExtractFrustumPlanes(RandomProjectionView_(rng), cascadePlanes.data() + 6 * k);
+    }
+    std::vector<uint8_t> masks(count, 0xFF);
+    CullAabbs(soa, cascadePlanes.data(), numFrusta, masks.data());
+    for (size_t k = 0; k < numFrusta; ++k) {
+        CullAabbs(soa, cascadePlanes.data() + 6 * k, visible.data());
+        for (size_t i = 0; i < count; ++i) {
+            REQUIRE(((masks[i] >> k) & 1) == visible[i]);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE((masks[i] >> numFrusta) == 0);
+    }
+    REQUIRE_THROWS(CullAabbs(soa, cascadePlanes.data(), 9, masks.data()));
+
+    // Shrinking clears the padding
+    soa.Resize(3);
+    REQUIRE(soa.PaddedSize() == SoaAabbs::Width);
+    for (size_t i = 3; i < soa.PaddedSize(); ++i) {
+        REQUIRE(soa.Centers(0)[i] == 0.0f);
+        REQUIRE(soa.Extents(2)[i] == 0.0f);
+    }
+    REQUIRE(glm::vec3(soa.Get(1).vmin.ToVec4()) == glm::vec3(boxes[1].vmin.ToVec4()));
+    REQUIRE(glm::vec3(soa.Get(1).vmax.ToVec4()) == glm::vec3(boxes[1].vmax.ToVec4()));
+
+    soa.Clear();
+    REQUIRE(soa.Size() == 0);
+    REQUIRE(CullAabbs(soa, cascadePlanes.data(), visible.data()) == 0);
+}
+
+TEST_CASE( "Stratus Transform Aabb Test", "[stratus_transform_aabb_test]" ) {
+    std::cout << "Beginning stratus::TransformAabb test" << std::endl;
+
+    using namespace stratus;
+
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+
+    for (int i = 0; i < 100; ++i) {
+        const GpuAABB local = RandomAabb_(rng);
+        const glm::vec3 axis = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)) + glm::vec3(0.01f));
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(dist(rng), dist(rng), dist(rng)));
+        m = glm::rotate(m, dist(rng), axis);
+        m = glm::scale(m, glm::vec3(0.5f) + glm::abs(glm::vec3(dist(rng), dist(rng), dist(rng))));
+
+        // Bounds of the 8 transformed corners
+        const glm::vec3 vmin = local.vmin.ToVec4();
+        const glm::vec3 vmax = local.vmax.ToVec4();
+        glm::vec3 expectedMin(std::numeric_limits<float>::max());
+        glm::vec3 expectedMax(std::numeric_limits<float>::lowest());
+        for (int c = 0; c < 8; ++c) {
+            const glm::vec3 corner((c & 1) ? vmax.x : vmin.x, (c & 2) ? vmax.y : vmin.y, (c & 4) ? vmax.z : vmin.z);
+            const glm::vec3 world = m * glm::vec4(corner, 1.0f);
+            expectedMin = glm::min(expectedMin, world);
+            expectedMax = glm::max(expectedMax, world);
+        }
+
+        const GpuAABB world = TransformAabb(local, AffineTransform(m));
+        const float tolerance = 1e-3f * (1.0f + glm::length(expectedMax - expectedMin));
+        REQUIRE(glm::length(glm::vec3(world.vmin.ToVec4()) - expectedMin) < tolerance);
+        REQUIRE(glm::length(glm::vec3(world.vmax.ToVec4()) - expectedMax) < tolerance);
+
+        SoaAabbs soa;
+        soa.Resize(1);
+        soa.Set(0, local, AffineTransform(m));
+        REQUIRE(glm::length(glm::vec3(soa.Get(0).vmin.ToVec4()) - expectedMin) < tolerance);
+    }
+}
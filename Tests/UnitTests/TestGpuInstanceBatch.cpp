@@ -0,0 +1,159 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <random>
+
+#include "StratusGpuInstanceBatch.h"
+
+// Meshes are only used as keys so any distinct pointer works
+static const stratus::Mesh * FakeMesh_(const uintptr_t id) {
+    return reinterpret_cast<const stratus::Mesh *>(id * 64);
+}
+
+// Checks that every instance shows up exactly once, inside the batch for its key
+static void ValidateBatches_(const stratus::GpuInstanceBatchList& list) {
+    using namespace stratus;
+    const auto& batches = list.Batches();
+    const auto& instances = list.Instances();
+    REQUIRE(instances.size() == list.NumInstances());
+
+    size_t expectedFirst = 0;
+    for (size_t b = 0; b < batches.size(); ++b) {
+        REQUIRE(batches[b].firstInstance == expectedFirst);
+        REQUIRE(batches[b].instanceCount > 0);
+        if (b > 0) REQUIRE(batches[b - 1].key < batches[b].key);
+        for (uint32_t i = 0; i < batches[b].instanceCount; ++i) {
+            const uint32_t instance = instances[batches[b].firstInstance + i];
+            REQUIRE(list.Contains(instance));
+            REQUIRE(list.GetKey(instance) == batches[b].key);
+            if (i > 0) REQUIRE(instances[batches[b].firstInstance + i - 1] < instance);
+        }
+        expectedFirst += batches[b].instanceCount;
+    }
+    REQUIRE(expectedFirst == instances.size());
+}
+
+TEST_CASE( "Stratus Gpu Instance Batch Test", "[stratus_gpu_instance_batch_test]" ) {
+    std::cout << "Beginning stratus::GpuInstanceBatchList test" << std::endl;
+
+    using namespace stratus;
+
+    GpuInstanceBatchList list;
+    REQUIRE_FALSE(list.Build());
+    REQUIRE(list.Batches().size() == 0);
+
+    // 10k copies of 3 different mesh + material pairs collapse into 3 batches
+    const GpuInstanceBatchKey keys[] = {
+        GpuInstanceBatchKey{FakeMesh_(1), 0},
+        GpuInstanceBatchKey{FakeMesh_(1), 1},
+        GpuInstanceBatchKey{FakeMesh_(2), 0},
+    };
+    const uint32_t numInstances = 10000;
+    for (uint32_t i = 0; i < numInstances; ++i) {
+        list.Insert(i, keys[i % 3]);
+    }
+    REQUIRE(list.Dirty());
+    REQUIRE(list.Build());
+    REQUIRE_FALSE(list.Dirty());
+    REQUIRE_FALSE(list.Build());
+    REQUIRE(list.Batches().size() == 3);
+    REQUIRE(list.Batches()[0].key == keys[0]);
+    REQUIRE(list.Batches()[0].instanceCount == 3334);
+    REQUIRE(list.Batches()[1].instanceCount == 3333);
+    REQUIRE(list.Batches()[2].instanceCount == 3333);
+    ValidateBatches_(list);
+
+    // Re-inserting with the same key is not a change
+    list.Insert(5, keys[5 % 3]);
+    REQUIRE_FALSE(list.Dirty());
+
+    // Changing material moves the instance to another batch
+    list.Insert(0, keys[2]);
+    REQUIRE(list.Build());
+    REQUIRE(list.Batches()[0].instanceCount == 3333);
+    REQUIRE(list.Batches()[2].instanceCount == 3334);
+    ValidateBatches_(list);
+
+    // Removing every instance of a key removes its batch
+    for (uint32_t i = 1; i < numInstances; i += 3) {
+        REQUIRE(list.Remove(i));
+    }
+    REQUIRE_FALSE(list.Remove(1));
+    REQUIRE_FALSE(list.Contains(1));
+    REQUIRE(list.Build());
+    REQUIRE(list.Batches().size() == 2);
+    ValidateBatches_(list);
+
+    list.MarkDirty();
+    REQUIRE(list.Build());
+
+    // Slots don't need to be dense
+    list.Insert(50000, GpuInstanceBatchKey{FakeMesh_(3), 7});
+    REQUIRE(list.Build());
+    REQUIRE(list.Batches().size() == 3);
+    REQUIRE(list.Instances()[list.Batches()[2].firstInstance] == 50000);
+    ValidateBatches_(list);
+
+    list.Clear();
+    REQUIRE(list.NumInstances() == 0);
+    REQUIRE(list.Build());
+    REQUIRE(list.Batches().size() == 0);
+    REQUIRE(list.Instances().size() == 0);
+}
+
+TEST_CASE( "Stratus Gpu Instance Batch Compaction Test", "[stratus_gpu_instance_batch_compaction_test]" ) {
+    std::cout << "Beginning stratus::GpuInstanceBatchList compaction test" << std::endl;
+
+    using namespace stratus;
+
+    std::mt19937 rng(42);
+    GpuInstanceBatchList list;
+    const uint32_t numSlots = 2000;
+    std::vector<uint8_t> visible(numSlots, 0);
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        // Leave holes in the slots like a GpuTypedBuffer would
+        if (rng() % 5 == 0) continue;
+        list.Insert(i, GpuInstanceBatchKey{FakeMesh_(1 + rng() % 4), uint32_t(rng() % 3)});
+        visible[i] = uint8_t(rng() % 2);
+    }
+    list.Build();
+    ValidateBatches_(list);
+
+    std::vector<GpuInstanceBatch> batches;
+    std::vector<uint32_t> instances;
+    list.Compact(visible.data(), batches, instances);
+
+    // Expected result computed the slow way
+    std::map<GpuInstanceBatchKey, std::vector<uint32_t>> expected;
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        if (list.Contains(i) && visible[i]) expected[list.GetKey(i)].push_back(i);
+    }
+
+    REQUIRE(batches.size() == expected.size());
+    size_t b = 0;
+    size_t total = 0;
+    for (const auto& [key, visibleInstances] : expected) {
+        REQUIRE(batches[b].key == key);
+        REQUIRE(batches[b].firstInstance == total);
+        REQUIRE(batches[b].instanceCount == visibleInstances.size());
+        for (size_t i = 0; i < visibleInstances.size(); ++i) {
+            REQUIRE(instances[batches[b].firstInstance + i] == visibleInstances[i]);
+        }
+        total += visibleInstances.size();
+        ++b;
+    }
+    REQUIRE(instances.size() == total);
+
+    // Nothing visible
+    std::fill(visible.begin(), visible.end(), 0);
+    list.Compact(visible.data(), batches, instances);
+    REQUIRE(batches.size() == 0);
+    REQUIRE(instances.size() == 0);
+
+    // Everything visible matches the full batches
+    std::fill(visible.begin(), visible.end(), 1);
+    list.Compact(visible.data(), batches, instances);
+    REQUIRE(batches.size() == list.Batches().size());
+    REQUIRE(instances == list.Instances());
+}
@@ -0,0 +1,135 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <array>
+
+#include "StratusMpscQueue.h"
+#include "StratusUniqueFunction.h"
+#include "StratusThread.h"
+
+struct MpscNode {
+    size_t producer;
+    size_t value;
+    MpscNode * next = nullptr;
+};
+
+TEST_CASE( "Stratus MPSC Queue Test", "[stratus_mpsc_queue_test]" ) {
+    std::cout << "Beginning stratus::MpscQueue test" << std::endl;
+
+    stratus::MpscQueue<MpscNode> queue;
+    REQUIRE(queue.Empty());
+    REQUIRE(queue.PopAll() == nullptr);
+
+    constexpr size_t numProducers = 8;
+    constexpr size_t numPerProducer = 10000;
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < numProducers; ++p) {
+        producers.push_back(std::thread([&queue, p]() {
+            for (size_t i = 0; i < numPerProducer; ++i) {
+                queue.Push(new MpscNode{p, i});
+            }
+        }));
+    }
+
+    // Consume while producers are still running and make sure each producer's
+    // elements come out in the order they were pushed
+    std::vector<size_t> nextExpected(numProducers, 0);
+    size_t received = 0;
+    while (received < numProducers * numPerProducer) {
+        MpscNode * node = queue.PopAll();
+        while (node != nullptr) {
+            REQUIRE(node->value == nextExpected[node->producer]);
+            ++nextExpected[node->producer];
+            ++received;
+            MpscNode * next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    for (auto& producer : producers) producer.join();
+    REQUIRE(queue.Empty());
+
+    // PushMany expects the list to be linked newest to oldest
+    MpscNode a{0, 0}, b{0, 1}, c{0, 2};
+    c.next = &b;
+    b.next = &a;
+    queue.PushMany(&c, &a);
+    MpscNode * node = queue.PopAll();
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(node != nullptr);
+        REQUIRE(node->value == i);
+        node = node->next;
+    }
+    REQUIRE(node == nullptr);
+}
+
+TEST_CASE( "Stratus Unique Function Test", "[stratus_unique_function_test]" ) {
+    std::cout << "Beginning stratus::UniqueFunction test" << std::endl;
+
+    typedef stratus::UniqueFunction<size_t(size_t)> Function;
+
+    Function empty;
+    REQUIRE_FALSE(empty);
+    REQUIRE_THROWS_AS(empty(0), std::bad_function_call);
+
+    // Small captures are stored inline
+    size_t offset = 5;
+    auto small = [offset](size_t value) { return value + offset; };
+    REQUIRE(Function::StoresInline<decltype(small)>());
+    Function f1(small);
+    REQUIRE(f1(10) == 15);
+
+    // Large captures end up on the heap
+    std::array<size_t, 32> values;
+    values.fill(2);
+    auto large = [values](size_t value) { return value * values[31]; };
+    REQUIRE_FALSE(Function::StoresInline<decltype(large)>());
+    Function f2(large);
+    REQUIRE(f2(10) == 20);
+
+    // Move-only captures are supported
+    auto ptr = std::make_unique<size_t>(7);
+    Function f3([ptr = std::move(ptr)](size_t value) { return value + *ptr; });
+    REQUIRE(f3(1) == 8);
+
+    // Moving transfers ownership for both inline and heap storage
+    Function moved1(std::move(f1));
+    Function moved2(std::move(f2));
+    REQUIRE_FALSE(f1);
+    REQUIRE_FALSE(f2);
+    REQUIRE(moved1(0) == 5);
+    REQUIRE(moved2(1) == 2);
+
+    moved1 = std::move(f3);
+    REQUIRE_FALSE(f3);
+    REQUIRE(moved1(2) == 9);
+
+    // Make sure destructors run exactly once
+    auto shared = std::make_shared<size_t>(0);
+    {
+        Function f4([shared](size_t value) { return value + *shared; });
+        REQUIRE(shared.use_count() == 2);
+        Function f5(std::move(f4));
+        REQUIRE(shared.use_count() == 2);
+    }
+    REQUIRE(shared.use_count() == 1);
+}
+
+TEST_CASE( "Stratus Thread Move Only Queue Test", "[stratus_thread_move_only_queue_test]" ) {
+    std::cout << "Beginning stratus::Thread move only queue test" << std::endl;
+
+    stratus::Thread thread("MoveOnly", true);
+
+    size_t sum = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        auto value = std::make_unique<size_t>(i);
+        thread.Queue([value = std::move(value), &sum]() { sum += *value; });
+    }
+
+    thread.DispatchAndSynchronize();
+    REQUIRE(sum == 4950);
+}
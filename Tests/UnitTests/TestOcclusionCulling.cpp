@@ -0,0 +1,194 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+
+#include "StratusOcclusionCulling.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+static stratus::GpuAABB MakeAabb_(const glm::vec3& center, const glm::vec3& halfSize) {
+    stratus::GpuAABB aabb;
+    aabb.vmin = glm::vec4(center - halfSize, 1.0f);
+    aabb.vmax = glm::vec4(center + halfSize, 1.0f);
+    return aabb;
+}
+
+// Square in the xy plane at the given z, drawn as two triangles
+static void AddQuad_(stratus::OcclusionBuffer& buffer, const float halfSize, const float z, const bool flipWinding) {
+    const std::vector<glm::vec3> vertices = {
+        glm::vec3(-halfSize, -halfSize, z),
+        glm::vec3( halfSize, -halfSize, z),
+        glm::vec3( halfSize,  halfSize, z),
+        glm::vec3(-halfSize,  halfSize, z)
+    };
+    const std::vector<uint32_t> indices = flipWinding ?
+        std::vector<uint32_t>{ 0, 2, 1, 0, 3, 2 } :
+        std::vector<uint32_t>{ 0, 1, 2, 0, 2, 3 };
+    buffer.AddOccluder(vertices.data(), vertices.size(), indices.data(), indices.size(), glm::mat4(1.0f));
+}
+
+TEST_CASE( "Stratus Occlusion Culling Test", "[stratus_occlusion_culling_test]" ) {
+    std::cout << "Beginning stratus::OcclusionBuffer test (" << stratus::OcclusionCullingKernelName() << ")" << std::endl;
+
+    using namespace stratus;
+
+    // Rounded up to whole tiles
+    OcclusionBuffer buffer(100, 50);
+    REQUIRE(buffer.Width() == 128);
+    REQUIRE(buffer.Height() == 56);
+    REQUIRE(buffer.LevelWidth(buffer.NumLevels() - 1) == 1);
+    REQUIRE(buffer.LevelHeight(buffer.NumLevels() - 1) == 1);
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), float(buffer.Width()) / float(buffer.Height()), 0.5f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    const GpuAABB behind = MakeAabb_(glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(1.0f));
+    const GpuAABB inFront = MakeAabb_(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(1.0f));
+    const GpuAABB beside = MakeAabb_(glm::vec3(12.0f, 0.0f, -5.0f), glm::vec3(1.0f));
+    // Behind the edge of the quad but sticking out past it
+    const GpuAABB straddling = MakeAabb_(glm::vec3(7.5f, 0.0f, -5.0f), glm::vec3(1.0f));
+    const GpuAABB crossesNear = MakeAabb_(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(1.0f));
+
+    // Nothing drawn means nothing is occluded
+    buffer.Begin(projection * view);
+    buffer.Finish();
+    REQUIRE(buffer.NumTriangles() == 0);
+    REQUIRE_FALSE(buffer.IsAabbOccluded(behind));
+
+    for (const bool flipWinding : { false, true }) {
+        buffer.Begin(projection * view);
+        AddQuad_(buffer, 5.0f, 0.0f, flipWinding);
+        buffer.Finish();
+        REQUIRE(buffer.NumTriangles() == 2);
+
+        REQUIRE(buffer.IsAabbOccluded(behind));
+        REQUIRE_FALSE(buffer.IsAabbOccluded(inFront));
+        REQUIRE_FALSE(buffer.IsAabbOccluded(beside));
+        REQUIRE_FALSE(buffer.IsAabbOccluded(straddling));
+        REQUIRE_FALSE(buffer.IsAabbOccluded(crossesNear));
+    }
+
+    // Batched version skips boxes which are already culled
+    SoaAabbs soa;
+    soa.Resize(5);
+    soa.Set(0, behind);
+    soa.Set(1, inFront);
+    soa.Set(2, beside);
+    soa.Set(3, straddling);
+    soa.Set(4, behind);
+    std::vector<uint8_t> visible = { 1, 1, 0, 1, 1 };
+    REQUIRE(buffer.CullOccluded(soa, visible.data()) == 2);
+    REQUIRE(visible == std::vector<uint8_t>{ 0, 1, 0, 1, 0 });
+
+    const uint32_t badIndices[3] = { 0, 1, 7 };
+    const glm::vec3 vertices[3] = { glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(2.0f) };
+    REQUIRE_THROWS(buffer.AddOccluder(vertices, 3, badIndices, 3, glm::mat4(1.0f)));
+}
+
+TEST_CASE( "Stratus Occlusion Near Plane Test", "[stratus_occlusion_near_plane_test]" ) {
+    std::cout << "Beginning stratus::OcclusionBuffer near plane test" << std::endl;
+
+    using namespace stratus;
+
+    // Standing on a large floor which extends behind the camera, so every triangle has to be clipped
+    OcclusionBuffer buffer(128, 64);
+    const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 2.0f, 0.5f, 200.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    buffer.Begin(projection * view);
+
+    const std::vector<glm::vec3> floor = {
+        glm::vec3(-1.0f, 0.0f, -1.0f),
+        glm::vec3( 1.0f, 0.0f, -1.0f),
+        glm::vec3( 1.0f, 0.0f,  1.0f),
+        glm::vec3(-1.0f, 0.0f,  1.0f)
+    };
+    const std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+    buffer.AddOccluder(floor.data(), floor.size(), indices.data(), indices.size(), glm::scale(glm::mat4(1.0f), glm::vec3(100.0f)));
+    buffer.Finish();
+    REQUIRE(buffer.NumTriangles() > 2);
+
+    REQUIRE(buffer.IsAabbOccluded(MakeAabb_(glm::vec3(0.0f, -3.0f, -15.0f), glm::vec3(1.0f))));
+    REQUIRE(buffer.IsAabbOccluded(MakeAabb_(glm::vec3(-5.0f, -5.0f, -12.0f), glm::vec3(1.0f))));
+    REQUIRE_FALSE(buffer.IsAabbOccluded(MakeAabb_(glm::vec3(0.0f, 1.5f, -15.0f), glm::vec3(1.0f))));
+    REQUIRE_FALSE(buffer.IsAabbOccluded(MakeAabb_(glm::vec3(0.0f, 0.0f, -15.0f), glm::vec3(1.0f))));
+}
+
+TEST_CASE( "Stratus Occlusion Rasterizer Test", "[stratus_occlusion_rasterizer_test]" ) {
+    std::cout << "Beginning stratus::OcclusionBuffer rasterizer test" << std::endl;
+
+    using namespace stratus;
+
+    // Identity projection so vertices are given directly in clip space
+    OcclusionBuffer buffer(96, 40);
+    const uint32_t width = buffer.Width();
+    const uint32_t height = buffer.Height();
+    buffer.Begin(glm::mat4(1.0f));
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-1.5f, 1.5f);
+    std::uniform_real_distribution<float> depth(-1.0f, 1.0f);
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    for (uint32_t i = 0; i < 3 * 60; ++i) {
+        vertices.push_back(glm::vec3(position(rng), position(rng), depth(rng)));
+        indices.push_back(i);
+    }
+    buffer.AddOccluder(vertices.data(), vertices.size(), indices.data(), indices.size(), glm::mat4(1.0f));
+    buffer.Finish();
+
+    // Slow reference which tests every pixel center against every triangle in double precision. Pixels
+    // too close to an edge for float rounding to be ignored are skipped.
+    size_t numCovered = 0;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const double px = (double(x) + 0.5) / double(width) * 2.0 - 1.0;
+            const double py = (double(y) + 0.5) / double(height) * 2.0 - 1.0;
+            double expected = 1.0;
+            bool ambiguous = false;
+            for (size_t t = 0; t < indices.size(); t += 3) {
+                const glm::dvec3 v[3] = { glm::dvec3(vertices[t]), glm::dvec3(vertices[t + 1]), glm::dvec3(vertices[t + 2]) };
+                const double area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+                if (area == 0.0) continue;
+
+                double weights[3];
+                bool inside = true;
+                for (int k = 0; k < 3; ++k) {
+                    const glm::dvec3& a = v[(k + 1) % 3];
+                    const glm::dvec3& b = v[(k + 2) % 3];
+                    const double edge = ((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x)) / area;
+                    // Distance from the edge in pixels
+                    const double pixels = std::fabs(edge * area) / glm::length(glm::dvec2(b - a)) * 0.5 * double(std::min(width, height));
+                    if (pixels < 1e-3) ambiguous = true;
+                    weights[k] = edge;
+                    inside = inside && edge >= 0.0;
+                }
+                if (!inside) continue;
+
+                const double z = weights[0] * v[0].z + weights[1] * v[1].z + weights[2] * v[2].z;
+                expected = std::min(expected, z * 0.5 + 0.5);
+            }
+            if (ambiguous) continue;
+
+            REQUIRE(std::fabs(double(buffer.Depth()[y * width + x]) - expected) < 1e-4);
+            numCovered += expected < 1.0 ? 1 : 0;
+        }
+    }
+    REQUIRE(numCovered > 0);
+
+    // Every HiZ texel is the furthest depth of the pixels it covers
+    for (size_t level = 1; level < buffer.NumLevels(); ++level) {
+        const uint32_t levelWidth = buffer.LevelWidth(level);
+        for (uint32_t ty = 0; ty < buffer.LevelHeight(level); ++ty) {
+            for (uint32_t tx = 0; tx < levelWidth; ++tx) {
+                float furthest = 0.0f;
+                for (uint32_t y = ty << level; y < std::min(height, (ty + 1) << level); ++y) {
+                    for (uint32_t x = tx << level; x < std::min(width, (tx + 1) << level); ++x) {
+                        furthest = std::max(furthest, buffer.Depth()[y * width + x]);
+                    }
+                }
+                REQUIRE(buffer.Depth(level)[ty * levelWidth + tx] == furthest);
+            }
+        }
+    }
+}
@@ -197,4 +197,87 @@ static void ThreadSafePoolAllocatorTest() {
 TEST_CASE( "Stratus Pool Allocators Test", "[stratus_pool_allocators_test]" ) {
     PoolAllocatorTest();
     ThreadSafePoolAllocatorTest();
-}
\ No newline at end of file
+}
+TEST_CASE( "Stratus Thread Cached Pool Allocator Test", "[stratus_thread_cached_pool_allocator_test]" ) {
+    std::cout << "ThreadCachedPoolAllocatorTest" << std::endl;
+
+    static std::atomic<int64_t> destroyed;
+    destroyed.store(0);
+
+    struct alignas(32) S {
+        int64_t value;
+        S(int64_t value) : value(value) {}
+        ~S() { destroyed += 1; }
+    };
+    typedef stratus::ThreadCachedPoolAllocator<S> Allocator;
+
+    REQUIRE(Allocator::BytesPerElem % alignof(S) == 0);
+
+    S * first = Allocator::AllocateConstruct(int64_t(25));
+    REQUIRE(first->value == 25);
+    REQUIRE(reinterpret_cast<uintptr_t>(first) % alignof(S) == 0);
+    Allocator::DestroyDeallocate(first);
+    REQUIRE(destroyed.load() == 1);
+    destroyed.store(0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    constexpr int64_t numThreads = 8;
+    constexpr int64_t count = 200000;
+    std::vector<std::vector<S *>> allocated(numThreads);
+    std::vector<std::thread> threads;
+
+    // Every thread allocates from its own cache
+    for (int64_t th = 0; th < numThreads; ++th) {
+        threads.push_back(std::thread([&allocated, th]() {
+            auto& ptrs = allocated[th];
+            ptrs.reserve(count);
+            for (int64_t i = 0; i < count; ++i) {
+                ptrs.push_back(Allocator::AllocateConstruct(i));
+            }
+        }));
+    }
+    for (auto& th : threads) th.join();
+    threads.clear();
+
+    std::unordered_set<S *> unique;
+    for (const auto& ptrs : allocated) {
+        for (int64_t i = 0; i < count; ++i) {
+            REQUIRE(ptrs[i]->value == i);
+            unique.insert(ptrs[i]);
+        }
+    }
+    REQUIRE(unique.size() == size_t(numThreads * count));
+
+    // Memory is freed by a different thread than the one that allocated it, while also
+    // allocating and freeing more elements
+    std::atomic<bool> failed(false);
+    for (int64_t th = 0; th < numThreads; ++th) {
+        threads.push_back(std::thread([&allocated, &failed, th]() {
+            for (S * ptr : allocated[(th + 1) % numThreads]) {
+                Allocator::DestroyDeallocate(ptr);
+            }
+            for (int64_t i = 0; i < count; ++i) {
+                S * ptr = Allocator::AllocateConstruct(i);
+                if (ptr->value != i) failed = true;
+                Allocator::DestroyDeallocate(ptr);
+            }
+        }));
+    }
+    for (auto& th : threads) th.join();
+
+    REQUIRE_FALSE(failed.load());
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    REQUIRE(destroyed.load() == 2 * numThreads * count);
+    // Memory freed by the exited threads is reused rather than allocating new chunks
+    const size_t chunks = Allocator::NumChunks();
+    std::vector<S *> ptrs;
+    for (int64_t i = 0; i < numThreads * count; ++i) ptrs.push_back(Allocator::AllocateConstruct(i));
+    REQUIRE(Allocator::NumChunks() == chunks);
+    for (S * ptr : ptrs) Allocator::DestroyDeallocate(ptr);
+
+    std::cout << "Elapsed MS: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << std::endl;
+    std::cout << Allocator::NumChunks() << ", " << Allocator::NumElems() << std::endl;
+}
@@ -101,4 +101,40 @@ TEST_CASE( "Stratus Stack Allocators Test", "[stratus_stack_allocators_test]" )
 
 		std::cout << allocator->Remaining() << std::endl;
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Stratus Stack Allocator Scope Test", "[stratus_stack_allocator_scope_test]" ) {
+	std::cout << "Beginning stratus::StackAllocatorScope tests" << std::endl;
+
+	auto allocator = stratus::MakeUnsafe<stratus::StackAllocator>(1024);
+
+	// Aligned allocations skip ahead to the next multiple of the alignment
+	allocator->Allocate(1);
+	void * aligned = allocator->Allocate(sizeof(double), alignof(double));
+	REQUIRE(reinterpret_cast<uintptr_t>(aligned) % alignof(double) == 0);
+	REQUIRE(allocator->Remaining() <= 1024 - 1 - sizeof(double));
+
+	const size_t remaining = allocator->Remaining();
+	{
+		stratus::StackAllocatorScope outer(allocator);
+		allocator->Allocate(100);
+		const size_t afterOuter = allocator->Remaining();
+		{
+			stratus::StackAllocatorScope inner(allocator);
+			auto vec = std::vector<int, stratus::StackBasedPoolAllocator<int>>(stratus::StackBasedPoolAllocator<int>(allocator));
+			vec.reserve(64);
+			REQUIRE(allocator->Remaining() < afterOuter);
+		}
+		// Only what was allocated inside of the inner scope is released
+		REQUIRE(allocator->Remaining() == afterOuter);
+	}
+	REQUIRE(allocator->Remaining() == remaining);
+
+	// An allocation which doesn't fit leaves the allocator untouched
+	const size_t marker = allocator->Mark();
+	REQUIRE_THROWS_AS(allocator->Allocate(4096), std::bad_alloc);
+	REQUIRE(allocator->Mark() == marker);
+	REQUIRE_THROWS_AS(allocator->Allocate(remaining + 1, 64), std::bad_alloc);
+	REQUIRE(allocator->Mark() == marker);
+	REQUIRE(allocator->Remaining() == remaining);
+}
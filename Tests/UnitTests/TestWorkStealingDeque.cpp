@@ -0,0 +1,126 @@
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "StratusWorkStealingDeque.h"
+#include "StratusEventCount.h"
+
+TEST_CASE( "Stratus Work Stealing Deque Single Thread", "[stratus_work_stealing_deque_single_thread]" ) {
+    std::cout << "Beginning stratus::WorkStealingDeque single thread test" << std::endl;
+
+    // Start small to force the deque to grow
+    stratus::WorkStealingDeque<size_t> deque(4);
+    REQUIRE(deque.Empty());
+
+    size_t value = 0;
+    REQUIRE_FALSE(deque.Pop(value));
+    REQUIRE_FALSE(deque.Steal(value));
+
+    constexpr size_t count = 1000;
+    for (size_t i = 0; i < count; ++i) {
+        deque.Push(i);
+    }
+    REQUIRE(deque.Size() == count);
+
+    // Owner pops from the bottom in LIFO order
+    for (size_t i = 0; i < count / 2; ++i) {
+        REQUIRE(deque.Pop(value));
+        REQUIRE(value == count - i - 1);
+    }
+
+    // Thieves steal from the top in FIFO order
+    for (size_t i = 0; i < count / 2; ++i) {
+        REQUIRE(deque.Steal(value));
+        REQUIRE(value == i);
+    }
+
+    REQUIRE(deque.Empty());
+    REQUIRE_FALSE(deque.Pop(value));
+}
+
+TEST_CASE( "Stratus Work Stealing Deque Multi Thread", "[stratus_work_stealing_deque_multi_thread]" ) {
+    std::cout << "Beginning stratus::WorkStealingDeque multi thread test" << std::endl;
+
+    stratus::WorkStealingDeque<size_t> deque(16);
+    const size_t numThieves = std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1;
+    constexpr size_t count = 200000;
+
+    // Every element must be seen exactly once
+    std::vector<std::atomic<int>> seen(count);
+    for (auto& s : seen) s.store(0);
+    std::atomic<size_t> total(0);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> thieves;
+    for (size_t i = 0; i < numThieves; ++i) {
+        thieves.push_back(std::thread([&]() {
+            size_t value;
+            while (!done.load() || !deque.Empty()) {
+                if (deque.Steal(value)) {
+                    seen[value].fetch_add(1);
+                    total.fetch_add(1);
+                }
+            }
+        }));
+    }
+
+    size_t value;
+    for (size_t i = 0; i < count; ++i) {
+        deque.Push(i);
+        // Mix in some owner pops to create races over the last element
+        if (i % 3 == 0 && deque.Pop(value)) {
+            seen[value].fetch_add(1);
+            total.fetch_add(1);
+        }
+    }
+
+    while (deque.Pop(value)) {
+        seen[value].fetch_add(1);
+        total.fetch_add(1);
+    }
+
+    done.store(true);
+    for (auto& th : thieves) th.join();
+
+    REQUIRE(total.load() == count);
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(seen[i].load() == 1);
+    }
+}
+
+TEST_CASE( "Stratus Event Count", "[stratus_event_count]" ) {
+    std::cout << "Beginning stratus::EventCount test" << std::endl;
+
+    stratus::EventCount ec;
+    std::atomic<int> work(0);
+    std::atomic<int> consumed(0);
+    constexpr int count = 10000;
+
+    std::thread consumer([&]() {
+        while (consumed.load() < count) {
+            if (work.load() > 0) {
+                work.fetch_sub(1);
+                consumed.fetch_add(1);
+                continue;
+            }
+
+            auto key = ec.PrepareWait();
+            if (work.load() > 0) {
+                ec.CancelWait();
+                continue;
+            }
+            ec.Wait(key);
+        }
+    });
+
+    for (int i = 0; i < count; ++i) {
+        work.fetch_add(1);
+        ec.NotifyOne();
+    }
+
+    consumer.join();
+    REQUIRE(consumed.load() == count);
+    REQUIRE(work.load() == 0);
+}
@@ -60,6 +60,33 @@ TEST_CASE( "Stratus Thread Test", "[stratus_thread_test]" ) {
     REQUIRE(named.Name() == "ThreadNameTest");
 }
 
+TEST_CASE( "Stratus Thread Wait Test", "[stratus_thread_wait_test]" ) {
+    std::cout << "Beginning stratus::Thread wait test" << std::endl;
+
+    // Run the same workload with pure blocking and with a spin phase
+    for (size_t spinCount : {size_t(0), size_t(10000)}) {
+        stratus::Thread thread(true);
+        thread.SetSpinCount(spinCount);
+        REQUIRE(thread.GetSpinCount() == spinCount);
+
+        std::atomic<int> counter(0);
+        const int numDispatches = 1000;
+        for (int i = 0; i < numDispatches; ++i) {
+            thread.Queue([&counter]() { counter.fetch_add(1); });
+            thread.DispatchAndSynchronize();
+            // Synchronize must not return until the previous dispatch finished
+            REQUIRE(counter.load() == i + 1);
+            REQUIRE(thread.Idle() == true);
+        }
+
+        // Make sure a thread that has been sleeping for a while still wakes up
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        thread.Queue([&counter]() { counter.fetch_add(1); });
+        thread.DispatchAndSynchronize();
+        REQUIRE(counter.load() == numDispatches + 1);
+    }
+}
+
 TEST_CASE( "Stratus Async Test", "[stratus_async_test]" ) {
     std::cout << "Beginning stratus::Async test" << std::endl;
 
@@ -153,4 +180,118 @@ TEST_CASE( "Stratus Async Test", "[stratus_async_test]" ) {
     REQUIRE(called.load() == true);
     REQUIRE(computeVoid.Completed() == true);
     REQUIRE(computeVoid.Failed() == false);
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Stratus Async Continuation Test", "[stratus_async_continuation_test]" ) {
+    std::cout << "Beginning stratus::Async continuation test" << std::endl;
+
+    stratus::Thread thread("Compute", true);
+    stratus::Thread uploadThread("Upload", true);
+
+    // Stages are chained without anyone polling for completion
+    stratus::Async<int> decode(thread, []() { return new int(10); });
+    stratus::Async<int> mip = decode.Then([&thread](stratus::Async<int> as) {
+        // Runs directly on whichever thread completed the previous stage
+        REQUIRE(stratus::Thread::Current() == thread);
+        return new int(as.Get() * 2);
+    });
+    std::atomic<int> uploaded(0);
+    stratus::Async<void> upload = mip.Then(uploadThread, [&uploadThread, &uploaded](stratus::Async<int> as) {
+        REQUIRE(stratus::Thread::Current() == uploadThread);
+        uploaded.store(as.Get());
+    });
+
+    REQUIRE_FALSE(mip.Completed());
+    thread.DispatchAndSynchronize();
+    REQUIRE(mip.CompleteAndValid());
+    REQUIRE(mip.Get() == 20);
+
+    // Upload stage was queued onto its context thread
+    REQUIRE_FALSE(upload.Completed());
+    uploadThread.DispatchAndSynchronize();
+    REQUIRE(upload.CompleteAndValid());
+    REQUIRE(uploaded.load() == 20);
+
+    // Continuations on completed asyncs run immediately and still run on failure
+    stratus::Async<int> failed(nullptr);
+    bool sawFailure = false;
+    auto afterFailure = failed.Then([&sawFailure](stratus::Async<int> as) {
+        sawFailure = as.Failed();
+        return std::make_shared<int>(1);
+    });
+    REQUIRE(sawFailure);
+    REQUIRE(afterFailure.CompleteAndValid());
+
+    // Exceptions in a continuation fail the resulting async
+    auto throws = decode.Then([](stratus::Async<int>) -> int * {
+        throw std::runtime_error("Continuation failure");
+    });
+    REQUIRE(throws.CompleteAndInvalid());
+    REQUIRE(throws.ExceptionMessage() == "Continuation failure");
+
+    // WhenAll/WhenAny
+    std::vector<stratus::Async<int>> group;
+    for (int i = 0; i < 8; ++i) {
+        group.push_back(stratus::Async<int>(thread, [i]() { return new int(i); }));
+    }
+
+    auto all = stratus::WhenAll(group);
+    auto any = stratus::WhenAny(group);
+    REQUIRE_FALSE(all.Completed());
+    REQUIRE_FALSE(any.Completed());
+
+    thread.DispatchAndSynchronize();
+    REQUIRE(all.CompleteAndValid());
+    REQUIRE(all.Get().size() == group.size());
+    for (const auto& as : all.Get()) {
+        REQUIRE(as.CompleteAndValid());
+    }
+    // Thread runs functions in order so the first should win
+    REQUIRE(any.CompleteAndValid());
+    REQUIRE(any.Get() == 0);
+
+    REQUIRE(stratus::WhenAll(std::vector<stratus::Async<int>>()).CompleteAndValid());
+    REQUIRE(stratus::WhenAny(std::vector<stratus::Async<int>>()).CompleteAndInvalid());
+}
+
+TEST_CASE( "Stratus Async Concurrent Continuation Test", "[stratus_async_concurrent_continuation_test]" ) {
+    std::cout << "Beginning stratus::Async concurrent continuation test" << std::endl;
+
+    // Continuations added while the Async is completing on another thread must each run exactly once
+    constexpr size_t numIterations = 100;
+    constexpr size_t numAdders = 4;
+    constexpr size_t numPerAdder = 100;
+
+    stratus::Thread thread("Compute", true);
+    for (size_t iteration = 0; iteration < numIterations; ++iteration) {
+        std::atomic<size_t> count(0);
+        stratus::Async<int> as(thread, []() { return new int(1); });
+        thread.Dispatch();
+
+        std::vector<std::thread> adders;
+        for (size_t i = 0; i < numAdders; ++i) {
+            adders.push_back(std::thread([&as, &count]() {
+                for (size_t j = 0; j < numPerAdder; ++j) {
+                    as.Then([&count](stratus::Async<int>) { count.fetch_add(1); });
+                }
+            }));
+        }
+
+        for (auto& adder : adders) adder.join();
+        thread.Synchronize();
+
+        REQUIRE(as.CompleteAndValid());
+        REQUIRE(count.load() == numAdders * numPerAdder);
+    }
+
+    // Callbacks are delivered for failed asyncs too, even when added after the failure
+    stratus::Async<int> failed(nullptr);
+    stratus::Thread callbackThread("Callback", true);
+    bool called = false;
+    callbackThread.Queue([&failed, &called]() {
+        failed.AddCallback([&called](stratus::Async<int> as) { called = as.Failed(); });
+    });
+    callbackThread.DispatchAndSynchronize();
+    callbackThread.DispatchAndSynchronize();
+    REQUIRE(called);
+}